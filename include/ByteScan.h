@@ -0,0 +1,24 @@
+#ifndef BYTESCAN_H
+#define BYTESCAN_H
+
+#include <string_view>
+
+namespace ByteScan{
+
+enum class EImplementation{Scalar, SSE2, AVX2};
+
+// At most this many distinct bytes can be searched for at once
+constexpr std::size_t MaxNeedles = 8;
+
+// Returns the index of the first byte of data that equals any byte of needles,
+// or data.size() if there is none. Uses the widest vector unit of the CPU.
+std::size_t FindAny(std::string_view data, std::string_view needles) noexcept;
+// Same as above with a specific implementation, falling back to the next
+// narrower one when the CPU does not support it
+std::size_t FindAny(std::string_view data, std::string_view needles, EImplementation impl) noexcept;
+
+EImplementation BestImplementation() noexcept;
+
+}
+
+#endif
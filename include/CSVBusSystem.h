@@ -10,8 +10,17 @@ class CCSVBusSystem : public CBusSystem{
         std::unique_ptr< SImplementation > DImplementation;
     public:
         CCSVBusSystem(std::shared_ptr< CDSVReader > stopsrc, std::shared_ptr< CDSVReader > routesrc);
+        // Loads whole stop and route files, splitting large ones at row
+        // boundaries and parsing the pieces on up to threads threads (0, or
+        // more than there are cores, uses every core). The result is the same
+        // as the reader based constructor.
+        CCSVBusSystem(std::shared_ptr< CDataSource > stopsrc, std::shared_ptr< CDataSource > routesrc, char delimiter = ',', std::size_t threads = 0);
         ~CCSVBusSystem();
 
+        // Describes the first problem that stopped loading (with its row
+        // number, the header being row 1), empty if everything loaded
+        std::string LoadError() const noexcept;
+
         std::size_t StopCount() const noexcept override;
         std::size_t RouteCount() const noexcept override;
         std::shared_ptr<SStop> StopByIndex(std::size_t index) const noexcept override;
@@ -0,0 +1,28 @@
+#ifndef CACHINGDATAFACTORY_H
+#define CACHINGDATAFACTORY_H
+
+#include "FileDataFactory.h"
+#include <mutex>
+#include <unordered_map>
+
+// File factory that maps each file once and hands every CreateSource caller
+// an independent cursor over the same immutable bytes. Creating a sink for a
+// cached name replaces the file and drops it from the cache; sources that
+// were already handed out keep reading the old contents.
+class CCachingDataFactory : public CFileDataFactory{
+    private:
+        std::mutex DMutex;
+        std::unordered_map< std::string, std::shared_ptr< const CMappedFile > > DFiles;
+
+        std::shared_ptr< const CMappedFile > MapFile(const std::string &name) noexcept override;
+
+    public:
+        CCachingDataFactory(const std::string &path);
+
+        std::shared_ptr< CDataSink > CreateSink(const std::string &name) noexcept override;
+
+        std::size_t CachedCount() noexcept;
+        void Clear() noexcept;
+};
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef CONCATENATEDDATASOURCE_H
+#define CONCATENATEDDATASOURCE_H
+
+#include "DataSource.h"
+#include <memory>
+#include <vector>
+
+// Presents an ordered list of sources as one logical stream. With skipheaders
+// the first line of every source after the first non-empty one is dropped, so
+// per-agency CSV files can be read as one table. With joinlines a newline is
+// inserted between sources when the previous one did not end with one.
+class CConcatenatedDataSource : public CDataSource{
+    private:
+        std::vector< std::shared_ptr< CDataSource > > DSources;
+        // Exhausted sources are skipped lazily at the start of each call, so a
+        // borrowed span stays valid until the next call as End() may release it
+        mutable std::size_t DCurrent;
+        mutable bool DPendingNewLine;
+        bool DSkipHeaders;
+        bool DJoinLines;
+        bool DEmitted;
+        char DLastChar;
+
+        void Advance() const noexcept;
+        void Settle() const noexcept;
+        void Emitted(char ch) noexcept;
+    public:
+        CConcatenatedDataSource(std::vector< std::shared_ptr< CDataSource > > sources, bool skipheaders = false, bool joinlines = false);
+
+        // True if any source read so far failed
+        bool Failed() const noexcept override;
+
+        bool End() const noexcept override;
+        bool Get(char &ch) noexcept override;
+        bool Peek(char &ch) noexcept override;
+        bool Read(std::vector<char> &buf, std::size_t count) noexcept override;
+        std::size_t ReadSpan(std::span<char> buf) noexcept override;
+        bool Borrow(std::span<const char> &span, std::size_t count) noexcept override;
+};
+
+#endif
@@ -0,0 +1,70 @@
+#ifndef DSVCOLUMNREADER_H
+#define DSVCOLUMNREADER_H
+
+#include "DSVReader.h"
+#include <cstdint>
+#include <limits>
+
+namespace DSVFields{
+
+// Whole-value parsers built on std::from_chars. Surrounding spaces, tabs and
+// carriage returns are ignored, anything else must be part of the number.
+bool ParseUInt64(std::string_view text, uint64_t &value) noexcept;
+bool ParseInt64(std::string_view text, int64_t &value) noexcept;
+bool ParseDouble(std::string_view text, double &value) noexcept;
+
+}
+
+// Decodes a list of unsigned integers embedded in one value, such as the
+// path column of buspaths.csv, one entry at a time without splitting it.
+class CIntegerListDecoder{
+    private:
+        std::string_view DText;
+        char DSeparator;
+        std::size_t DOffset;
+        bool DFailed;
+    public:
+        CIntegerListDecoder(std::string_view text, char separator = ',');
+
+        // Returns false at the end of the list or at a malformed entry
+        bool Next(uint64_t &value) noexcept;
+        bool Failed() const noexcept;
+};
+
+// Reads a DSV source that starts with a header row. Header names are bound to
+// column indexes once, then values of each row are pulled out by index as
+// views or numbers without allocating strings or throwing.
+class CDSVColumnReader{
+    private:
+        std::shared_ptr< CDSVReader > DReader;
+        std::vector< std::string > DHeader;
+        std::vector< std::string_view > DRow;
+        std::size_t DRowCount;
+        bool DHeaderValid;
+    public:
+        inline static constexpr std::size_t InvalidColumn = std::numeric_limits<std::size_t>::max();
+
+        // Reads the header row immediately
+        CDSVColumnReader(std::shared_ptr< CDSVReader > reader);
+        // For a reader over part of a file whose header was read elsewhere
+        CDSVColumnReader(std::shared_ptr< CDSVReader > reader, std::vector< std::string > header);
+
+        bool HeaderValid() const noexcept;
+        const std::vector< std::string > &Header() const noexcept;
+        // Index of the named column or InvalidColumn
+        std::size_t Column(std::string_view name) const noexcept;
+
+        // Moves to the next data row, whose values stay valid until the next call
+        bool NextRow();
+        // Number of data rows read so far, the header is not counted
+        std::size_t RowCount() const noexcept;
+        std::size_t ValueCount() const noexcept;
+        bool HasValue(std::size_t column) const noexcept;
+        // Empty when the row has no such column
+        std::string_view Value(std::size_t column) const noexcept;
+        bool GetUInt64(std::size_t column, uint64_t &value) const noexcept;
+        bool GetInt64(std::size_t column, int64_t &value) const noexcept;
+        bool GetDouble(std::size_t column, double &value) const noexcept;
+};
+
+#endif
@@ -1,21 +1,58 @@
 #ifndef DSVREADER_H
 #define DSVREADER_H
 
+#include <limits>
 #include <memory>
 #include <string>
+#include <string_view>
+#include <vector>
 #include "DataSource.h"
 
+// Reads delimiter separated values. The source is consumed in large blocks,
+// so it should not be shared with other readers.
 class CDSVReader{
     private:
         struct SImplementation;
         std::unique_ptr<SImplementation> DImplementation;
 
     public:
-        CDSVReader(std::shared_ptr< CDataSource > src, char delimiter);
+        // What happens to a row holding a value longer than the maximum field
+        // length: the value is cut short, the row is skipped, or reading stops
+        enum class EFieldOverflow{Truncate, SkipRow, Fail};
+        inline static constexpr std::size_t UnlimitedFieldLength = std::numeric_limits<std::size_t>::max();
+
+        // Start of the next row, as bytes from where the source stood when the
+        // reader was created and the number of rows read before it
+        struct SPosition{
+            std::size_t DOffset;
+            std::size_t DRow;
+        };
+
+        CDSVReader(std::shared_ptr< CDataSource > src, char delimiter, std::size_t maxfieldlength = UnlimitedFieldLength, EFieldOverflow overflow = EFieldOverflow::Truncate);
         ~CDSVReader();
 
+        // Also true once a row has failed the Fail overflow policy
         bool End() const;
+        // True once a row has failed the Fail overflow policy, a Seek clears it
+        bool Failed() const;
+        SPosition Position() const;
+        // Resumes reading at a position returned by Position, possibly from
+        // another reader over the same data. Offsets in the block already read
+        // need nothing from the source, others use CDataSource::Seek offset by
+        // where the source stood when this reader was created, and a source
+        // that cannot seek or Tell is read forward. Returns false if the
+        // position could not be reached.
+        bool Seek(const SPosition &position);
+        // Skipped rows count towards Position().DRow
         bool ReadRow(std::vector<std::string> &row);
+        // Same as ReadRow but the values view the reader's buffers and stay
+        // valid only until the next call on the reader
+        bool ReadRowView(std::vector<std::string_view> &row);
+
+        // Splits data into at most count consecutive pieces that each end just
+        // after a row ending newline (one outside of quotes), so every piece
+        // can be parsed by its own reader with the same result
+        static std::vector< std::string_view > SplitRows(std::string_view data, std::size_t count);
 };
 
 #endif
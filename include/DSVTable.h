@@ -0,0 +1,63 @@
+#ifndef DSVTABLE_H
+#define DSVTABLE_H
+
+#include "DSVReader.h"
+#include <cstdint>
+#include <limits>
+#include <span>
+
+// Loads a DSV source that starts with a header row into memory column by
+// column. Each column is typed from its values: whole numbers become an array
+// of int64_t, other numbers an array of double, and anything else an array of
+// IDs into a dictionary holding each distinct string once.
+class CDSVTable{
+    private:
+        struct SImplementation;
+        std::unique_ptr< SImplementation > DImplementation;
+
+    public:
+        enum class EColumnType{Integer, Double, String};
+        using TStringID = uint32_t;
+
+        inline static constexpr std::size_t InvalidColumn = std::numeric_limits<std::size_t>::max();
+        inline static constexpr TStringID InvalidStringID = std::numeric_limits<TStringID>::max();
+
+        // Reads all of reader. Columns named in stringcolumns are kept as
+        // strings even if every value is a number, for names such as "010"
+        // whose text matters.
+        CDSVTable(std::shared_ptr< CDSVReader > reader, const std::vector< std::string > &stringcolumns = {});
+        ~CDSVTable();
+
+        bool HeaderValid() const noexcept;
+        const std::vector< std::string > &Header() const noexcept;
+        std::size_t ColumnCount() const noexcept;
+        // Number of data rows, the header is not counted
+        std::size_t RowCount() const noexcept;
+        // Index of the first column with that name or InvalidColumn
+        std::size_t Column(std::string_view name) const noexcept;
+        EColumnType ColumnType(std::size_t column) const noexcept;
+
+        // False for values that are empty or missing from a short row
+        bool HasValue(std::size_t column, std::size_t row) const noexcept;
+
+        // Whole columns, one entry per row (0 or "" where there is no value).
+        // A span is empty unless the column has that type.
+        std::span< const int64_t > Integers(std::size_t column) const noexcept;
+        std::span< const double > Doubles(std::size_t column) const noexcept;
+        std::span< const TStringID > StringIDs(std::size_t column) const noexcept;
+
+        // Dictionary of a string column, IDs are handed out in order of first appearance
+        std::size_t StringCount(std::size_t column) const noexcept;
+        std::string_view StringByID(std::size_t column, TStringID id) const noexcept;
+        TStringID FindString(std::size_t column, std::string_view value) const noexcept;
+
+        // Single values. Strings only come from string columns, GetDouble
+        // also reads integer columns and all of the getters parse the text of
+        // string columns like DSVFields does.
+        std::string_view String(std::size_t column, std::size_t row) const noexcept;
+        bool GetUInt64(std::size_t column, std::size_t row, uint64_t &value) const noexcept;
+        bool GetInt64(std::size_t column, std::size_t row, int64_t &value) const noexcept;
+        bool GetDouble(std::size_t column, std::size_t row, double &value) const noexcept;
+};
+
+#endif
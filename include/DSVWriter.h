@@ -2,7 +2,10 @@
 #define DSVWRITER_H
 
 #include <memory>
+#include <span>
 #include <string>
+#include <string_view>
+#include <vector>
 #include "DataSink.h"
 
 class CDSVWriter{
@@ -11,10 +14,18 @@ class CDSVWriter{
         std::unique_ptr<SImplementation> DImplementation;
 
     public:
-        CDSVWriter(std::shared_ptr< CDataSink > sink, char delimiter, bool quoteall = false);
+        // With a batchsize of 0 every row reaches the sink as soon as it is
+        // written. Otherwise rows collect in the writer until about batchsize
+        // bytes are pending and are then handed over in a single Write; Flush
+        // or destroying the writer hands over the remainder.
+        CDSVWriter(std::shared_ptr< CDataSink > sink, char delimiter, bool quoteall = false, std::size_t batchsize = 0);
         ~CDSVWriter();
 
         bool WriteRow(const std::vector<std::string> &row);
+        bool WriteRowView(std::span<const std::string_view> row);
+        // Writes all rows with a single Write to the sink
+        bool WriteRows(const std::vector< std::vector<std::string> > &rows);
+        bool Flush();
 };
 
 #endif
@@ -1,6 +1,8 @@
 #ifndef DATASINK_H
 #define DATASINK_H
 
+#include <span>
+#include <string_view>
 #include <vector>
 
 class CDataSink{
@@ -8,6 +10,19 @@ class CDataSink{
         virtual ~CDataSink(){};
         virtual bool Put(const char &ch) noexcept = 0;
         virtual bool Write(const std::vector<char> &buf) noexcept = 0;
+        // Writes buf in one call. The default copies into a vector for Write,
+        // concrete sinks override to write straight from the caller's memory.
+        virtual bool WriteSpan(std::span<const char> buf) noexcept{
+            return Write(std::vector<char>(buf.begin(), buf.end()));
+        };
+        bool WriteString(std::string_view str) noexcept{
+            return WriteSpan(std::span<const char>(str.data(), str.size()));
+        };
+        // Pushes anything the sink is holding on to out to its destination.
+        // Unbuffered sinks have nothing to do.
+        virtual bool Flush() noexcept{
+            return true;
+        };
 };
 
 #endif
@@ -1,15 +1,87 @@
 #ifndef DATASOURCE_H
 #define DATASOURCE_H
 
+#include <algorithm>
+#include <cstring>
+#include <span>
+#include <string>
+#include <string_view>
 #include <vector>
 
 class CDataSource{
+    protected:
+        // ReadLine for sources that hold all of their data contiguously:
+        // takes the line starting at index in data and moves index past it
+        static bool ReadLineFrom(std::string_view data, std::size_t &index, std::string &line) noexcept{
+            if(index >= data.size()){
+                return false;
+            }
+            const char *Start = data.data() + index;
+            std::size_t Remaining = data.size() - index;
+            const char *NewLine = static_cast<const char *>(std::memchr(Start, '\n', Remaining));
+            std::size_t Length = NewLine ? NewLine - Start : Remaining;
+            line.assign(Start, Length);
+            index += NewLine ? Length + 1 : Length;
+            return true;
+        };
+
     public:
         virtual ~CDataSource(){};
         virtual bool End() const noexcept = 0;
         virtual bool Get(char &ch) noexcept = 0;
         virtual bool Peek(char &ch) noexcept = 0;
         virtual bool Read(std::vector<char> &buf, std::size_t count) noexcept = 0;
+        // Fills as much of buf as possible and returns the number of bytes read.
+        // The default goes through Read, concrete sources override with a memcpy.
+        virtual std::size_t ReadSpan(std::span<char> buf) noexcept{
+            std::vector<char> Temp;
+            if(buf.empty() || !Read(Temp, buf.size())){
+                return 0;
+            }
+            std::copy(Temp.begin(), Temp.end(), buf.begin());
+            return Temp.size();
+        };
+        // Lends up to count contiguous bytes and advances past them without copying.
+        // The view stays valid until the next call on the source other than End().
+        // Sources that do not keep their data contiguous return false and callers
+        // fall back to Read.
+        virtual bool Borrow(std::span<const char> &/*span*/, std::size_t /*count*/) noexcept{
+            return false;
+        };
+        // Replaces line with everything up to the next '\n', which is consumed but
+        // not stored. Returns false only if the source was already exhausted, so a
+        // final line without a terminator is still returned.
+        virtual bool ReadLine(std::string &line) noexcept{
+            char Ch;
+            line.clear();
+            if(!Get(Ch)){
+                return false;
+            }
+            while(Ch != '\n'){
+                line.push_back(Ch);
+                if(!Get(Ch)){
+                    break;
+                }
+            }
+            return true;
+        };
+        // True once the source stopped early because its data turned out to
+        // be corrupt or truncated, as opposed to reaching the real end. Plain
+        // sources cannot fail this way.
+        virtual bool Failed() const noexcept{
+            return false;
+        };
+        // Moves to offset bytes from the start of the source. Returns false,
+        // leaving the position alone, for sources that can only be read in
+        // order or if offset is past the end.
+        virtual bool Seek(std::size_t /*offset*/) noexcept{
+            return false;
+        };
+        // Sets offset to the current position in the same terms Seek takes.
+        // Returns false for sources that cannot seek.
+        virtual bool Tell(std::size_t &/*offset*/) const noexcept{
+            return false;
+        };
 };
 
 #endif
@@ -0,0 +1,49 @@
+#ifndef DATASTATISTICS_H
+#define DATASTATISTICS_H
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+// Counters collected by the instrumented source and sink decorators. Bulk
+// calls (ReadSpan, Borrow, WriteSpan) are counted with Read and Write.
+struct SDataStatistics{
+    uint64_t DGetCalls = 0;
+    uint64_t DPeekCalls = 0;
+    uint64_t DReadCalls = 0;
+    uint64_t DPutCalls = 0;
+    uint64_t DWriteCalls = 0;
+    uint64_t DFlushCalls = 0;
+    uint64_t DBytes = 0;
+    std::chrono::nanoseconds DDuration = std::chrono::nanoseconds::zero();
+
+    uint64_t Calls() const{
+        return DGetCalls + DPeekCalls + DReadCalls + DPutCalls + DWriteCalls + DFlushCalls;
+    };
+
+    std::string ToString() const{
+        auto Microseconds = std::chrono::duration_cast<std::chrono::microseconds>(DDuration).count();
+        return std::string("get=") + std::to_string(DGetCalls) +
+            " peek=" + std::to_string(DPeekCalls) +
+            " read=" + std::to_string(DReadCalls) +
+            " put=" + std::to_string(DPutCalls) +
+            " write=" + std::to_string(DWriteCalls) +
+            " flush=" + std::to_string(DFlushCalls) +
+            " bytes=" + std::to_string(DBytes) +
+            " time=" + std::to_string(Microseconds / 1000) + "." + std::to_string(Microseconds % 1000 / 100) + "ms";
+    };
+};
+
+// Adds its own lifetime to the duration of the statistics it was given
+class CDataStatisticsTimer{
+    private:
+        SDataStatistics &DStatistics;
+        std::chrono::steady_clock::time_point DStart;
+    public:
+        CDataStatisticsTimer(SDataStatistics &stats) : DStatistics(stats), DStart(std::chrono::steady_clock::now()){};
+        ~CDataStatisticsTimer(){
+            DStatistics.DDuration += std::chrono::steady_clock::now() - DStart;
+        };
+};
+
+#endif
@@ -2,16 +2,33 @@
 #define FILEDATAFACTORY_H
 
 #include "DataFactory.h"
+#include "MappedFile.h"
+#include <vector>
 
 class CFileDataFactory : public CDataFactory{
-    private:
+    protected:
         std::string DBasePath;
 
+        // Maps name relative to the base path, overridden to share mappings
+        virtual std::shared_ptr< const CMappedFile > MapFile(const std::string &name) noexcept;
+        // Creates a cursor over file, decompressing it on the fly when it
+        // holds gzip data
+        static std::shared_ptr< CDataSource > CreateFileSource(const std::string &name, std::shared_ptr< const CMappedFile > file) noexcept;
+
     public:
         CFileDataFactory(const std::string &path);
-;
+
         std::shared_ptr< CDataSource > CreateSource(const std::string &name) noexcept override;
         std::shared_ptr< CDataSink > CreateSink(const std::string &name) noexcept override;
+
+        // Reads the named files one after another as a single stream, see
+        // CConcatenatedDataSource for the meaning of skipheaders
+        std::shared_ptr< CDataSource > CreateConcatenatedSource(const std::vector< std::string > &names, bool skipheaders = false) noexcept;
+        // Splits name into at most count sources over consecutive byte ranges
+        // that each end just after a newline, so every shard starts on a new
+        // record. Records with quoted embedded newlines may be split. Empty
+        // shards are dropped and compressed files come back as a single source.
+        std::vector< std::shared_ptr< CDataSource > > CreateShardedSources(const std::string &name, std::size_t count) noexcept;
 };
 
 #endif
@@ -2,16 +2,38 @@
 #define FILEDATASINK_H
 
 #include "DataSink.h"
-#include <fstream>
+#include <string>
 
+// Buffered sink writing to a file. A failed open or write is remembered, so
+// Failed() reports it even when the return value of the call was dropped. The
+// destructor writes out whatever is still buffered but has nowhere to report
+// an error, so callers that care should Flush() and check it first.
 class CFileDataSink : public CDataSink{
     private:
-        std::ofstream DFile;
+        int DHandle;
+        bool DFailed;
+        std::vector<char> DBuffer;
+        std::size_t DLength;
+
+        bool WriteDirect(std::span<const char> first, std::span<const char> second) noexcept;
     public:
-        CFileDataSink(const std::string &filename);
+        inline static constexpr std::size_t DefaultBufferSize = 65536;
+        // Truncate rewrites an existing file in place, keeping its inode,
+        // links and permissions. Replace writes a new file and renames it
+        // over the old one, so sources that still map the old file keep
+        // reading its contents instead of faulting.
+        enum class EOpenMode{Truncate, Replace};
+
+        CFileDataSink(const std::string &filename, std::size_t buffersize = DefaultBufferSize, EOpenMode mode = EOpenMode::Truncate);
+        CFileDataSink(const CFileDataSink &) = delete;
+        CFileDataSink &operator=(const CFileDataSink &) = delete;
+        ~CFileDataSink();
 
         bool Put(const char &ch) noexcept override;
         bool Write(const std::vector<char> &buf) noexcept override;
+        bool WriteSpan(std::span<const char> buf) noexcept override;
+        bool Flush() noexcept override;
+        bool Failed() const noexcept;
 };
 
 #endif
@@ -2,18 +2,36 @@
 #define FILEDATASOURCE_H
 
 #include "DataSource.h"
-#include <fstream>
+#include "MappedFile.h"
+#include <memory>
+#include <string>
 
+// Reads a file through a shared read-only mapping. The file must not be
+// truncated while it is mapped, or the next read faults with SIGBUS. Rewrite
+// it with a CFileDataSink in Replace mode, as CCachingDataFactory does, to
+// leave sources opened before on the old contents.
 class CFileDataSource : public CDataSource{
     private:
-        std::ifstream DFile;
+        std::shared_ptr< const CMappedFile > DFile;
+        const char *DData;
+        std::size_t DSize;
+        std::size_t DIndex;
     public:
         CFileDataSource(const std::string &filename);
+        // Independent cursor over contents that may be shared with other sources
+        CFileDataSource(std::shared_ptr< const CMappedFile > file);
+        // Cursor over length bytes starting at offset, clamped to the file
+        CFileDataSource(std::shared_ptr< const CMappedFile > file, std::size_t offset, std::size_t length);
 
         bool End() const noexcept override;
         bool Get(char &ch) noexcept override;
         bool Peek(char &ch) noexcept override;
         bool Read(std::vector<char> &buf, std::size_t count) noexcept override;
+        std::size_t ReadSpan(std::span<char> buf) noexcept override;
+        bool Borrow(std::span<const char> &span, std::size_t count) noexcept override;
+        bool ReadLine(std::string &line) noexcept override;
+        bool Seek(std::size_t offset) noexcept override;
+        bool Tell(std::size_t &offset) const noexcept override;
 };
 
 #endif
@@ -0,0 +1,84 @@
+#ifndef FLATIDINDEX_H
+#define FLATIDINDEX_H
+
+#include <bit>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+// Immutable map from sparse 64 bit IDs to their positions, built once all
+// IDs are known. IDs and positions sit in two flat arrays forming an open
+// addressed hash table with linear probing, at most half full, so a lookup
+// is usually a single cache line read with no per-entry allocations. Lookups
+// only need the two arrays, so they can also run over arrays stored
+// elsewhere.
+class CFlatIDIndex{
+    private:
+        // Fibonacci hashing, the top bits of the product pick the slot. OSM
+        // IDs come in runs, which the multiply spreads across the table. A
+        // single slot would need a shift by 64, which is undefined.
+        static std::size_t HomeSlot(uint64_t id, std::size_t slots) noexcept{
+            if(slots < 2){
+                return 0;
+            }
+            return static_cast<std::size_t>((id * 0x9E3779B97F4A7C15ULL) >> (64 - std::countr_zero(slots)));
+        };
+
+        std::vector< uint64_t > DIDs;
+        // InvalidPosition marks an empty slot
+        std::vector< uint32_t > DPositions;
+        std::size_t DSize = 0;
+
+    public:
+        inline static constexpr uint32_t InvalidPosition = std::numeric_limits<uint32_t>::max();
+        // slots for unused entries hold this ID, so usually only the ID array
+        // is read to tell a miss from a collision
+        inline static constexpr uint64_t EmptyID = std::numeric_limits<uint64_t>::max();
+
+        CFlatIDIndex() = default;
+        // ids must not repeat; each maps to its position in ids
+        explicit CFlatIDIndex(std::span< const uint64_t > ids);
+
+        std::size_t Size() const noexcept;
+        // InvalidPosition if id is not in the index
+        uint32_t Find(uint64_t id) const noexcept{
+            return Find(DIDs,DPositions,id);
+        };
+
+        std::span< const uint64_t > IDs() const noexcept{
+            return DIDs;
+        };
+
+        std::span< const uint32_t > Positions() const noexcept{
+            return DPositions;
+        };
+
+        // Whether arrays read from elsewhere are safe to Find over for count
+        // elements: a power of two of at least 2 slots, every position below count and
+        // at least one empty slot so that every probe stops
+        static bool Valid(std::span< const uint64_t > ids, std::span< const uint32_t > positions, std::size_t count) noexcept;
+
+        // Find over arrays laid out as IDs() and Positions(), inline since it
+        // sits on the hot path of every lookup by ID
+        static uint32_t Find(std::span< const uint64_t > ids, std::span< const uint32_t > positions, uint64_t id) noexcept{
+            if(ids.empty()){
+                return InvalidPosition;
+            }
+            std::size_t Mask = ids.size() - 1;
+            std::size_t Slot = HomeSlot(id,ids.size());
+            while(true){
+                uint64_t SlotID = ids[Slot];
+                // an empty slot holding id still gives InvalidPosition
+                if(SlotID == id){
+                    return positions[Slot];
+                }
+                if((SlotID == EmptyID) && (positions[Slot] == InvalidPosition)){
+                    return InvalidPosition;
+                }
+                Slot = (Slot + 1) & Mask;
+            }
+        };
+};
+
+#endif
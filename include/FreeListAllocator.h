@@ -0,0 +1,73 @@
+#ifndef FREELISTALLOCATOR_H
+#define FREELISTALLOCATOR_H
+
+#include <cstddef>
+#include <new>
+
+// Allocator for small objects made and dropped at a high rate, such as the
+// street map handles returned on every lookup. Single objects go back on a
+// free list of the thread that frees them and are reused by its next
+// allocation, so a steady stream of lookups does not reach the heap. Each
+// list holds at most as many blocks as were live at once on its thread and
+// is released when the thread exits. Arrays go straight to the heap.
+template <typename T>
+class CFreeListAllocator{
+    private:
+        struct SBlock{
+            SBlock *DNext;
+        };
+
+        struct SFreeList{
+            SBlock *DHead = nullptr;
+
+            ~SFreeList(){
+                while(DHead){
+                    SBlock *Next = DHead->DNext;
+                    ::operator delete(DHead);
+                    DHead = Next;
+                }
+            };
+        };
+
+        static SFreeList &FreeList() noexcept{
+            thread_local SFreeList List;
+            return List;
+        };
+
+        static_assert(sizeof(T) >= sizeof(SBlock), "blocks must be able to hold the free list link");
+
+    public:
+        using value_type = T;
+
+        CFreeListAllocator() noexcept = default;
+        template <typename U>
+        CFreeListAllocator(const CFreeListAllocator<U> &) noexcept{};
+
+        T *allocate(std::size_t count){
+            auto &List = FreeList();
+            if((count == 1) && List.DHead){
+                SBlock *Block = List.DHead;
+                List.DHead = Block->DNext;
+                return reinterpret_cast<T *>(Block);
+            }
+            return static_cast<T *>(::operator new(count * sizeof(T)));
+        };
+
+        void deallocate(T *pointer, std::size_t count) noexcept{
+            if(count != 1){
+                ::operator delete(pointer);
+                return;
+            }
+            auto &List = FreeList();
+            SBlock *Block = reinterpret_cast<SBlock *>(pointer);
+            Block->DNext = List.DHead;
+            List.DHead = Block;
+        };
+
+        template <typename U>
+        bool operator==(const CFreeListAllocator<U> &) const noexcept{
+            return true;
+        };
+};
+
+#endif
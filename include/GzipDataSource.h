@@ -0,0 +1,31 @@
+#ifndef GZIPDATASOURCE_H
+#define GZIPDATASOURCE_H
+
+#include "DataSource.h"
+#include <memory>
+
+// Streams the inflated contents of a gzip (or zlib) compressed source,
+// holding only one input and two output blocks in memory at a time.
+// Concatenated gzip members are read back to back.
+class CGzipDataSource : public CDataSource{
+    private:
+        struct SImplementation;
+        std::unique_ptr<SImplementation> DImplementation;
+    public:
+        inline static constexpr std::size_t DefaultBlockSize = 65536;
+
+        CGzipDataSource(std::shared_ptr< CDataSource > src, std::size_t blocksize = DefaultBlockSize);
+        ~CGzipDataSource();
+
+        // True once the compressed input turned out to be corrupt or truncated
+        bool Failed() const noexcept override;
+
+        bool End() const noexcept override;
+        bool Get(char &ch) noexcept override;
+        bool Peek(char &ch) noexcept override;
+        bool Read(std::vector<char> &buf, std::size_t count) noexcept override;
+        std::size_t ReadSpan(std::span<char> buf) noexcept override;
+        bool Borrow(std::span<const char> &span, std::size_t count) noexcept override;
+};
+
+#endif
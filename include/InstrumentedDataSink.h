@@ -0,0 +1,26 @@
+#ifndef INSTRUMENTEDDATASINK_H
+#define INSTRUMENTEDDATASINK_H
+
+#include "DataSink.h"
+#include "DataStatistics.h"
+#include <memory>
+
+// Passes every call through to another sink while counting calls, bytes
+// and the wall time spent inside the wrapped sink.
+class CInstrumentedDataSink : public CDataSink{
+    private:
+        std::shared_ptr< CDataSink > DSink;
+        SDataStatistics DStatistics;
+    public:
+        CInstrumentedDataSink(std::shared_ptr< CDataSink > sink);
+
+        const SDataStatistics &Statistics() const noexcept;
+        void ResetStatistics() noexcept;
+
+        bool Put(const char &ch) noexcept override;
+        bool Write(const std::vector<char> &buf) noexcept override;
+        bool WriteSpan(std::span<const char> buf) noexcept override;
+        bool Flush() noexcept override;
+};
+
+#endif
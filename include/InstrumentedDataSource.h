@@ -0,0 +1,31 @@
+#ifndef INSTRUMENTEDDATASOURCE_H
+#define INSTRUMENTEDDATASOURCE_H
+
+#include "DataSource.h"
+#include "DataStatistics.h"
+#include <memory>
+
+// Passes every call through to another source while counting calls, bytes
+// and the wall time spent inside the wrapped source.
+class CInstrumentedDataSource : public CDataSource{
+    private:
+        std::shared_ptr< CDataSource > DSource;
+        mutable SDataStatistics DStatistics;
+    public:
+        CInstrumentedDataSource(std::shared_ptr< CDataSource > src);
+
+        const SDataStatistics &Statistics() const noexcept;
+        void ResetStatistics() noexcept;
+
+        bool End() const noexcept override;
+        bool Get(char &ch) noexcept override;
+        bool Peek(char &ch) noexcept override;
+        bool Read(std::vector<char> &buf, std::size_t count) noexcept override;
+        std::size_t ReadSpan(std::span<char> buf) noexcept override;
+        bool Borrow(std::span<const char> &span, std::size_t count) noexcept override;
+        bool ReadLine(std::string &line) noexcept override;
+        bool Seek(std::size_t offset) noexcept override;
+        bool Tell(std::size_t &offset) const noexcept override;
+};
+
+#endif
@@ -6,6 +6,7 @@
 #include <cstdint>
 #include "DataSink.h"
 #include "StreetMap.h"
+#include "XMLWriter.h"
 
 class CKMLWriter{
     private:
@@ -13,7 +14,8 @@ class CKMLWriter{
         std::unique_ptr<SImplementation> DImplementation;
         
     public:
-        CKMLWriter(std::shared_ptr< CDataSink > sink, const std::string &name, const std::string &desc);
+        // Indented output matches what KML viewers show, Minified is smaller
+        CKMLWriter(std::shared_ptr< CDataSink > sink, const std::string &name, const std::string &desc, CXMLWriter::EFormat format = CXMLWriter::EFormat::Indented);
         ~CKMLWriter();
         
         bool CreatePointStyle(const std::string &stylename, unsigned int color);
@@ -0,0 +1,26 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <span>
+#include <string>
+#include <vector>
+
+// Immutable contents of a whole file. Regular files are memory mapped,
+// anything that cannot be mapped (pipes, procfs) is read into memory once.
+// A missing or unreadable file has empty contents.
+class CMappedFile{
+    private:
+        const char *DData;
+        std::size_t DSize;
+        void *DMapping;
+        std::vector<char> DBuffer;
+    public:
+        CMappedFile(const std::string &filename);
+        CMappedFile(const CMappedFile &) = delete;
+        CMappedFile &operator=(const CMappedFile &) = delete;
+        ~CMappedFile();
+
+        std::span<const char> Contents() const noexcept;
+};
+
+#endif
@@ -0,0 +1,37 @@
+#ifndef READAHEADDATASOURCE_H
+#define READAHEADDATASOURCE_H
+
+#include "DataSource.h"
+#include <memory>
+
+// Decorates another source with a background thread that keeps a ring of
+// chunks filled ahead of the reader, so I/O on the wrapped source overlaps
+// with whatever the caller does with the bytes. The wrapped source must not
+// be used directly once it has been handed to the decorator. End() and the
+// read calls wait for the background thread when the ring is empty. End()
+// never gives up the chunk being read, so a view from Borrow survives it.
+// The ring always has at least two chunks.
+class CReadAheadDataSource : public CDataSource{
+    private:
+        struct SImplementation;
+        std::unique_ptr<SImplementation> DImplementation;
+    public:
+        inline static constexpr std::size_t DefaultChunkSize = 65536;
+        inline static constexpr std::size_t DefaultChunkCount = 4;
+
+        CReadAheadDataSource(std::shared_ptr< CDataSource > src, std::size_t chunksize = DefaultChunkSize, std::size_t chunkcount = DefaultChunkCount);
+        ~CReadAheadDataSource();
+
+        // Failure of the wrapped source, known once the background thread
+        // has read to its end
+        bool Failed() const noexcept override;
+
+        bool End() const noexcept override;
+        bool Get(char &ch) noexcept override;
+        bool Peek(char &ch) noexcept override;
+        bool Read(std::vector<char> &buf, std::size_t count) noexcept override;
+        std::size_t ReadSpan(std::span<char> buf) noexcept override;
+        bool Borrow(std::span<const char> &span, std::size_t count) noexcept override;
+};
+
+#endif
@@ -0,0 +1,25 @@
+#ifndef SPANDATASINK_H
+#define SPANDATASINK_H
+
+#include "DataSink.h"
+#include <string_view>
+
+// Writes into a fixed buffer supplied by the caller. Writes that would run
+// past the end of the buffer fail without writing anything.
+class CSpanDataSink : public CDataSink{
+    private:
+        std::span<char> DBuffer;
+        std::size_t DLength;
+    public:
+        CSpanDataSink(std::span<char> buf);
+
+        std::size_t Length() const noexcept;
+        std::string_view View() const noexcept;
+        void Clear() noexcept;
+
+        bool Put(const char &ch) noexcept override;
+        bool Write(const std::vector<char> &buf) noexcept override;
+        bool WriteSpan(std::span<const char> buf) noexcept override;
+};
+
+#endif
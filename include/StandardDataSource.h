@@ -2,14 +2,38 @@
 #define STANDARDDATASOURCE_H
 
 #include "DataSource.h"
+#include <vector>
 
+// Reads standard input (or another descriptor) with raw read(2) into a large
+// buffer. Read and ReadSpan block until the requested count is filled or the
+// input ends, like the other sources, so on a terminal they wait for more
+// lines; Get, Peek, Borrow and ReadLine only wait for the bytes they return.
+// Only one source should read a given descriptor since each keeps its own
+// buffer.
 class CStandardDataSource : public CDataSource{
     private:
+        int DHandle;
+        std::vector<char> DBuffer;
+        std::size_t DOffset;
+        std::size_t DLength;
+        bool DEndOfFile;
+
+        bool Fill() noexcept;
     public:
+        inline static constexpr std::size_t DefaultBufferSize = 65536;
+
+        CStandardDataSource(std::size_t buffersize = DefaultBufferSize);
+        CStandardDataSource(int handle, std::size_t buffersize = DefaultBufferSize);
+
         bool End() const noexcept override;
         bool Get(char &ch) noexcept override;
         bool Peek(char &ch) noexcept override;
         bool Read(std::vector<char> &buf, std::size_t count) noexcept override;
+        std::size_t ReadSpan(std::span<char> buf) noexcept override;
+        bool Borrow(std::span<const char> &span, std::size_t count) noexcept override;
+        bool ReadLine(std::string &line) noexcept override;
+        bool Seek(std::size_t offset) noexcept override;
+        bool Tell(std::size_t &offset) const noexcept override;
 };
 
 #endif
@@ -8,6 +8,7 @@ class CStandardErrorDataSink : public CDataSink{
     public:
         bool Put(const char &ch) noexcept override;
         bool Write(const std::vector<char> &buf) noexcept override;
+        bool WriteSpan(std::span<const char> buf) noexcept override;
 };
 
 #endif
@@ -33,6 +33,11 @@ class CStreetMap{
             virtual std::string GetAttributeKey(std::size_t index) const noexcept = 0;
             virtual bool HasAttribute(const std::string &key) const noexcept = 0;
             virtual std::string GetAttribute(const std::string &key) const noexcept = 0;
+            // Value of the attribute at index, which reaches every value of a
+            // repeated key where GetAttribute only finds the first
+            virtual std::string GetAttributeValue(std::size_t index) const noexcept{
+                return GetAttribute(GetAttributeKey(index));
+            };
         };
 
         struct SWay{
@@ -44,6 +49,11 @@ class CStreetMap{
             virtual std::string GetAttributeKey(std::size_t index) const noexcept = 0;
             virtual bool HasAttribute(const std::string &key) const noexcept = 0;
             virtual std::string GetAttribute(const std::string &key) const noexcept = 0;
+            // Value of the attribute at index, which reaches every value of a
+            // repeated key where GetAttribute only finds the first
+            virtual std::string GetAttributeValue(std::size_t index) const noexcept{
+                return GetAttribute(GetAttributeKey(index));
+            };
         };
 
         virtual ~CStreetMap(){};
@@ -0,0 +1,44 @@
+#ifndef STREETMAPSNAPSHOT_H
+#define STREETMAPSNAPSHOT_H
+
+#include "StreetMap.h"
+#include "DataSink.h"
+#include "MappedFile.h"
+
+// Street map read straight out of a binary snapshot file. Write lays out the
+// nodes, ways, tags and ID indexes of any CStreetMap as flat arrays, and
+// opening the file only checks the header and the ID indexes and points at
+// those arrays, so there is nothing to parse per node or way. The file is in the byte order
+// of the machine that wrote it; snapshots from another byte order, as well
+// as missing, truncated or corrupt files, open as an empty map with
+// Valid() false.
+class CStreetMapSnapshot : public CStreetMap{
+    private:
+        struct SImplementation;
+        std::shared_ptr<SImplementation> DImplementation;
+
+    public:
+        CStreetMapSnapshot(std::shared_ptr< const CMappedFile > file);
+        ~CStreetMapSnapshot();
+
+        bool Valid() const noexcept;
+        // True if the snapshot was written with filename as its source and
+        // the file still has the size and modification time it had then.
+        // Callers fall back to the source when it has changed.
+        bool MatchesSource(const std::string &filename) const noexcept;
+
+        // Node and way IDs of map must not repeat. The size and modification
+        // time of source, the file map was read from, are recorded for
+        // MatchesSource. False if the sink fails or the map is too large for
+        // the format.
+        static bool Write(const CStreetMap &map, std::shared_ptr< CDataSink > sink, const std::string &source = std::string());
+
+        std::size_t NodeCount() const noexcept override;
+        std::size_t WayCount() const noexcept override;
+        std::shared_ptr<CStreetMap::SNode> NodeByIndex(std::size_t index) const noexcept override;
+        std::shared_ptr<CStreetMap::SNode> NodeByID(TNodeID id) const noexcept override;
+        std::shared_ptr<CStreetMap::SWay> WayByIndex(std::size_t index) const noexcept override;
+        std::shared_ptr<CStreetMap::SWay> WayByID(TWayID id) const noexcept override;
+};
+
+#endif
@@ -8,10 +8,18 @@ class CStringDataSink : public CDataSink{
     private:
         std::string DString;
     public:
+        CStringDataSink() = default;
+        // Starts with room for capacity bytes so large outputs never regrow
+        explicit CStringDataSink(std::size_t capacity);
+
         const std::string &String() const;
+        void Reserve(std::size_t capacity);
+        // Moves the accumulated string out, leaving the sink empty
+        std::string Release() noexcept;
 
         bool Put(const char &ch) noexcept override;
         bool Write(const std::vector<char> &buf) noexcept override;
+        bool WriteSpan(std::span<const char> buf) noexcept override;
 };
 
 #endif
@@ -1,20 +1,20 @@
 #ifndef STRINGDATASOURCE_H
 #define STRINGDATASOURCE_H
 
-#include "DataSource.h"
+#include "StringViewDataSource.h"
 #include <string>
 
-class CStringDataSource : public CDataSource{
+// Reads from a string of its own; all of the reading is done by the view
+// source over that string. Not copyable, since a copy would still view the
+// original's string.
+class CStringDataSource : public CStringViewDataSource{
     private:
-        std::string DString;
-        size_t DIndex;
+        std::string DOwned;
     public:
-        CStringDataSource(const std::string &str);
-
-        bool End() const noexcept override;
-        bool Get(char &ch) noexcept override;
-        bool Peek(char &ch) noexcept override;
-        bool Read(std::vector<char> &buf, std::size_t count) noexcept override;
+        // Takes str by value so callers can move large inputs in without a copy
+        CStringDataSource(std::string str);
+        CStringDataSource(const CStringDataSource &) = delete;
+        CStringDataSource &operator=(const CStringDataSource &) = delete;
 };
 
 #endif
@@ -0,0 +1,34 @@
+#ifndef STRINGVIEWDATASOURCE_H
+#define STRINGVIEWDATASOURCE_H
+
+#include "DataSource.h"
+#include <string_view>
+
+// Reads from memory owned by the caller, which must outlive the source.
+// Nothing is ever copied at construction and Borrow lends the caller's bytes.
+class CStringViewDataSource : public CDataSource{
+    private:
+        std::string_view DString;
+        std::size_t DIndex;
+    protected:
+        // Restarts reading from the beginning of str, for sources that own
+        // the bytes and only have them once the base is built
+        void View(std::string_view str) noexcept{
+            DString = str;
+            DIndex = 0;
+        };
+    public:
+        CStringViewDataSource(std::string_view str);
+
+        bool End() const noexcept override;
+        bool Get(char &ch) noexcept override;
+        bool Peek(char &ch) noexcept override;
+        bool Read(std::vector<char> &buf, std::size_t count) noexcept override;
+        std::size_t ReadSpan(std::span<char> buf) noexcept override;
+        bool Borrow(std::span<const char> &span, std::size_t count) noexcept override;
+        bool ReadLine(std::string &line) noexcept override;
+        bool Seek(std::size_t offset) noexcept override;
+        bool Tell(std::size_t &offset) const noexcept override;
+};
+
+#endif
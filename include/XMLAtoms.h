@@ -0,0 +1,76 @@
+#ifndef XMLATOMS_H
+#define XMLATOMS_H
+
+#include <cstdint>
+#include <deque>
+#include <limits>
+#include <span>
+#include <string>
+#include <vector>
+#include "XMLEntity.h"
+
+// Small integer standing for an interned element or attribute name
+using TXMLAtom = uint32_t;
+
+// Hands out atoms for names in the order they are first seen. Each name is
+// stored once and atoms stay valid for the life of the table. Names are
+// looked up in an open addressed hash table since the reader interns every
+// element and attribute name it parses.
+class CXMLAtomTable{
+    private:
+        // deque so views of the names stay valid as names are added
+        std::deque< std::string > DNames;
+        // atoms by hash slot, InvalidAtom for empty slots, with their names
+        // alongside so probing does not touch DNames
+        std::vector< TXMLAtom > DSlots;
+        std::vector< std::string_view > DSlotNames;
+
+        std::size_t FindSlot(std::string_view name) const noexcept;
+
+    public:
+        inline static constexpr TXMLAtom InvalidAtom = std::numeric_limits<TXMLAtom>::max();
+
+        TXMLAtom Intern(std::string_view name);
+        // InvalidAtom if the name has not been interned
+        TXMLAtom Find(std::string_view name) const noexcept;
+        std::string_view Name(TXMLAtom atom) const noexcept;
+        std::size_t Size() const noexcept;
+};
+
+// Attributes of one start element along with the atoms of their names. An
+// index from atom to position makes lookups by atom a single array access.
+class CXMLAttributes{
+    private:
+        std::vector< TAttributeView > DAttributes;
+        std::vector< TXMLAtom > DAtoms;
+        // position + 1 of the attribute with each atom, 0 if it is not present
+        std::vector< uint32_t > DPositions;
+
+    public:
+        std::size_t Count() const noexcept{
+            return DAttributes.size();
+        };
+
+        std::span< const TAttributeView > Views() const noexcept{
+            return DAttributes;
+        };
+
+        TXMLAtom Atom(std::size_t index) const noexcept{
+            return index < DAtoms.size() ? DAtoms[index] : CXMLAtomTable::InvalidAtom;
+        };
+
+        bool Exists(TXMLAtom atom) const noexcept{
+            return (atom < DPositions.size()) && DPositions[atom];
+        };
+
+        // Empty if there is no attribute with that atom
+        std::string_view Value(TXMLAtom atom) const noexcept{
+            return Exists(atom) ? DAttributes[DPositions[atom] - 1].second : std::string_view();
+        };
+
+        // Used by the reader to fill the attributes of each element
+        void Clear() noexcept;
+        void Add(TXMLAtom atom, std::string_view name, std::string_view value);
+};
+
+#endif
@@ -3,10 +3,13 @@
 
 #include <utility>
 #include <string>
+#include <string_view>
 #include <vector>
 
 using TAttribute = std::pair< std::string, std::string >;
 using TAttributes = std::vector< TAttribute >;
+// Attribute that borrows its name and value from a parser's buffers
+using TAttributeView = std::pair< std::string_view, std::string_view >;
 
 struct SXMLEntity{    
     enum class EType{StartElement, EndElement, CharData, CompleteElement};
@@ -3,19 +3,41 @@
 
 #include <memory>
 #include "XMLEntity.h"
+#include "XMLAtoms.h"
 #include "DataSource.h"
 
+// Receives the events of CXMLReader::Parse as the parser produces them. The
+// names, data and attributes are views that are only valid during the call.
+// Element and attribute names come with their atoms in the reader's table.
+class CXMLHandler{
+    public:
+        virtual ~CXMLHandler(){};
+        virtual void StartElement(TXMLAtom /*atom*/, std::string_view /*name*/, const CXMLAttributes &/*attributes*/){};
+        virtual void EndElement(TXMLAtom /*atom*/, std::string_view /*name*/){};
+        virtual void CharData(std::string_view /*data*/){};
+};
+
 class CXMLReader{
     private:
         struct SImplementation;
         std::unique_ptr<SImplementation> DImplementation;
         
     public:
-        CXMLReader(std::shared_ptr< CDataSource > src);
+        // Expat reads any XML, Native uses the faster CXMLTokenizer that only
+        // handles the subset OpenStreetMap files use
+        enum class EParser{Expat, Native};
+
+        CXMLReader(std::shared_ptr< CDataSource > src, EParser parser = EParser::Expat);
         ~CXMLReader();
         
         bool End() const;
         bool ReadEntity(SXMLEntity &entity, bool skipcdata = false);
+        // Pushes the rest of the document to handler, starting with any
+        // entities already parsed but not yet read. Returns false if the
+        // document is malformed.
+        bool Parse(CXMLHandler &handler);
+        // Names seen so far, intern names up front to compare handler atoms with
+        CXMLAtomTable &Atoms();
 };
 
 #endif
@@ -0,0 +1,39 @@
+#ifndef XMLTOKENIZER_H
+#define XMLTOKENIZER_H
+
+#include <memory>
+#include <string_view>
+#include "XMLEntity.h"
+#include "DataSource.h"
+
+// An entity whose name, character data and attributes are views into the
+// parser's buffers rather than copies
+struct SXMLToken{
+    SXMLEntity::EType DType;
+    std::string_view DNameData;
+    std::vector< TAttributeView > DAttributes;
+};
+
+// Hand written tokenizer for the XML that OpenStreetMap exports use: UTF-8
+// elements, attributes, character data, CDATA sections, comments and
+// processing instructions. The predefined and numeric character references
+// are decoded and nesting is checked, but there is no DTD support (a DOCTYPE
+// with an internal subset is an error) and names are not validated. Events
+// match what expat reports, except that character data is never split.
+class CXMLTokenizer{
+    private:
+        struct SImplementation;
+        std::unique_ptr<SImplementation> DImplementation;
+
+    public:
+        CXMLTokenizer(std::shared_ptr< CDataSource > src);
+        ~CXMLTokenizer();
+
+        // True once the document has been read to the end or failed
+        bool End() const;
+        bool Failed() const;
+        // The views in token stay valid until the next call on the tokenizer
+        bool ReadToken(SXMLToken &token);
+};
+
+#endif
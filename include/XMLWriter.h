@@ -11,11 +11,25 @@ class CXMLWriter{
         std::unique_ptr<SImplementation> DImplementation;
         
     public:
-        CXMLWriter(std::shared_ptr< CDataSink > sink);
+        // Raw writes entities exactly as given. Indented puts each tag on its
+        // own line, indented indentwidth spaces per open element; elements
+        // holding only single line text stay on one line. Minified adds no
+        // whitespace. Both drop whitespace-only text between elements, such
+        // as the indentation of a parsed document, but keep it when it is all
+        // an element holds or runs on from other text.
+        enum class EFormat{Raw, Indented, Minified};
+
+        // With a batchsize of 0 each entity reaches the sink in one write as
+        // soon as it is written. Otherwise entities collect in the writer
+        // until about batchsize bytes are pending; Flush or destroying the
+        // writer hands over the remainder.
+        CXMLWriter(std::shared_ptr< CDataSink > sink, std::size_t batchsize = 0, EFormat format = EFormat::Raw, std::size_t indentwidth = 2);
         ~CXMLWriter();
         
         bool Flush();
         bool WriteEntity(const SXMLEntity &entity);
+        // Number of elements started but not yet ended
+        std::size_t Depth() const;
 };
 
 #endif
@@ -0,0 +1,120 @@
+#include "ByteScan.h"
+#include <algorithm>
+#include <cstring>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define BYTESCAN_X86 1
+#endif
+
+namespace ByteScan{
+
+namespace{
+
+std::size_t FindAnyScalar(const char *data, std::size_t size, std::string_view needles) noexcept{
+    if(needles.size() == 1){
+        auto Found = static_cast<const char *>(std::memchr(data, needles[0], size));
+        return Found ? Found - data : size;
+    }
+    for(std::size_t Index = 0; Index < size; Index++){
+        for(char Needle : needles){
+            if(data[Index] == Needle){
+                return Index;
+            }
+        }
+    }
+    return size;
+}
+
+#ifdef BYTESCAN_X86
+
+std::size_t FindAnySSE2(const char *data, std::size_t size, std::string_view needles) noexcept{
+    __m128i Needles[MaxNeedles];
+    for(std::size_t Index = 0; Index < needles.size(); Index++){
+        Needles[Index] = _mm_set1_epi8(needles[Index]);
+    }
+    std::size_t Offset = 0;
+    for(; Offset + 16 <= size; Offset += 16){
+        __m128i Block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + Offset));
+        __m128i Matches = _mm_cmpeq_epi8(Block, Needles[0]);
+        for(std::size_t Index = 1; Index < needles.size(); Index++){
+            Matches = _mm_or_si128(Matches, _mm_cmpeq_epi8(Block, Needles[Index]));
+        }
+        unsigned Mask = _mm_movemask_epi8(Matches);
+        if(Mask){
+            return Offset + __builtin_ctz(Mask);
+        }
+    }
+    return Offset + FindAnyScalar(data + Offset, size - Offset, needles);
+}
+
+__attribute__((target("avx2")))
+std::size_t FindAnyAVX2(const char *data, std::size_t size, std::string_view needles) noexcept{
+    __m256i Needles[MaxNeedles];
+    for(std::size_t Index = 0; Index < needles.size(); Index++){
+        Needles[Index] = _mm256_set1_epi8(needles[Index]);
+    }
+    std::size_t Offset = 0;
+    for(; Offset + 32 <= size; Offset += 32){
+        __m256i Block = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(data + Offset));
+        __m256i Matches = _mm256_cmpeq_epi8(Block, Needles[0]);
+        for(std::size_t Index = 1; Index < needles.size(); Index++){
+            Matches = _mm256_or_si256(Matches, _mm256_cmpeq_epi8(Block, Needles[Index]));
+        }
+        unsigned Mask = _mm256_movemask_epi8(Matches);
+        if(Mask){
+            return Offset + __builtin_ctz(Mask);
+        }
+    }
+    // The remaining 0-31 bytes still get one 16 byte pass
+    return Offset + FindAnySSE2(data + Offset, size - Offset, needles);
+}
+
+#endif
+
+EImplementation DetectImplementation() noexcept{
+#ifdef BYTESCAN_X86
+    __builtin_cpu_init();
+    if(__builtin_cpu_supports("avx2")){
+        return EImplementation::AVX2;
+    }
+    if(__builtin_cpu_supports("sse2")){
+        return EImplementation::SSE2;
+    }
+#endif
+    return EImplementation::Scalar;
+}
+
+}
+
+EImplementation BestImplementation() noexcept{
+    static const EImplementation Best = DetectImplementation();
+    return Best;
+}
+
+std::size_t FindAny(std::string_view data, std::string_view needles) noexcept{
+    return FindAny(data, needles, BestImplementation());
+}
+
+std::size_t FindAny(std::string_view data, std::string_view needles, EImplementation impl) noexcept{
+    if(needles.empty()){
+        return data.size();
+    }
+    if(needles.size() > MaxNeedles){
+        return std::min(data.find_first_of(needles), data.size());
+    }
+    if(impl > BestImplementation()){
+        impl = BestImplementation();
+    }
+#ifdef BYTESCAN_X86
+    if(impl == EImplementation::AVX2){
+        return FindAnyAVX2(data.data(), data.size(), needles);
+    }
+    if(impl == EImplementation::SSE2){
+        return FindAnySSE2(data.data(), data.size(), needles);
+    }
+#endif
+    return FindAnyScalar(data.data(), data.size(), needles);
+}
+
+}
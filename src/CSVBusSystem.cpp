@@ -1,6 +1,13 @@
 #include "CSVBusSystem.h"
+#include "DSVColumnReader.h"
+#include "DSVTable.h"
+#include "StringViewDataSource.h"
+#include <algorithm>
+#include <atomic>
+#include <limits>
+#include <thread>
 #include <unordered_map>
-#include <iostream>
+#include <unordered_set>
 #include <vector>
 
 struct CCSVBusSystem::SImplementation{
@@ -38,6 +45,7 @@ struct CCSVBusSystem::SImplementation{
         std::string DName;
         int DStopCount;
         std::vector<TStopID> DStopsForRoute;
+        std::unordered_set<TStopID> DStopSet;
         // constructor (remember a route can have multiple stopIds)
         // but when creating a route, all we need is the name
         SRoute(std::string name, int stop_count) {
@@ -72,70 +80,120 @@ struct CCSVBusSystem::SImplementation{
     std::vector< std::shared_ptr< SStop > > DStopsByIndex;
     std::unordered_map< TStopID, std::shared_ptr< SStop > > DStopsByID;
 
+    // Rows of one piece of a file parsed into plain records. Parsing stops at
+    // the first malformed row, leaving DValid false.
+    struct SStopRecord{
+        TStopID DStopID;
+        CStreetMap::TNodeID DNodeID;
+    };
+
+    struct SRouteRecord{
+        std::string DName;
+        TStopID DStopID;
+    };
+
+    template <typename TRecord> struct SChunk{
+        std::vector< TRecord > DRecords;
+        bool DValid = true;
+    };
+
+    // inputs at least this large per piece are worth splitting
+    static constexpr std::size_t ParallelChunkSize = 65536;
+    static constexpr std::size_t PiecesPerThread = 4;
+
+    // first problem met while loading, rows are counted from the header as row 1
+    std::string DLoadError;
+
+    void SetError(const std::string &file, std::size_t row, const std::string &message){
+        if(DLoadError.empty()){
+            DLoadError = file + (row ? " row " + std::to_string(row) : std::string()) + ": " + message;
+        }
+    }
+
     /*
     --------------------------------------------------------------------------------------------------------
     READ STOPS SECTION
     --------------------------------------------------------------------------------------------------------
     */
 
+    // columns is a CDSVColumnReader or a CDSVTable
+    template <typename TColumns> bool StopColumns(const TColumns &columns, std::size_t &stopcolumn, std::size_t &nodecolumn){
+        stopcolumn = columns.Column(STOP_ID_HEADER);
+        nodecolumn = columns.Column(NODE_ID_HEADER);
+        if(!columns.HeaderValid() || stopcolumn == TColumns::InvalidColumn || nodecolumn == TColumns::InvalidColumn){
+            SetError("stops", 0, "missing stop_id or node_id header");
+            return false;
+        }
+        return true;
+    }
+
+    static void ParseStops(CDSVColumnReader &reader, std::size_t stopcolumn, std::size_t nodecolumn, SChunk< SStopRecord > &chunk){
+        while(reader.NextRow()){
+            SStopRecord Record;
+            // a missing or non numeric stop/node makes the rest of the file untrustworthy
+            if(!reader.GetUInt64(stopcolumn, Record.DStopID) || !reader.GetUInt64(nodecolumn, Record.DNodeID)){
+                chunk.DValid = false;
+                return;
+            }
+            chunk.DRecords.push_back(Record);
+        }
+    }
+
+    // Adds the stop read from row, false if its ID was already taken
+    bool AddStop(const SStopRecord &record, std::size_t row){
+        if(DStopsByID.find(record.DStopID) != DStopsByID.end()) {
+            // duplicate stop
+            isInvalidStopFile = true;
+            SetError("stops", row, "duplicate stop_id " + std::to_string(record.DStopID));
+            return false;
+        }
+        auto NewStop = std::make_shared< SStop >(record.DStopID,record.DNodeID);
+        DStopsByIndex.push_back(NewStop);
+        DStopsByID[record.DStopID] = NewStop;
+        return true;
+    }
+
+    bool InvalidStopRow(std::size_t row){
+        isInvalidStopFile = true;
+        SetError("stops", row, "invalid stop_id or node_id");
+        return false;
+    }
+
+    // Adds the parsed stops in file order, stopping at the first bad row
+    bool MergeStops(std::vector< SChunk< SStopRecord > > &chunks){
+        std::size_t Row = 1;
+        for(auto &Chunk : chunks){
+            for(auto &Record : Chunk.DRecords){
+                if(!AddStop(Record, ++Row)){
+                    return false;
+                }
+            }
+            if(!Chunk.DValid){
+                return InvalidStopRow(Row + 1);
+            }
+        }
+        return true;
+    }
+
     // reading stops
     bool ReadStops(std::shared_ptr< CDSVReader > stopsrc){
-        // if(isInvalidStopFile) {
-        //     std::cout << "invalid case enncountered, file corrupted, no parsing" << std::endl;
-        //     return false;
-        // }
-        std::vector<std::string> TempRow;
-
-        if(stopsrc->ReadRow(TempRow)){
-            size_t StopColumn = -1;
-            size_t NodeColumn = -1;
-            for(size_t Index = 0; Index < TempRow.size(); Index++){
-                if(TempRow[Index] == STOP_ID_HEADER){
-                    StopColumn = Index;
-                }
-                else if(TempRow[Index] == NODE_ID_HEADER){
-                    NodeColumn = Index;
-                }
+        CDSVTable Table(stopsrc);
+        std::size_t StopColumn, NodeColumn;
+        if(!StopColumns(Table, StopColumn, NodeColumn)){
+            return false;
+        }
+        // DStopsById and DStopsbyIndex start at index 0 since we DONT read the
+        // header row, which is file row 1
+        for(std::size_t Row = 0; Row < Table.RowCount(); Row++){
+            SStopRecord Record;
+            if(!Table.GetUInt64(StopColumn, Row, Record.DStopID) || !Table.GetUInt64(NodeColumn, Row, Record.DNodeID)){
+                return InvalidStopRow(Row + 2);
             }
-            if(StopColumn == -1 || NodeColumn == -1){
+            if(!AddStop(Record, Row + 2)){
                 return false;
             }
-            // DStopsById and DStopsbyIndex start at index 0 since we DONT read the header row
-            while(stopsrc->ReadRow(TempRow)){
-                std::cout <<"STOP = " << TempRow[StopColumn] << " NODE = " << TempRow[NodeColumn] << std::endl;
-                try {
-                    TStopID StopID = std::stoull(TempRow[StopColumn]);
-
-                    for(auto i = 0; i < DStopsByIndex.size(); i++) {
-                        if(StopID == DStopsByIndex[i]->DID) {
-                            // duplicate stop
-                            std::cout << "stop "<< StopID << "already in system dupe stop CORRUPT FILE" << std::endl;
-                            isInvalidStopFile = true;
-                            return false;
-                        }
-                    }
-
-                    CStreetMap::TNodeID NodeID = std::stoull(TempRow[NodeColumn]);
-                    auto NewStop = std::make_shared< SStop >(StopID,NodeID);
-                    DStopsByIndex.push_back(NewStop);
-                    DStopsByID[StopID] = NewStop;
-                } catch (std::invalid_argument &) { // if we are missing columns, and we try to create a new stop, stoull() will throw error, so catch it and return false
-                // THIS ALSO catches if the stop/node is not a valid argument such as not a number
-                    isInvalidStopFile = true;
-                    return false;
-                }
-
-             }
-            return true;
-            // for(auto &val : DStopsByIndex) {
-            //     std::cout << val << std::endl;
-            // }
-
-            // for(auto &pair : DStopsByID) {
-            //     std::cout << "<" << pair.first << "," << pair.second << ">" << std::endl;
-            // }
         }
-        return false;
+        return true;
     }
 
 
@@ -152,83 +210,184 @@ struct CCSVBusSystem::SImplementation{
     std::vector< std::shared_ptr< SRoute > >DRoutesByIndex;
     std::unordered_map<std::string, std::shared_ptr<SRoute> >DRoutesByName;
 
+    template <typename TColumns> bool RouteColumns(const TColumns &columns, std::size_t &routecolumn, std::size_t &stopcolumn){
+        routecolumn = columns.Column(ROUTE_HEADER);
+        stopcolumn = columns.Column(ROUTE_STOP_HEADER);
+        if(!columns.HeaderValid() || stopcolumn == TColumns::InvalidColumn || routecolumn == TColumns::InvalidColumn){
+            SetError("routes", 0, "missing route or stop_id header");
+            return false;
+        }
+        return true;
+    }
+
+    static void ParseRoutes(CDSVColumnReader &reader, std::size_t routecolumn, std::size_t stopcolumn, SChunk< SRouteRecord > &chunk){
+        while(reader.NextRow()) {
+            SRouteRecord Record;
+            Record.DName = reader.Value(routecolumn);
+            // check if route name is empty or stop is missing
+            if(Record.DName.empty() || !reader.GetUInt64(stopcolumn, Record.DStopID)) {
+                chunk.DValid = false;
+                return;
+            }
+            chunk.DRecords.push_back(std::move(Record));
+        }
+    }
+
+    // Adds the route stop read from row, false if the stop is unknown or
+    // already on the route
+    bool AddRouteStop(const SRouteRecord &record, std::size_t row){
+        // try to see if this StopId exists in our stop system, if it doesnt, return false immediately
+        if(DStopsByID.find(record.DStopID) == DStopsByID.end()) {
+            SetError("routes", row, "unknown stop_id " + std::to_string(record.DStopID));
+            return false;
+        }
+
+        // if route is not already in our map, we want to create one and add to our MAP
+        auto Search = DRoutesByName.find(record.DName);
+        if(Search == DRoutesByName.end()) {
+            // new route should have name, then we want to add a stop
+            auto NewRoute = std::make_shared<SRoute>(record.DName, 0);
+            DRoutesByIndex.push_back(NewRoute);
+            Search = DRoutesByName.emplace(NewRoute->DName, NewRoute).first;
+        }
+        // we need to check if stopId already exists in the route, we dont want duplicates
+        if(!Search->second->DStopSet.insert(record.DStopID).second) {
+            isInvalidRouteFile = true;
+            SetError("routes", row, "duplicate stop_id " + std::to_string(record.DStopID) + " in route " + record.DName);
+            return false;
+        }
+        Search->second->DStopsForRoute.push_back(record.DStopID);
+        // increment number of stops by 1
+        Search->second->DStopCount += 1;
+        return true;
+    }
+
+    bool InvalidRouteRow(std::size_t row){
+        isInvalidRouteFile = true;
+        SetError("routes", row, "invalid route or stop_id");
+        return false;
+    }
+
+    // Adds the parsed route stops in file order, stopping at the first bad row
+    bool MergeRoutes(std::vector< SChunk< SRouteRecord > > &chunks){
+        std::size_t Row = 1;
+        for(auto &Chunk : chunks){
+            for(auto &Record : Chunk.DRecords){
+                if(!AddRouteStop(Record, ++Row)){
+                    return false;
+                }
+            }
+            if(!Chunk.DValid){
+                return InvalidRouteRow(Row + 1);
+            }
+        }
+        return true;
+    }
+
     // reading routes
     bool ReadRoutes(std::shared_ptr< CDSVReader > routesrc) {
-        // if(isInvalidRouteFile) {
-        //     std::cout << "invalid case enncountered, file corrupted, no parsing" << std::endl;
-        //     return false;
-        // }
-        // read our header
-        std::vector<std::string> TempRow;
-        if(routesrc->ReadRow(TempRow)) {
-            size_t RouteColumn = -1;
-            size_t StopColumn = -1;
-            for(size_t Index = 0; Index < TempRow.size(); Index++){
-                if(TempRow[Index] == ROUTE_HEADER){
-                    RouteColumn = Index;
-                }
-                else if(TempRow[Index] == ROUTE_STOP_HEADER){
-                    StopColumn = Index;
-                }
+        // route names are names even when they look like numbers
+        CDSVTable Table(routesrc, {ROUTE_HEADER});
+        std::size_t RouteColumn, StopColumn;
+        if(!RouteColumns(Table, RouteColumn, StopColumn)){
+            return false;
+        }
+        for(std::size_t Row = 0; Row < Table.RowCount(); Row++){
+            SRouteRecord Record;
+            // check if route name is empty or stop is missing
+            if(!Table.HasValue(RouteColumn, Row) || !Table.GetUInt64(StopColumn, Row, Record.DStopID)){
+                return InvalidRouteRow(Row + 2);
             }
-            if(StopColumn == -1 || RouteColumn == -1){
+            Record.DName = Table.String(RouteColumn, Row);
+            if(!AddRouteStop(Record, Row + 2)){
                 return false;
             }
+        }
+        return true;
+    }
 
-            // for each row after the header that we read, we want to create a new route name ONLY if its not already there
-            while(routesrc->ReadRow(TempRow)) {
-                try {
-                    std::string RouteName = TempRow[RouteColumn];
-                    if(RouteName == "") { // check if route name is empty
-                        isInvalidRouteFile = true;
-                        return false;
-                    }
-
-                    TStopID StopId = std::stoull(TempRow[StopColumn]);
-
-                    // try to see if this StopId exists in our stop system, if it doesnt, return false immediately
-                    for (auto &pair : DStopsByID) {
-                        std::cout << "STOP PAIR: " << "[" << pair.first <<", "<< pair.second << "]" << std::endl;
-                    }
-                    if(DStopsByID.find(StopId) == DStopsByID.end()) {
-                        std::cout << StopId << " is not in STOPS " << std::endl;
-                        return false;
-                    } else {
-                        std::cout << StopId << " in STOPS " << std::endl;
-                    }
-
-                    // if route is not already in our map, we want to create one and add to our MAP
-                    if(DRoutesByName.find(RouteName) == DRoutesByName.end()) {
-                        // new route should have name, then we want to add a stop 
-                        auto newRoute = std::make_shared<SRoute>(RouteName, 0);
-                        DRoutesByIndex.push_back(newRoute);
-                        DRoutesByName[RouteName] = newRoute;
-
-                        newRoute->DStopsForRoute.push_back(StopId);
-                    }  else { // otherwise route already exists, just add a stop
-                        // find the route in our map, access that specific routes' stops, and append a stop to it.
-
-                        // however we need to check if stopId already exists, we dont want duplicates
-                        // dont make copy, reference the vector, otherwise we wont be adding the stopId to the original vector
-                        auto &currRouteStops = DRoutesByName[RouteName]->DStopsForRoute;
-                        for(auto i = 0; i < currRouteStops.size(); i++) {
-                            if (currRouteStops[i] == StopId) {
-                                isInvalidRouteFile = true;
-                                return false;
-                            }
-                        }
-                        currRouteStops.push_back(StopId);
-                    }
-                    // increment number of stops by 1 
-                    DRoutesByName[RouteName]->DStopCount += 1;
-                } catch (std::invalid_argument &) { // catch stoull() exception if our columns are missing
-                    isInvalidRouteFile = true;
-                    return false;
-                }
+    /*
+    --------------------------------------------------------------------------------------------------------
+    PARALLEL LOADING SECTION
+    --------------------------------------------------------------------------------------------------------
+    */
+
+    // The whole of src as one view. A source that holds its data in one
+    // block lends all of it in a single Borrow, which End() leaves valid, so
+    // a mapped file or string is parsed in place. Anything else is copied
+    // into contents.
+    static std::string_view SourceContents(std::shared_ptr< CDataSource > src, std::string &contents){
+        std::span<const char> Lent;
+        if(src->Borrow(Lent, std::numeric_limits<std::size_t>::max())){
+            if(src->End()){
+                return std::string_view(Lent.data(), Lent.size());
             }
-            return true;
+            contents.assign(Lent.begin(), Lent.end());
         }
-        return false;
+        std::size_t Length;
+        do{
+            std::size_t Used = contents.size();
+            contents.resize(Used + ParallelChunkSize);
+            Length = src->ReadSpan(std::span<char>(contents.data() + Used, ParallelChunkSize));
+            contents.resize(Used + Length);
+        }while(Length);
+        return contents;
+    }
+
+    // Splits the contents of src at row boundaries and parses the pieces on
+    // up to threads workers, each taking the next unparsed piece until none
+    // are left. The first piece's reader supplies the header, which is
+    // checked by columns before any worker starts.
+    template <typename TRecord, typename TColumns, typename TParse>
+    bool LoadParallel(std::shared_ptr< CDataSource > src, char delimiter, std::size_t threads, std::vector< SChunk< TRecord > > &chunks, TColumns columns, TParse parse){
+        std::string Owned;
+        auto Contents = SourceContents(src, Owned);
+        // a few pieces per worker evens out pieces that parse slower
+        auto Pieces = CDSVReader::SplitRows(Contents, std::min(threads * PiecesPerThread, Contents.size() / ParallelChunkSize + 1));
+        chunks.resize(Pieces.size());
+
+        std::vector< std::unique_ptr< CDSVColumnReader > > Readers;
+        Readers.push_back(std::make_unique<CDSVColumnReader>(std::make_shared<CDSVReader>(std::make_shared<CStringViewDataSource>(Pieces[0]), delimiter)));
+        std::size_t FirstColumn, SecondColumn;
+        if(!columns(*Readers[0], FirstColumn, SecondColumn)){
+            return false;
+        }
+        for(std::size_t Index = 1; Index < Pieces.size(); Index++){
+            Readers.push_back(std::make_unique<CDSVColumnReader>(std::make_shared<CDSVReader>(std::make_shared<CStringViewDataSource>(Pieces[Index]), delimiter), Readers[0]->Header()));
+        }
+        std::atomic< std::size_t > NextPiece = 0;
+        auto Work = [&]{
+            std::size_t Index;
+            while((Index = NextPiece++) < Pieces.size()){
+                parse(*Readers[Index], FirstColumn, SecondColumn, chunks[Index]);
+            }
+        };
+        // this thread is one of the workers
+        std::vector< std::thread > Workers;
+        for(std::size_t Count = 1; Count < std::min(threads, Pieces.size()); Count++){
+            Workers.emplace_back(Work);
+        }
+        Work();
+        for(auto &Worker : Workers){
+            Worker.join();
+        }
+        return true;
+    }
+
+    bool LoadStops(std::shared_ptr< CDataSource > src, char delimiter, std::size_t threads){
+        std::vector< SChunk< SStopRecord > > Chunks;
+        auto Columns = [this](const CDSVColumnReader &reader, std::size_t &stopcolumn, std::size_t &nodecolumn){
+            return StopColumns(reader, stopcolumn, nodecolumn);
+        };
+        return LoadParallel(src, delimiter, threads, Chunks, Columns, ParseStops) && MergeStops(Chunks);
+    }
+
+    bool LoadRoutes(std::shared_ptr< CDataSource > src, char delimiter, std::size_t threads){
+        std::vector< SChunk< SRouteRecord > > Chunks;
+        auto Columns = [this](const CDSVColumnReader &reader, std::size_t &routecolumn, std::size_t &stopcolumn){
+            return RouteColumns(reader, routecolumn, stopcolumn);
+        };
+        return LoadParallel(src, delimiter, threads, Chunks, Columns, ParseRoutes) && MergeRoutes(Chunks);
     }
 
     SImplementation(std::shared_ptr< CDSVReader > stopsrc, std::shared_ptr< CDSVReader > routesrc){
@@ -236,6 +395,14 @@ struct CCSVBusSystem::SImplementation{
         ReadRoutes(routesrc);
     }
 
+    SImplementation(std::shared_ptr< CDataSource > stopsrc, std::shared_ptr< CDataSource > routesrc, char delimiter, std::size_t threads){
+        // never more workers than the machine can run at once
+        std::size_t Hardware = std::max(1u, std::thread::hardware_concurrency());
+        threads = threads ? std::min(threads, Hardware) : Hardware;
+        LoadStops(stopsrc, delimiter, threads);
+        LoadRoutes(routesrc, delimiter, threads);
+    }
+
     ~SImplementation(){};
 
     std::size_t StopCount() const noexcept{
@@ -253,23 +420,14 @@ struct CCSVBusSystem::SImplementation{
             return nullptr; // return nullptr if index is invalid
         }
 
-        for(size_t i = 0; i < DStopsByIndex.size() ; i++) {
-            if(i == index) {
-                return DStopsByIndex[index]; // should return a stop object
-            }
-        }
+        return DStopsByIndex[index]; // should return a stop object
     }
 
     std::shared_ptr<SStop> StopByID(TStopID id) const noexcept{
         // stored as (id, stop) object, so we just grab stop by its key
         // map.end() is the end iterator, so theoretically if we try to access something invalid, we'll
-        for(auto i = DStopsByID.begin(); i != DStopsByID.end(); ++i) {
-            if(i->first == id) {
-                auto stop_res = i->second;
-                return stop_res;
-            }
-        }
-        return nullptr;
+        auto Search = DStopsByID.find(id);
+        return Search == DStopsByID.end() ? nullptr : Search->second;
     }
 
     std::shared_ptr<SRoute> RouteByIndex(std::size_t index) const noexcept{
@@ -277,11 +435,7 @@ struct CCSVBusSystem::SImplementation{
             return nullptr;
         }
 
-        for(size_t i = 0; i < DRoutesByIndex.size(); i++) {
-            if(i == index) {
-                return DRoutesByIndex[index];
-            }
-        }
+        return DRoutesByIndex[index];
     }
 
     std::shared_ptr<SRoute> RouteByName(const std::string &name) const noexcept{
@@ -299,8 +453,16 @@ CCSVBusSystem::CCSVBusSystem(std::shared_ptr< CDSVReader > stopsrc, std::shared_
     DImplementation = std::make_unique<SImplementation>(stopsrc,routesrc);
 }
 
+CCSVBusSystem::CCSVBusSystem(std::shared_ptr< CDataSource > stopsrc, std::shared_ptr< CDataSource > routesrc, char delimiter, std::size_t threads){
+    DImplementation = std::make_unique<SImplementation>(stopsrc,routesrc,delimiter,threads);
+}
+
 CCSVBusSystem::~CCSVBusSystem(){}
 
+std::string CCSVBusSystem::LoadError() const noexcept{
+    return DImplementation->DLoadError;
+}
+
 std::size_t CCSVBusSystem::StopCount() const noexcept{
     return DImplementation->StopCount();
 }
@@ -0,0 +1,44 @@
+#include "CachingDataFactory.h"
+#include "FileDataSink.h"
+
+CCachingDataFactory::CCachingDataFactory(const std::string &path) : CFileDataFactory(path){
+
+}
+
+std::shared_ptr< const CMappedFile > CCachingDataFactory::MapFile(const std::string &name) noexcept{
+    std::lock_guard<std::mutex> Lock(DMutex);
+    auto Search = DFiles.find(name);
+    if(Search != DFiles.end()){
+        return Search->second;
+    }
+    auto File = CFileDataFactory::MapFile(name);
+    // Missing files are not cached so they can show up later
+    if(!File->Contents().empty()){
+        DFiles[name] = File;
+    }
+    return File;
+}
+
+std::shared_ptr< CDataSink > CCachingDataFactory::CreateSink(const std::string &name) noexcept{
+    bool Cached;
+    {
+        std::lock_guard<std::mutex> Lock(DMutex);
+        Cached = DFiles.erase(name) != 0;
+    }
+    if(!Cached){
+        return CFileDataFactory::CreateSink(name);
+    }
+    // Truncating a mapped file would pull the pages out from under
+    // outstanding sources, so the sink puts a new file in its place
+    return std::make_shared<CFileDataSink>(DBasePath + name, CFileDataSink::DefaultBufferSize, CFileDataSink::EOpenMode::Replace);
+}
+
+std::size_t CCachingDataFactory::CachedCount() noexcept{
+    std::lock_guard<std::mutex> Lock(DMutex);
+    return DFiles.size();
+}
+
+void CCachingDataFactory::Clear() noexcept{
+    std::lock_guard<std::mutex> Lock(DMutex);
+    DFiles.clear();
+}
@@ -0,0 +1,121 @@
+#include "ConcatenatedDataSource.h"
+
+namespace{
+    const char NewLine[] = "\n";
+}
+
+CConcatenatedDataSource::CConcatenatedDataSource(std::vector< std::shared_ptr< CDataSource > > sources, bool skipheaders, bool joinlines) : DSources(std::move(sources)), DCurrent(0), DPendingNewLine(false), DSkipHeaders(skipheaders), DJoinLines(joinlines), DEmitted(false), DLastChar('\n'){
+
+}
+
+// Moves on to the next source, dropping its header if one has already been
+// passed through from an earlier source
+void CConcatenatedDataSource::Advance() const noexcept{
+    DCurrent++;
+    if(DSkipHeaders && DEmitted && (DCurrent < DSources.size())){
+        std::string Header;
+        DSources[DCurrent]->ReadLine(Header);
+    }
+}
+
+// Skips exhausted sources so End() is accurate, queueing a joining newline
+// if the data before the switch was not newline terminated
+void CConcatenatedDataSource::Settle() const noexcept{
+    bool Switched = false;
+    while((DCurrent < DSources.size()) && DSources[DCurrent]->End()){
+        Advance();
+        Switched = true;
+    }
+    if(Switched && DJoinLines && DEmitted && (DLastChar != '\n') && (DCurrent < DSources.size())){
+        DPendingNewLine = true;
+    }
+}
+
+void CConcatenatedDataSource::Emitted(char ch) noexcept{
+    DEmitted = true;
+    DLastChar = ch;
+}
+
+bool CConcatenatedDataSource::Failed() const noexcept{
+    for(std::size_t Index = 0; (Index <= DCurrent) && (Index < DSources.size()); Index++){
+        if(DSources[Index]->Failed()){
+            return true;
+        }
+    }
+    return false;
+}
+
+bool CConcatenatedDataSource::End() const noexcept{
+    Settle();
+    return !DPendingNewLine && (DCurrent >= DSources.size());
+}
+
+bool CConcatenatedDataSource::Get(char &ch) noexcept{
+    Settle();
+    if(DPendingNewLine){
+        DPendingNewLine = false;
+        ch = '\n';
+        Emitted(ch);
+        return true;
+    }
+    if((DCurrent >= DSources.size()) || !DSources[DCurrent]->Get(ch)){
+        return false;
+    }
+    Emitted(ch);
+    return true;
+}
+
+bool CConcatenatedDataSource::Peek(char &ch) noexcept{
+    Settle();
+    if(DPendingNewLine){
+        ch = '\n';
+        return true;
+    }
+    return (DCurrent < DSources.size()) && DSources[DCurrent]->Peek(ch);
+}
+
+bool CConcatenatedDataSource::Read(std::vector<char> &buf, std::size_t count) noexcept{
+    buf.resize(count);
+    buf.resize(ReadSpan(buf));
+    return !buf.empty();
+}
+
+std::size_t CConcatenatedDataSource::ReadSpan(std::span<char> buf) noexcept{
+    std::size_t Total = 0;
+    while((Total < buf.size()) && !End()){
+        if(DPendingNewLine){
+            DPendingNewLine = false;
+            buf[Total++] = '\n';
+            Emitted('\n');
+            continue;
+        }
+        std::size_t Length = DSources[DCurrent]->ReadSpan(buf.subspan(Total));
+        if(Length){
+            Total += Length;
+            Emitted(buf[Total - 1]);
+        }
+        else{
+            // A source that stops producing without reaching its end has
+            // failed, treat it as finished rather than spinning on it
+            Advance();
+        }
+    }
+    return Total;
+}
+
+bool CConcatenatedDataSource::Borrow(std::span<const char> &span, std::size_t count) noexcept{
+    if(!count || End()){
+        return false;
+    }
+    if(DPendingNewLine){
+        DPendingNewLine = false;
+        span = std::span<const char>(NewLine, 1);
+        Emitted('\n');
+        return true;
+    }
+    if(!DSources[DCurrent]->Borrow(span, count)){
+        return false;
+    }
+    Emitted(span.back());
+    return true;
+}
@@ -0,0 +1,139 @@
+#include "DSVColumnReader.h"
+#include <charconv>
+
+namespace DSVFields{
+
+namespace{
+
+std::string_view Trim(std::string_view text) noexcept{
+    const char *Whitespace = " \t\r";
+    auto First = text.find_first_not_of(Whitespace);
+    if(First == std::string_view::npos){
+        return std::string_view();
+    }
+    return text.substr(First, text.find_last_not_of(Whitespace) - First + 1);
+}
+
+template <typename T> bool ParseNumber(std::string_view text, T &value) noexcept{
+    text = Trim(text);
+    T Result;
+    auto [End, Error] = std::from_chars(text.data(), text.data() + text.size(), Result);
+    if(text.empty() || (Error != std::errc()) || (End != text.data() + text.size())){
+        return false;
+    }
+    value = Result;
+    return true;
+}
+
+}
+
+bool ParseUInt64(std::string_view text, uint64_t &value) noexcept{
+    return ParseNumber(text, value);
+}
+
+bool ParseInt64(std::string_view text, int64_t &value) noexcept{
+    return ParseNumber(text, value);
+}
+
+bool ParseDouble(std::string_view text, double &value) noexcept{
+    return ParseNumber(text, value);
+}
+
+}
+
+CIntegerListDecoder::CIntegerListDecoder(std::string_view text, char separator) : DText(text), DSeparator(separator), DOffset(0), DFailed(false){
+
+}
+
+bool CIntegerListDecoder::Next(uint64_t &value) noexcept{
+    if(DFailed || (DOffset > DText.size())){
+        return false;
+    }
+    // An empty list has no entries, while an empty entry within a list is malformed
+    if((DOffset == 0) && (DText.find_first_not_of(" \t\r") == std::string_view::npos)){
+        DOffset = DText.size() + 1;
+        return false;
+    }
+    auto Separator = DText.find(DSeparator, DOffset);
+    if(Separator == std::string_view::npos){
+        Separator = DText.size();
+    }
+    if(!DSVFields::ParseUInt64(DText.substr(DOffset, Separator - DOffset), value)){
+        DFailed = true;
+        return false;
+    }
+    DOffset = Separator + 1;
+    return true;
+}
+
+bool CIntegerListDecoder::Failed() const noexcept{
+    return DFailed;
+}
+
+CDSVColumnReader::CDSVColumnReader(std::shared_ptr< CDSVReader > reader) : DReader(reader), DRowCount(0){
+    DHeaderValid = DReader->ReadRowView(DRow);
+    for(auto &Name : DRow){
+        DHeader.emplace_back(Name);
+    }
+    DRow.clear();
+}
+
+CDSVColumnReader::CDSVColumnReader(std::shared_ptr< CDSVReader > reader, std::vector< std::string > header) : DReader(reader), DHeader(std::move(header)), DRowCount(0), DHeaderValid(true){
+
+}
+
+bool CDSVColumnReader::HeaderValid() const noexcept{
+    return DHeaderValid;
+}
+
+const std::vector< std::string > &CDSVColumnReader::Header() const noexcept{
+    return DHeader;
+}
+
+std::size_t CDSVColumnReader::Column(std::string_view name) const noexcept{
+    for(std::size_t Index = 0; Index < DHeader.size(); Index++){
+        if(DHeader[Index] == name){
+            return Index;
+        }
+    }
+    return InvalidColumn;
+}
+
+bool CDSVColumnReader::NextRow(){
+    if(!DHeaderValid){
+        return false;
+    }
+    if(!DReader->ReadRowView(DRow)){
+        return false;
+    }
+    DRowCount++;
+    return true;
+}
+
+std::size_t CDSVColumnReader::RowCount() const noexcept{
+    return DRowCount;
+}
+
+std::size_t CDSVColumnReader::ValueCount() const noexcept{
+    return DRow.size();
+}
+
+bool CDSVColumnReader::HasValue(std::size_t column) const noexcept{
+    return column < DRow.size();
+}
+
+std::string_view CDSVColumnReader::Value(std::size_t column) const noexcept{
+    return column < DRow.size() ? DRow[column] : std::string_view();
+}
+
+bool CDSVColumnReader::GetUInt64(std::size_t column, uint64_t &value) const noexcept{
+    return HasValue(column) && DSVFields::ParseUInt64(DRow[column], value);
+}
+
+bool CDSVColumnReader::GetInt64(std::size_t column, int64_t &value) const noexcept{
+    return HasValue(column) && DSVFields::ParseInt64(DRow[column], value);
+}
+
+bool CDSVColumnReader::GetDouble(std::size_t column, double &value) const noexcept{
+    return HasValue(column) && DSVFields::ParseDouble(DRow[column], value);
+}
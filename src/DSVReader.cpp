@@ -1,139 +1,333 @@
 #include "DSVReader.h"
-#include <iostream>
+#include "ByteScan.h"
+#include <array>
+#include <cstring>
 
+namespace{
+    constexpr std::size_t kReadBufferSize = 65536;
+    constexpr std::size_t kBorrowSize = 65536;
+}
+
+// Works through the source a block at a time. Outside of quotes the next
+// delimiter, quote or newline is located with ByteScan so plain runs of a
+// field are appended in one go; inside quotes only the next quote matters.
+// Values never grow past the maximum field length, only DOverflow records
+// that some of the value was dropped.
 struct CDSVReader::SImplementation{
-    std::shared_ptr< CDataSource > DSrc;
-    char DDelimiter;
-    bool DNewline;
-    bool DIsClosedQuote;
-
-    SImplementation(std::shared_ptr< CDataSource > src, char delimiter) {
-        DSrc = src; // data source
-        DDelimiter = delimiter;
-        DNewline = false;
-        DIsClosedQuote = false;
+    // Location of a view value, either in the current block or in DScratch
+    struct SField{
+        bool DInScratch;
+        std::size_t DOffset;
+        std::size_t DLength;
     };
 
-    bool ParseValue(std::string &val) {
-        // reset flags before parsing
-        bool inQuotes = false;
-        DIsClosedQuote = false;
-        bool beginParse = false;
-        DNewline = false;
+    std::shared_ptr< CDataSource > DSource;
+    // Where the source stood when the reader was created, positions count
+    // from there; the source is only seeked if this is known
+    bool DSourceSeekable;
+    std::size_t DSourceStart;
+    char DDelimiter;
+    char DSpecial[3];
+    std::span<const char> DBlock;
+    std::size_t DBlockStart;
+    std::size_t DOffset;
+    std::size_t DRowCount;
+    std::size_t DMaxFieldLength;
+    EFieldOverflow DOverflowPolicy;
+    bool DOverflow;
+    bool DFailed;
+    std::array<char, kReadBufferSize> DBuffer;
+    std::vector< SField > DFields;
+    std::string DScratch;
+    std::vector< std::string > DValues;
+
+    SImplementation(std::shared_ptr< CDataSource > src, char delimiter, std::size_t maxfieldlength, EFieldOverflow overflow){
+        DSource = src;
+        DSourceStart = 0;
+        DSourceSeekable = DSource->Tell(DSourceStart);
+        // a double quote cannot delimit since it starts quoted values
+        DDelimiter = delimiter == '\"' ? ',' : delimiter;
+        DSpecial[0] = DDelimiter;
+        DSpecial[1] = '\"';
+        DSpecial[2] = '\n';
+        DBlockStart = 0;
+        DOffset = 0;
+        DRowCount = 0;
+        DMaxFieldLength = maxfieldlength;
+        DOverflowPolicy = overflow;
+        DOverflow = false;
+        DFailed = false;
+    }
+
+    // Makes sure unread bytes are available, returns false at end of source
+    bool Fill(){
+        if(DOffset < DBlock.size()){
+            return true;
+        }
+        DBlockStart += DBlock.size();
+        DOffset = 0;
+        if(DSource->Borrow(DBlock, kBorrowSize)){
+            return true;
+        }
+        DBlock = std::span<const char>(DBuffer.data(), DSource->ReadSpan(DBuffer));
+        return !DBlock.empty();
+    }
+
+    void AppendValue(std::string &val, const char *data, std::size_t length){
+        std::size_t Room = DMaxFieldLength - val.size();
+        if(length > Room){
+            DOverflow = true;
+            length = Room;
+        }
+        val.append(data, length);
+    }
+
+    // Parses one value into val, returning false if nothing was left to
+    // consume. endofrow is set when the value was terminated by a newline.
+    bool ParseValue(std::string &val, bool &endofrow){
+        bool InQuotes = false;
+        bool QuotePending = false;
+        bool Consumed = false;
         val.clear();
+        endofrow = false;
 
-        while(!DSrc->End()) {
-            std::cout << "current value: " << val << std::endl;
-            char nextChar;
-            DSrc->Peek(nextChar);
-
-            if(inQuotes) {
-                DSrc->Get(nextChar);
-                beginParse = true;
-
-                if(nextChar == '\"') {
-                    std::cout << "found another quote" << std::endl;
-                    // if we found another quote, it may be a " replaced with "" OR a regular ending quote
-                    char nextNextChar;
-                    // if the current next char = " and the next next char is also ", then we consume both, since it was OG just "
-                    if(!DSrc->End() && DSrc->Peek(nextNextChar) && nextNextChar =='\"') {
-                        std::cout << "quote was replaced" << std::endl;
-                        DSrc->Get(nextNextChar); 
-                        val += '\"';
-                    } else { // true ending quote
-                        std::cout << "quote was true ending" << std::endl;
-                        inQuotes = false;
-                        DIsClosedQuote = true;
-                    }
-                } else { 
-                    std::cout << "in quote, regular value: " << nextChar << std::endl;
-                    val += nextChar;
+        while(Fill()){
+            const char *Data = DBlock.data() + DOffset;
+            std::size_t Available = DBlock.size() - DOffset;
+            Consumed = true;
+            if(QuotePending){
+                // a quote inside quotes ended the previous block, "" is an
+                // escaped quote while anything else closes the quotes
+                QuotePending = false;
+                if(*Data == '\"'){
+                    AppendValue(val, Data, 1);
+                    DOffset++;
+                }
+                else{
+                    InQuotes = false;
                 }
-                continue; //keep reading until we hit one of our cases
+                continue;
             }
-
-            if(nextChar == DDelimiter) {
-                std::cout << "delimiter found in DString" << std::endl;
-                DSrc->Get(nextChar); // consume
-                beginParse = true;
-                return true;
-            } else if (nextChar == '\n') {
-                std::cout << "newline found in DString" << std::endl;
-                DSrc->Get(nextChar); // consume
-                DNewline = true; // set flag to true so we can successfully say we read row in ReadRow()
-                beginParse = true;
-                return true;
-            } else if(nextChar == '\"' && !inQuotes) {
-                inQuotes = true; // if we are in quotes, we dont want to consme delimiter and make new column
-                std::cout << "quotes found" << std::endl;
-                DSrc->Get(nextChar); // consume quote
-                beginParse = true;
+            if(InQuotes){
+                auto Quote = static_cast<const char *>(std::memchr(Data, '\"', Available));
+                if(!Quote){
+                    AppendValue(val, Data, Available);
+                    DOffset += Available;
+                    continue;
+                }
+                AppendValue(val, Data, Quote - Data);
+                DOffset += Quote - Data + 1;
+                if(DOffset == DBlock.size()){
+                    QuotePending = true;
+                }
+                else if(DBlock[DOffset] == '\"'){
+                    AppendValue(val, Quote, 1);
+                    DOffset++;
+                }
+                else{
+                    InQuotes = false;
+                }
+                continue;
+            }
+            std::size_t Length = ByteScan::FindAny(std::string_view(Data, Available), std::string_view(DSpecial, 3));
+            AppendValue(val, Data, Length);
+            DOffset += Length;
+            if(Length == Available){
                 continue;
             }
-            else {
-                DSrc->Get(nextChar);
-                val += nextChar;
-                beginParse = true;
+            char Ch = Data[Length];
+            DOffset++;
+            if(Ch == DDelimiter){
+                return true;
+            }
+            if(Ch == '\n'){
+                endofrow = true;
+                return true;
             }
+            InQuotes = true;
         }
-        return beginParse;
+        return Consumed;
     }
 
-    ~SImplementation(){}
+    bool End(){
+        return DFailed || !Fill();
+    }
+
+    // Parses a row that lies entirely within the current block without
+    // copying, only quoted values holding "" are unescaped into DScratch.
+    // Returns false, leaving the position untouched, for rows that cross the
+    // end of the block or have quotes in the middle of a value.
+    bool ParseBlockRow(){
+        const char *Data = DBlock.data();
+        std::size_t Size = DBlock.size();
+        std::size_t Position = DOffset;
+        std::string_view Special(DSpecial, 3);
+        DFields.clear();
+        DScratch.clear();
+
+        while(true){
+            char Terminator;
+            if((Position < Size) && (Data[Position] == '\"')){
+                std::size_t Start = Position + 1;
+                std::size_t Search = Start;
+                bool Escaped = false;
+                const char *Quote;
+                while(true){
+                    Quote = static_cast<const char *>(std::memchr(Data + Search, '\"', Size - Search));
+                    if(!Quote || (Quote + 1 == Data + Size)){
+                        return false;
+                    }
+                    if(Quote[1] != '\"'){
+                        break;
+                    }
+                    Escaped = true;
+                    Search = Quote - Data + 2;
+                }
+                std::size_t Length = Quote - (Data + Start);
+                if(Escaped){
+                    std::size_t ScratchOffset = DScratch.size();
+                    for(std::size_t Index = Start; Index < Start + Length; Index++){
+                        DScratch += Data[Index];
+                        if(Data[Index] == '\"'){
+                            Index++;
+                        }
+                    }
+                    DFields.push_back({true, ScratchOffset, DScratch.size() - ScratchOffset});
+                }
+                else{
+                    DFields.push_back({false, Start, Length});
+                }
+                Position = Start + Length + 1;
+                Terminator = Data[Position];
+                if((Terminator != DDelimiter) && (Terminator != '\n')){
+                    return false;
+                }
+            }
+            else{
+                std::size_t Length = ByteScan::FindAny(std::string_view(Data + Position, Size - Position), Special);
+                if(Position + Length == Size){
+                    return false;
+                }
+                Terminator = Data[Position + Length];
+                if(Terminator == '\"'){
+                    return false;
+                }
+                DFields.push_back({false, Position, Length});
+                Position += Length;
+            }
+            Position++;
+            if(Terminator != DDelimiter){
+                DOffset = Position;
+                return true;
+            }
+        }
+    }
 
-    bool End() const {
-        // return true if everything has been read from DSV
-        char curr_char;
-        if(!DSrc->Peek(curr_char)) {
-            // if we try to get curr char and it returns false, index > length so we are at EOF
-            std::cout << "END OF FILE" << std::endl;
+    // Applies the overflow policy to a row just read, returning whether to
+    // hand it out. Fail leaves the reader failed.
+    bool AcceptRow(bool overflow){
+        DRowCount++;
+        if(!overflow || (DOverflowPolicy == EFieldOverflow::Truncate)){
             return true;
         }
+        if(DOverflowPolicy == EFieldOverflow::Fail){
+            DFailed = true;
+        }
         return false;
     }
 
-    bool ReadRow(std::vector<std::string> &row) {
-        if (DDelimiter == '\"') {
-            DDelimiter = ',';
-        }
-        std::cout << "READING ROW..." << std::endl;
-        DNewline = false;
+    bool ReadRowView(std::vector<std::string_view> &row){
         row.clear();
+        while(!DFailed && Fill()){
+            if(!ParseBlockRow()){
+                if(!ReadRow(DValues)){
+                    return false;
+                }
+                for(auto &Value : DValues){
+                    row.emplace_back(Value);
+                }
+                return true;
+            }
+            bool Overflow = false;
+            for(auto &Field : DFields){
+                if(Field.DLength > DMaxFieldLength){
+                    Overflow = true;
+                    Field.DLength = DMaxFieldLength;
+                }
+            }
+            if(AcceptRow(Overflow)){
+                for(auto &Field : DFields){
+                    row.emplace_back((Field.DInScratch ? DScratch.data() : DBlock.data()) + Field.DOffset, Field.DLength);
+                }
+                return true;
+            }
+        }
+        return false;
+    }
+
+    bool ParseRow(std::vector<std::string> &row){
+        // Values are parsed in place so strings of a reused row keep their capacity
+        std::size_t Count = 0;
+        bool EndOfRow = false;
+        bool HaveRow = false;
+
+        while(!EndOfRow && Fill()){
+            HaveRow = true;
+            if(Count == row.size()){
+                row.emplace_back();
+            }
+            if(ParseValue(row[Count], EndOfRow)){
+                Count++;
+            }
+        }
+        row.resize(Count);
+        return HaveRow;
+    }
 
-        char curr_char;
-        std::string curr_row = "";
-        std::cout << "at eof? " << DSrc->End() << std::endl;
-
-        while(!DSrc->End()) {
-            // std::cout << "reading current char is: " << curr_char << std::endl;
-            std::string nextValue;
-
-            if(ParseValue(nextValue)) {
-                std::cout << "pushing " << nextValue << " into row" << std::endl;
-                if(DIsClosedQuote) {
-                    std::cout << "final row is: " << nextValue << std::endl;
-                    row.push_back(nextValue);
-                } else {
-                    std::cout << "final row is: " << nextValue << std::endl;
-                    row.push_back(nextValue);
-                }
-            } 
-            if(DNewline) {
-                    std::cout << "found newline, done with row" << std::endl;
-                    return true;
-            }
-            
-            if(DSrc->End()) {
+    bool ReadRow(std::vector<std::string> &row){
+        while(!DFailed){
+            DOverflow = false;
+            if(!ParseRow(row)){
+                return false;
+            }
+            if(AcceptRow(DOverflow)){
                 return true;
             }
         }
-        return false; // if we are at end
+        row.clear();
+        return false;
     }
 
+    bool Seek(const SPosition &position){
+        std::size_t Target = position.DOffset;
+        if((DBlockStart <= Target) && (Target <= DBlockStart + DBlock.size())){
+            DOffset = Target - DBlockStart;
+        }
+        else if(DSourceSeekable && DSource->Seek(DSourceStart + Target)){
+            DBlockStart = Target;
+            DBlock = std::span<const char>();
+            DOffset = 0;
+        }
+        else{
+            // no going back without Seek, otherwise read up to the target
+            if(Target < DBlockStart){
+                return false;
+            }
+            while(DBlockStart + DOffset < Target){
+                if(!Fill()){
+                    return false;
+                }
+                DOffset += std::min(DBlock.size() - DOffset, Target - DBlockStart - DOffset);
+            }
+        }
+        DRowCount = position.DRow;
+        DFailed = false;
+        return true;
+    }
 };
 
-CDSVReader::CDSVReader(std::shared_ptr< CDataSource > src, char delimiter) {
-    DImplementation = std::make_unique<SImplementation>(src, delimiter);
+CDSVReader::CDSVReader(std::shared_ptr< CDataSource > src, char delimiter, std::size_t maxfieldlength, EFieldOverflow overflow) {
+    DImplementation = std::make_unique<SImplementation>(src, delimiter, maxfieldlength, overflow);
 }
 
 CDSVReader::~CDSVReader() {
@@ -144,6 +338,64 @@ bool CDSVReader::End() const {
     return DImplementation->End();
 }
 
+bool CDSVReader::Failed() const {
+    return DImplementation->DFailed;
+}
+
+CDSVReader::SPosition CDSVReader::Position() const {
+    return {DImplementation->DBlockStart + DImplementation->DOffset, DImplementation->DRowCount};
+}
+
+bool CDSVReader::Seek(const SPosition &position) {
+    return DImplementation->Seek(position);
+}
+
 bool CDSVReader::ReadRow(std::vector<std::string> &row) {
     return DImplementation->ReadRow(row);
 }
+
+bool CDSVReader::ReadRowView(std::vector<std::string_view> &row) {
+    return DImplementation->ReadRowView(row);
+}
+
+std::vector< std::string_view > CDSVReader::SplitRows(std::string_view data, std::size_t count) {
+    std::vector< std::string_view > Pieces;
+    std::size_t PieceStart = 0;
+    std::size_t Position = 0;
+    bool InQuotes = false;
+    for(std::size_t Index = 1; (Index < count) && (Position < data.size()); Index++){
+        // Quote parity up to the nominal split point tells whether it is quoted
+        std::size_t Target = data.size() / count * Index;
+        while(Position < Target){
+            auto Quote = static_cast<const char *>(std::memchr(data.data() + Position, '\"', Target - Position));
+            if(!Quote){
+                Position = Target;
+                break;
+            }
+            InQuotes = !InQuotes;
+            Position = Quote - data.data() + 1;
+        }
+        // then move on to the next newline outside of quotes
+        while(Position < data.size()){
+            std::size_t Length = ByteScan::FindAny(data.substr(Position), InQuotes ? "\"" : "\"\n");
+            if(Position + Length == data.size()){
+                Position = data.size();
+                break;
+            }
+            char Ch = data[Position + Length];
+            Position += Length + 1;
+            if(Ch == '\"'){
+                InQuotes = !InQuotes;
+            }
+            else{
+                break;
+            }
+        }
+        if(Position < data.size()){
+            Pieces.push_back(data.substr(PieceStart, Position - PieceStart));
+            PieceStart = Position;
+        }
+    }
+    Pieces.push_back(data.substr(PieceStart));
+    return Pieces;
+}
@@ -0,0 +1,326 @@
+#include "DSVTable.h"
+#include "DSVColumnReader.h"
+#include <charconv>
+#include <deque>
+#include <type_traits>
+#include <unordered_map>
+
+// Every column starts out as Integer and is widened to Double or String by
+// the first value that does not fit. If it turns into a string column the
+// dictionary is built from the values already read, printed back as text.
+// Only values whose text does not print back that way, such as "007" or
+// "1.50", keep their text until then.
+struct CDSVTable::SImplementation{
+    struct SColumn{
+        EColumnType DType = EColumnType::Integer;
+        bool DSawValue = false;
+        std::vector< bool > DPresent;
+        std::vector< int64_t > DIntegers;
+        std::vector< double > DDoubles;
+        std::vector< TStringID > DStringIDs;
+        // deque so the lookup keys stay valid as strings are added
+        std::deque< std::string > DStrings;
+        std::unordered_map< std::string_view, TStringID > DStringLookup;
+        // rows in order, only for values whose text is not how they print
+        std::vector< std::pair< std::size_t, std::string > > DIrregularText;
+
+        // Text of value as a file would normally hold it, empty if it does not fit
+        template <typename T> static std::string_view Print(T value, char (&buffer)[32]){
+            std::to_chars_result Result;
+            if constexpr(std::is_floating_point_v<T>){
+                Result = std::to_chars(buffer, buffer + sizeof(buffer), value, std::chars_format::fixed);
+            }
+            else{
+                Result = std::to_chars(buffer, buffer + sizeof(buffer), value);
+            }
+            return Result.ec == std::errc() ? std::string_view(buffer, Result.ptr - buffer) : std::string_view();
+        }
+
+        template <typename T> void NoteText(T value, std::string_view text){
+            char Buffer[32];
+            if(Print(value, Buffer) != text){
+                DIrregularText.emplace_back(DPresent.size() - 1, text);
+            }
+        }
+
+        TStringID Intern(std::string_view value){
+            auto Search = DStringLookup.find(value);
+            if(Search != DStringLookup.end()){
+                return Search->second;
+            }
+            TStringID NewID = DStrings.size();
+            DStrings.emplace_back(value);
+            DStringLookup.emplace(DStrings.back(), NewID);
+            return NewID;
+        }
+
+        void MakeDouble(){
+            DType = EColumnType::Double;
+            DDoubles.assign(DIntegers.begin(), DIntegers.end());
+            // integers beyond 2^53 may print differently as doubles, so they
+            // keep their text as well
+            constexpr int64_t Exact = int64_t(1) << 53;
+            std::vector< std::pair< std::size_t, std::string > > Irregular;
+            std::size_t Next = 0;
+            for(std::size_t Row = 0; Row < DIntegers.size(); Row++){
+                if((Next < DIrregularText.size()) && (DIrregularText[Next].first == Row)){
+                    Irregular.push_back(std::move(DIrregularText[Next++]));
+                }
+                else if(DPresent[Row] && ((DIntegers[Row] > Exact) || (DIntegers[Row] < -Exact))){
+                    char Buffer[32];
+                    Irregular.emplace_back(Row, Print(DIntegers[Row], Buffer));
+                }
+            }
+            DIrregularText.swap(Irregular);
+            std::vector< int64_t >().swap(DIntegers);
+        }
+
+        // Builds the dictionary for the first rows, read as numbers so far
+        void MakeString(std::size_t rows){
+            std::size_t Next = 0;
+            for(std::size_t Row = 0; Row < rows; Row++){
+                char Buffer[32];
+                std::string_view Text;
+                if((Next < DIrregularText.size()) && (DIrregularText[Next].first == Row)){
+                    Text = DIrregularText[Next++].second;
+                }
+                else if(DPresent[Row]){
+                    Text = DType == EColumnType::Integer ? Print(DIntegers[Row], Buffer) : Print(DDoubles[Row], Buffer);
+                }
+                DStringIDs.push_back(Intern(Text));
+            }
+            DType = EColumnType::String;
+            std::vector< int64_t >().swap(DIntegers);
+            std::vector< double >().swap(DDoubles);
+            std::vector< std::pair< std::size_t, std::string > >().swap(DIrregularText);
+        }
+
+        void Append(std::string_view value, bool present){
+            DPresent.push_back(present);
+            DSawValue |= present;
+            if(DType == EColumnType::Integer){
+                int64_t Value = 0;
+                if(!present || DSVFields::ParseInt64(value, Value)){
+                    DIntegers.push_back(Value);
+                    if(present){
+                        NoteText(Value, value);
+                    }
+                    return;
+                }
+                // too large for int64_t is better kept exact as a string than rounded to a double
+                uint64_t Unsigned;
+                double Double;
+                if(DSVFields::ParseUInt64(value, Unsigned) || !DSVFields::ParseDouble(value, Double)){
+                    MakeString(DPresent.size() - 1);
+                }
+                else{
+                    MakeDouble();
+                }
+            }
+            if(DType == EColumnType::Double){
+                double Value = 0.0;
+                if(!present || DSVFields::ParseDouble(value, Value)){
+                    DDoubles.push_back(Value);
+                    if(present){
+                        NoteText(Value, value);
+                    }
+                    return;
+                }
+                MakeString(DPresent.size() - 1);
+            }
+            DStringIDs.push_back(Intern(value));
+        }
+
+        void Finish(){
+            // nothing to go by for a column without values, call it text
+            if(!DSawValue && (DType != EColumnType::String)){
+                MakeString(DPresent.size());
+            }
+            std::vector< std::pair< std::size_t, std::string > >().swap(DIrregularText);
+        }
+    };
+
+    bool DHeaderValid;
+    std::vector< std::string > DHeader;
+    std::unordered_map< std::string_view, std::size_t > DColumnLookup;
+    std::vector< SColumn > DColumns;
+    std::size_t DRowCount;
+
+    SImplementation(std::shared_ptr< CDSVReader > reader, const std::vector< std::string > &stringcolumns){
+        std::vector< std::string_view > Row;
+        DRowCount = 0;
+        DHeaderValid = reader->ReadRowView(Row);
+        for(auto &Name : Row){
+            DHeader.emplace_back(Name);
+        }
+        for(std::size_t Index = 0; Index < DHeader.size(); Index++){
+            // emplace leaves the first of repeated names in place
+            DColumnLookup.emplace(DHeader[Index], Index);
+        }
+        DColumns.resize(DHeader.size());
+        for(auto &Name : stringcolumns){
+            auto Index = Column(Name);
+            if(Index != InvalidColumn){
+                DColumns[Index].DType = EColumnType::String;
+            }
+        }
+        while(DHeaderValid && reader->ReadRowView(Row)){
+            for(std::size_t Index = 0; Index < DColumns.size(); Index++){
+                bool Present = (Index < Row.size()) && !Row[Index].empty();
+                DColumns[Index].Append(Present ? Row[Index] : std::string_view(), Present);
+            }
+            DRowCount++;
+        }
+        for(auto &Column : DColumns){
+            Column.Finish();
+        }
+    }
+
+    std::size_t Column(std::string_view name) const noexcept{
+        auto Search = DColumnLookup.find(name);
+        return Search == DColumnLookup.end() ? InvalidColumn : Search->second;
+    }
+
+    const SColumn *ColumnOfType(std::size_t column, EColumnType type) const noexcept{
+        return (column < DColumns.size()) && (DColumns[column].DType == type) ? &DColumns[column] : nullptr;
+    }
+
+    bool HasValue(std::size_t column, std::size_t row) const noexcept{
+        return (column < DColumns.size()) && (row < DRowCount) && DColumns[column].DPresent[row];
+    }
+
+    std::string_view StringByID(std::size_t column, TStringID id) const noexcept{
+        auto StringColumn = ColumnOfType(column, EColumnType::String);
+        return StringColumn && (id < StringColumn->DStrings.size()) ? std::string_view(StringColumn->DStrings[id]) : std::string_view();
+    }
+
+    std::string_view String(std::size_t column, std::size_t row) const noexcept{
+        auto StringColumn = ColumnOfType(column, EColumnType::String);
+        return StringColumn && (row < DRowCount) ? std::string_view(StringColumn->DStrings[StringColumn->DStringIDs[row]]) : std::string_view();
+    }
+
+    template <typename T> bool GetInteger(std::size_t column, std::size_t row, T &value) const noexcept{
+        if(!HasValue(column, row)){
+            return false;
+        }
+        auto &Column = DColumns[column];
+        if(Column.DType == EColumnType::Integer){
+            auto Value = Column.DIntegers[row];
+            if(std::is_unsigned_v<T> && (Value < 0)){
+                return false;
+            }
+            value = Value;
+            return true;
+        }
+        if(Column.DType == EColumnType::String){
+            if constexpr(std::is_unsigned_v<T>){
+                return DSVFields::ParseUInt64(String(column, row), value);
+            }
+            else{
+                return DSVFields::ParseInt64(String(column, row), value);
+            }
+        }
+        return false;
+    }
+
+    bool GetDouble(std::size_t column, std::size_t row, double &value) const noexcept{
+        if(!HasValue(column, row)){
+            return false;
+        }
+        auto &Column = DColumns[column];
+        if(Column.DType == EColumnType::Integer){
+            value = Column.DIntegers[row];
+            return true;
+        }
+        if(Column.DType == EColumnType::Double){
+            value = Column.DDoubles[row];
+            return true;
+        }
+        return DSVFields::ParseDouble(String(column, row), value);
+    }
+};
+
+CDSVTable::CDSVTable(std::shared_ptr< CDSVReader > reader, const std::vector< std::string > &stringcolumns){
+    DImplementation = std::make_unique<SImplementation>(reader, stringcolumns);
+}
+
+CDSVTable::~CDSVTable(){
+
+}
+
+bool CDSVTable::HeaderValid() const noexcept{
+    return DImplementation->DHeaderValid;
+}
+
+const std::vector< std::string > &CDSVTable::Header() const noexcept{
+    return DImplementation->DHeader;
+}
+
+std::size_t CDSVTable::ColumnCount() const noexcept{
+    return DImplementation->DColumns.size();
+}
+
+std::size_t CDSVTable::RowCount() const noexcept{
+    return DImplementation->DRowCount;
+}
+
+std::size_t CDSVTable::Column(std::string_view name) const noexcept{
+    return DImplementation->Column(name);
+}
+
+CDSVTable::EColumnType CDSVTable::ColumnType(std::size_t column) const noexcept{
+    return column < DImplementation->DColumns.size() ? DImplementation->DColumns[column].DType : EColumnType::String;
+}
+
+bool CDSVTable::HasValue(std::size_t column, std::size_t row) const noexcept{
+    return DImplementation->HasValue(column, row);
+}
+
+std::span< const int64_t > CDSVTable::Integers(std::size_t column) const noexcept{
+    auto IntegerColumn = DImplementation->ColumnOfType(column, EColumnType::Integer);
+    return IntegerColumn ? std::span< const int64_t >(IntegerColumn->DIntegers) : std::span< const int64_t >();
+}
+
+std::span< const double > CDSVTable::Doubles(std::size_t column) const noexcept{
+    auto DoubleColumn = DImplementation->ColumnOfType(column, EColumnType::Double);
+    return DoubleColumn ? std::span< const double >(DoubleColumn->DDoubles) : std::span< const double >();
+}
+
+std::span< const CDSVTable::TStringID > CDSVTable::StringIDs(std::size_t column) const noexcept{
+    auto StringColumn = DImplementation->ColumnOfType(column, EColumnType::String);
+    return StringColumn ? std::span< const TStringID >(StringColumn->DStringIDs) : std::span< const TStringID >();
+}
+
+std::size_t CDSVTable::StringCount(std::size_t column) const noexcept{
+    auto StringColumn = DImplementation->ColumnOfType(column, EColumnType::String);
+    return StringColumn ? StringColumn->DStrings.size() : 0;
+}
+
+std::string_view CDSVTable::StringByID(std::size_t column, TStringID id) const noexcept{
+    return DImplementation->StringByID(column, id);
+}
+
+CDSVTable::TStringID CDSVTable::FindString(std::size_t column, std::string_view value) const noexcept{
+    auto StringColumn = DImplementation->ColumnOfType(column, EColumnType::String);
+    if(!StringColumn){
+        return InvalidStringID;
+    }
+    auto Search = StringColumn->DStringLookup.find(value);
+    return Search == StringColumn->DStringLookup.end() ? InvalidStringID : Search->second;
+}
+
+std::string_view CDSVTable::String(std::size_t column, std::size_t row) const noexcept{
+    return DImplementation->String(column, row);
+}
+
+bool CDSVTable::GetUInt64(std::size_t column, std::size_t row, uint64_t &value) const noexcept{
+    return DImplementation->GetInteger(column, row, value);
+}
+
+bool CDSVTable::GetInt64(std::size_t column, std::size_t row, int64_t &value) const noexcept{
+    return DImplementation->GetInteger(column, row, value);
+}
+
+bool CDSVTable::GetDouble(std::size_t column, std::size_t row, double &value) const noexcept{
+    return DImplementation->GetDouble(column, row, value);
+}
@@ -1,98 +1,106 @@
 #include "DSVWriter.h"
-#include <iostream>
-#include "StringUtils.h"
-#include <string.h>
+#include "ByteScan.h"
+#include <cstring>
 
+// Rows are formatted straight into a reusable buffer. Each value is scanned
+// once for a quote, delimiter or newline; values without any are copied as
+// is, and only values holding a quote go through the "" escaping loop.
 struct CDSVWriter::SImplementation{
     std::shared_ptr< CDataSink > DSink;
     char DDelimiter;
+    char DSpecial[3];
     bool DQuoteAll;
     bool DHasRow;
-    bool DIsQuoted;
+    std::size_t DBatchSize;
+    std::string DBuffer;
 
-    SImplementation(std::shared_ptr< CDataSink > sink, char delimiter, bool quoteall){
+    SImplementation(std::shared_ptr< CDataSink > sink, char delimiter, bool quoteall, std::size_t batchsize){
         DSink = sink;
-        DDelimiter = delimiter;
+        // a double quote cannot delimit since it starts quoted values, treat as comma
+        DDelimiter = delimiter == '\"' ? ',' : delimiter;
+        DSpecial[0] = '\"';
+        DSpecial[1] = DDelimiter;
+        DSpecial[2] = '\n';
         DQuoteAll = quoteall;
         DHasRow = false; // for new rows
-        DIsQuoted = false; // to keep track of overlapping edge cases + whether or not to trigger quoteall Flag
+        DBatchSize = batchsize;
     }
 
-    ~SImplementation(){}
+    ~SImplementation(){
+        Flush();
+    }
 
-    bool WriteRow(const std::vector<std::string> &row){
-        bool FirstValue = true;
+    void AppendValue(std::string_view value){
+        std::size_t Special = ByteScan::FindAny(value, std::string_view(DSpecial, 3));
+        if((Special == value.size()) && !DQuoteAll){
+            DBuffer.append(value);
+            return;
+        }
+        DBuffer += '\"';
+        // replace " with "" from the first quote on, if there is one
+        std::size_t Start = 0;
+        std::size_t Quote = Special < value.size() ? value.find('\"', Special) : std::string_view::npos;
+        while(Quote != std::string_view::npos){
+            DBuffer.append(value.data() + Start, Quote + 1 - Start);
+            DBuffer += '\"';
+            Start = Quote + 1;
+            Quote = value.find('\"', Start);
+        }
+        DBuffer.append(value.data() + Start, value.size() - Start);
+        DBuffer += '\"';
+    }
 
+    template <typename TRow> void AppendRow(const TRow &row){
         if(DHasRow) { // before we write the next rows (if any), write \n
-            DSink->Put('\n');
+            DBuffer += '\n';
         }
-
-        // for each column, before we write anything at all, we need to make sure it goes through all edge cases.
+        bool FirstValue = true;
         for(auto &Column : row){
-            std::string quote = "\"";
-            std::string Buf = Column;
-            std::cout << "Column = " << Column << std::endl;
-
-            // if double quote is in the value
-            if (Column.find(quote) != std::string::npos) {
-                // we want to quote entire string AND replace " with ""
-                std::cout << "double quote present" << std::endl;
-
-                // replace " with ""
-                Buf =  StringUtils::Replace(Buf, std::string("\""), std::string("\"\""));
-                
-                // wrap with quotes
-                Buf = quote + Buf + quote;
-                // have flag if already quoted
-                DIsQuoted = true;
-
-                std::cout << Buf << std::endl;
-            }
-
-            // handle if delimiter is "
-            if (DDelimiter == '\"') {
-                // treat as comma
-                DDelimiter = ',';
-            }
-             // handle if delimiter is in value or newline is in value
-            else if (Column.find(DDelimiter) != std::string::npos || Column.find('\n') != std::string::npos) {
-                // if delim in value, we just want to quote the value
-                std::cout << "delim is in column or newline in columns" << std::endl;
-                if(!DIsQuoted) {
-                    Buf = quote + Buf + quote;
-                }
-                DIsQuoted = true;
-                std::cout<< "quoted = " << Buf << std::endl;
-            }
-
-             // only put delimiter after the first value
+            // only put delimiter after the first value
             if(!FirstValue){
-                DSink->Put(DDelimiter);
+                DBuffer += DDelimiter;
             }
+            AppendValue(Column);
+            FirstValue = false;
+        }
+        DHasRow = true;
+    }
 
-            // if value has not been quoted AND the quoteall flag is TRUE, wrap with quotes
-            if(!DIsQuoted && DQuoteAll) {
-                std::cout << "not yet quoted, DQA flag is on, adding quotes" << std::endl;
-                Buf = quote + Buf + quote;
-            }
+    bool Flush(){
+        if(DBuffer.empty()){
+            return true;
+        }
+        bool Result = DSink->WriteSpan(DBuffer);
+        DBuffer.clear();
+        return Result;
+    }
 
-            std::vector<char> Buffer(Buf.begin(), Buf.end());
+    // Hands the buffer over once the batch is full
+    bool Commit(){
+        return DBuffer.size() < DBatchSize ? true : Flush();
+    }
 
-            std::cout << "Final column = " << Buf << std::endl;
-            DSink->Write(Buffer);
+    bool WriteRow(const std::vector<std::string> &row){
+        AppendRow(row);
+        return Commit();
+    }
 
-            // reset flags
-            FirstValue = false;
-            DIsQuoted = false;
+    bool WriteRowView(std::span<const std::string_view> row){
+        AppendRow(row);
+        return Commit();
+    }
+
+    bool WriteRows(const std::vector< std::vector<std::string> > &rows){
+        for(auto &Row : rows){
+            AppendRow(Row);
         }
-        DHasRow = true;
-        return true;
+        return Flush();
     }
 
 };
 
-CDSVWriter::CDSVWriter(std::shared_ptr< CDataSink > sink, char delimiter, bool quoteall){
-    DImplementation = std::make_unique<SImplementation>(sink,delimiter,quoteall);
+CDSVWriter::CDSVWriter(std::shared_ptr< CDataSink > sink, char delimiter, bool quoteall, std::size_t batchsize){
+    DImplementation = std::make_unique<SImplementation>(sink,delimiter,quoteall,batchsize);
 }
 
 CDSVWriter::~CDSVWriter(){
@@ -102,3 +110,15 @@ CDSVWriter::~CDSVWriter(){
 bool CDSVWriter::WriteRow(const std::vector<std::string> &row){
     return DImplementation->WriteRow(row);
 }
+
+bool CDSVWriter::WriteRowView(std::span<const std::string_view> row){
+    return DImplementation->WriteRowView(row);
+}
+
+bool CDSVWriter::WriteRows(const std::vector< std::vector<std::string> > &rows){
+    return DImplementation->WriteRows(rows);
+}
+
+bool CDSVWriter::Flush(){
+    return DImplementation->Flush() && DImplementation->DSink->Flush();
+}
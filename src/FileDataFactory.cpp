@@ -1,8 +1,24 @@
 #include "FileDataFactory.h"
 #include "FileDataSource.h"
+#include "ConcatenatedDataSource.h"
 #include "FileDataSink.h"
+#include "GzipDataSource.h"
+#include "ReadAheadDataSource.h"
+#include <cstring>
 #include <filesystem>
 
+namespace{
+    // Compressed files are recognized by their .gz extension or, failing
+    // that, by the two byte gzip magic number at the start of the file.
+    bool IsCompressed(const std::string &name, std::span<const char> contents){
+        const std::string Extension = ".gz";
+        if((name.size() >= Extension.size()) && (name.compare(name.size() - Extension.size(), Extension.size(), Extension) == 0)){
+            return true;
+        }
+        return (contents.size() >= 2) && (contents[0] == '\x1f') && (contents[1] == '\x8b');
+    }
+}
+
 CFileDataFactory::CFileDataFactory(const std::string &path){
     if(path.empty()){
         DBasePath = "./";
@@ -12,8 +28,58 @@ CFileDataFactory::CFileDataFactory(const std::string &path){
     }
 }
 
+std::shared_ptr< CDataSource > CFileDataFactory::CreateFileSource(const std::string &name, std::shared_ptr< const CMappedFile > file) noexcept{
+    auto Source = std::make_shared<CFileDataSource>(file);
+    if(IsCompressed(name, file->Contents())){
+        // Inflate on a helper thread so decompression overlaps with parsing
+        return std::make_shared<CReadAheadDataSource>(std::make_shared<CGzipDataSource>(Source));
+    }
+    return Source;
+}
+
+std::shared_ptr< const CMappedFile > CFileDataFactory::MapFile(const std::string &name) noexcept{
+    return std::make_shared<CMappedFile>(DBasePath + name);
+}
+
 std::shared_ptr< CDataSource > CFileDataFactory::CreateSource(const std::string &name) noexcept{
-    return std::make_shared<CFileDataSource>(DBasePath + name);
+    return CreateFileSource(name, MapFile(name));
+}
+
+std::shared_ptr< CDataSource > CFileDataFactory::CreateConcatenatedSource(const std::vector< std::string > &names, bool skipheaders) noexcept{
+    std::vector< std::shared_ptr< CDataSource > > Sources;
+    for(auto &Name : names){
+        Sources.push_back(CreateSource(Name));
+    }
+    return std::make_shared<CConcatenatedDataSource>(std::move(Sources), skipheaders, true);
+}
+
+std::vector< std::shared_ptr< CDataSource > > CFileDataFactory::CreateShardedSources(const std::string &name, std::size_t count) noexcept{
+    auto File = MapFile(name);
+    auto Contents = File->Contents();
+    if((count <= 1) || IsCompressed(name, Contents)){
+        return {CreateFileSource(name, File)};
+    }
+    std::vector< std::shared_ptr< CDataSource > > Shards;
+    std::size_t Start = 0;
+    for(std::size_t Index = 1; Index <= count; Index++){
+        std::size_t Stop = Contents.size();
+        if(Index < count){
+            // Round the nominal split point up to just past the next newline
+            Stop = std::max(Start, Contents.size() / count * Index);
+            if(Stop && (Stop < Contents.size()) && (Contents[Stop - 1] != '\n')){
+                auto NewLine = static_cast<const char *>(std::memchr(Contents.data() + Stop, '\n', Contents.size() - Stop));
+                Stop = NewLine ? NewLine - Contents.data() + 1 : Contents.size();
+            }
+        }
+        if(Start < Stop){
+            Shards.push_back(std::make_shared<CFileDataSource>(File, Start, Stop - Start));
+            Start = Stop;
+        }
+    }
+    if(Shards.empty()){
+        Shards.push_back(std::make_shared<CFileDataSource>(File));
+    }
+    return Shards;
 }
 
 std::shared_ptr< CDataSink > CFileDataFactory::CreateSink(const std::string &name) noexcept{
@@ -1,16 +1,123 @@
 #include "FileDataSink.h"
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
 
+CFileDataSink::CFileDataSink(const std::string &filename, std::size_t buffersize, EOpenMode mode) : DBuffer(buffersize), DLength(0){
+    if(mode == EOpenMode::Replace){
+        // The new file is created next to the old one so the rename stays on
+        // one file system, and the path is left alone if anything fails
+        std::string TempName = filename + ".XXXXXX";
+        DHandle = mkstemp(TempName.data());
+        if(DHandle >= 0){
+            if((fchmod(DHandle, 0644) != 0) || (rename(TempName.c_str(), filename.c_str()) != 0)){
+                close(DHandle);
+                unlink(TempName.c_str());
+                DHandle = -1;
+            }
+        }
+    }
+    else{
+        DHandle = open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    }
+    DFailed = DHandle < 0;
+}
+
+CFileDataSink::~CFileDataSink(){
+    if(DHandle >= 0){
+        Flush();
+        close(DHandle);
+    }
+}
 
-CFileDataSink::CFileDataSink(const std::string &filename){
-    DFile.open(filename);
+// Writes first then second with as few syscalls as possible, picking up
+// after partial writes.
+bool CFileDataSink::WriteDirect(std::span<const char> first, std::span<const char> second) noexcept{
+    struct iovec Vectors[2] = {
+        {const_cast<char *>(first.data()), first.size()},
+        {const_cast<char *>(second.data()), second.size()}
+    };
+    struct iovec *Current = Vectors;
+    int Remaining = 2;
+    while(Remaining && !Current->iov_len){
+        Current++;
+        Remaining--;
+    }
+    while(Remaining){
+        ssize_t Written = writev(DHandle, Current, Remaining);
+        if(Written < 0){
+            if(errno == EINTR){
+                continue;
+            }
+            DFailed = true;
+            return false;
+        }
+        while(Remaining && (std::size_t(Written) >= Current->iov_len)){
+            Written -= Current->iov_len;
+            Current++;
+            Remaining--;
+        }
+        if(Remaining){
+            Current->iov_base = static_cast<char *>(Current->iov_base) + Written;
+            Current->iov_len -= Written;
+        }
+    }
+    return true;
 }
 
 bool CFileDataSink::Put(const char &ch) noexcept{
-    DFile.put(ch);
-    return DFile.good();
+    if(DHandle < 0){
+        return false;
+    }
+    if(DLength == DBuffer.size()){
+        if(!Flush()){
+            return false;
+        }
+        if(DBuffer.empty()){
+            return WriteDirect(std::span<const char>(&ch, 1), {});
+        }
+    }
+    DBuffer[DLength++] = ch;
+    return true;
 }
 
 bool CFileDataSink::Write(const std::vector<char> &buf) noexcept{
-    DFile.write(buf.data(),buf.size());
-    return DFile.good();
-}
\ No newline at end of file
+    return WriteSpan(buf);
+}
+
+bool CFileDataSink::WriteSpan(std::span<const char> buf) noexcept{
+    if(DHandle < 0){
+        return false;
+    }
+    // an empty span may have no data pointer at all, which memcpy rejects
+    if(buf.empty()){
+        return true;
+    }
+    if(buf.size() <= DBuffer.size() - DLength){
+        std::memcpy(DBuffer.data() + DLength, buf.data(), buf.size());
+        DLength += buf.size();
+        return true;
+    }
+    // Doesn't fit, so send the pending bytes and the new ones in one go
+    std::span<const char> Pending(DBuffer.data(), DLength);
+    DLength = 0;
+    return WriteDirect(Pending, buf);
+}
+
+bool CFileDataSink::Flush() noexcept{
+    if(DHandle < 0){
+        return false;
+    }
+    std::span<const char> Pending(DBuffer.data(), DLength);
+    DLength = 0;
+    return WriteDirect(Pending, {});
+}
+
+bool CFileDataSink::Failed() const noexcept{
+    return DFailed;
+}
@@ -1,44 +1,79 @@
 #include "FileDataSource.h"
+#include <algorithm>
+#include <cstring>
 
-CFileDataSource::CFileDataSource(const std::string &filename){
-    DFile.open(filename);
-    if(DFile.good()){
-        DFile.peek();
-    }
+CFileDataSource::CFileDataSource(const std::string &filename) : CFileDataSource(std::make_shared<CMappedFile>(filename)){
+
+}
+
+CFileDataSource::CFileDataSource(std::shared_ptr< const CMappedFile > file) : DFile(file), DData(file->Contents().data()), DSize(file->Contents().size()), DIndex(0){
+
+}
+
+CFileDataSource::CFileDataSource(std::shared_ptr< const CMappedFile > file, std::size_t offset, std::size_t length) : DFile(file), DIndex(0){
+    auto Contents = file->Contents();
+    offset = std::min(offset, Contents.size());
+    DData = Contents.data() + offset;
+    DSize = std::min(length, Contents.size() - offset);
 }
 
 bool CFileDataSource::End() const noexcept{
-    return DFile.eof();
+    return DIndex >= DSize;
 }
 
 bool CFileDataSource::Get(char &ch) noexcept{
-    if(!DFile.good()){
-        return false;
-    }
-    ch = DFile.get();
-    if(ch != EOF){
-        DFile.peek();
+    if(DIndex < DSize){
+        ch = DData[DIndex++];
+        return true;
     }
-    return ch != EOF;
+    return false;
 }
 
 bool CFileDataSource::Peek(char &ch) noexcept{
-    if(!DFile.good()){
-        return false;
+    if(DIndex < DSize){
+        ch = DData[DIndex];
+        return true;
     }
-    ch = DFile.peek();
-    return ch != EOF;
+    return false;
 }
 
 bool CFileDataSource::Read(std::vector<char> &buf, std::size_t count) noexcept{
-    if(!DFile.good()){
+    std::size_t Length = std::min(count, DSize - DIndex);
+    buf.assign(DData + DIndex, DData + DIndex + Length);
+    DIndex += Length;
+    return !buf.empty();
+}
+
+std::size_t CFileDataSource::ReadSpan(std::span<char> buf) noexcept{
+    std::size_t Length = std::min(buf.size(), DSize - DIndex);
+    std::memcpy(buf.data(), DData + DIndex, Length);
+    DIndex += Length;
+    return Length;
+}
+
+bool CFileDataSource::Borrow(std::span<const char> &span, std::size_t count) noexcept{
+    std::size_t Length = std::min(count, DSize - DIndex);
+    if(!Length){
         return false;
     }
-    char TempCh;
-    buf.clear();
-    buf.reserve(count);
-    while(buf.size() < count && Get(TempCh)){
-        buf.push_back(TempCh);
+    span = std::span<const char>(DData + DIndex, Length);
+    DIndex += Length;
+    return true;
+}
+
+bool CFileDataSource::ReadLine(std::string &line) noexcept{
+    return ReadLineFrom(std::string_view(DData, DSize), DIndex, line);
+}
+
+bool CFileDataSource::Seek(std::size_t offset) noexcept{
+    if(offset > DSize){
+        return false;
     }
-    return !buf.empty();
+    DIndex = offset;
+    return true;
+}
+
+bool CFileDataSource::Tell(std::size_t &offset) const noexcept{
+    offset = DIndex;
+    return true;
 }
@@ -0,0 +1,57 @@
+#include "FlatIDIndex.h"
+
+CFlatIDIndex::CFlatIDIndex(std::span<const uint64_t> ids)
+{
+    if (ids.empty())
+    {
+        return;
+    }
+    std::size_t Slots = std::bit_ceil(ids.size() * 2);
+    DIDs.assign(Slots, EmptyID);
+    DPositions.assign(Slots, InvalidPosition);
+    for (uint32_t Position = 0; Position < ids.size(); Position++)
+    {
+        std::size_t Slot = HomeSlot(ids[Position], Slots);
+        while (DPositions[Slot] != InvalidPosition)
+        {
+            Slot = (Slot + 1) & (Slots - 1);
+        }
+        DIDs[Slot] = ids[Position];
+        DPositions[Slot] = Position;
+    }
+    DSize = ids.size();
+}
+
+std::size_t CFlatIDIndex::Size() const noexcept
+{
+    return DSize;
+}
+
+bool CFlatIDIndex::Valid(std::span<const uint64_t> ids, std::span<const uint32_t> positions, std::size_t count) noexcept
+{
+    if (ids.size() != positions.size())
+    {
+        return false;
+    }
+    if (ids.empty())
+    {
+        return !count;
+    }
+    if ((ids.size() < 2) || !std::has_single_bit(ids.size()) || (ids.size() <= count))
+    {
+        return false;
+    }
+    bool HasEmptySlot = false;
+    for (std::size_t Slot = 0; Slot < ids.size(); Slot++)
+    {
+        if (positions[Slot] == InvalidPosition)
+        {
+            HasEmptySlot |= ids[Slot] == EmptyID;
+        }
+        else if (positions[Slot] >= count)
+        {
+            return false;
+        }
+    }
+    return HasEmptySlot;
+}
@@ -0,0 +1,156 @@
+#include "GzipDataSource.h"
+#include <cstring>
+#include <zlib.h>
+
+struct CGzipDataSource::SImplementation{
+    std::shared_ptr< CDataSource > DSource;
+    z_stream DStream;
+    std::vector<char> DInput;
+    // Two halves inflated into in turn, so End() can fill one while a view
+    // lent from the other is still in use. DOffset and DLength index the
+    // whole buffer, starting at DBase.
+    std::vector<char> DOutput;
+    std::size_t DBase;
+    std::size_t DOffset;
+    std::size_t DLength;
+    bool DStreamEnded;
+    bool DInputDone;
+    bool DFailed;
+
+    SImplementation(std::shared_ptr< CDataSource > src, std::size_t blocksize){
+        DSource = src;
+        DInput.resize(blocksize ? blocksize : 1);
+        DOutput.resize(2 * (blocksize ? blocksize : 1));
+        DBase = 0;
+        DOffset = 0;
+        DLength = 0;
+        DStreamEnded = false;
+        DInputDone = false;
+        std::memset(&DStream, 0, sizeof(DStream));
+        // 15 window bits + 32 lets zlib detect gzip or zlib headers itself
+        DFailed = inflateInit2(&DStream, 15 + 32) != Z_OK;
+    }
+
+    ~SImplementation(){
+        inflateEnd(&DStream);
+    }
+
+    // Pulls more compressed bytes, borrowing them when the source allows it
+    bool RefillInput(){
+        std::span<const char> Borrowed;
+        if(DSource->Borrow(Borrowed, DInput.size())){
+            DStream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(Borrowed.data()));
+            DStream.avail_in = Borrowed.size();
+            return true;
+        }
+        std::size_t Length = DSource->ReadSpan(DInput);
+        DStream.next_in = reinterpret_cast<Bytef *>(DInput.data());
+        DStream.avail_in = Length;
+        return Length;
+    }
+
+    // Makes sure there are inflated bytes waiting, returns false at the end
+    // of the data or once the stream is found to be broken.
+    bool Fill(){
+        while(DOffset >= DLength){
+            if(DFailed){
+                return false;
+            }
+            if(!DStream.avail_in){
+                if(DInputDone || !RefillInput()){
+                    DInputDone = true;
+                    // Running out of input inside a member means truncation
+                    DFailed = !DStreamEnded;
+                    return false;
+                }
+            }
+            if(DStreamEnded){
+                // Another gzip member follows the one that just finished
+                DStreamEnded = false;
+                if(inflateReset(&DStream) != Z_OK){
+                    DFailed = true;
+                    return false;
+                }
+            }
+            std::size_t Half = DOutput.size() / 2;
+            if(DLength > DBase){
+                DBase = DBase ? 0 : Half;
+            }
+            DStream.next_out = reinterpret_cast<Bytef *>(DOutput.data() + DBase);
+            DStream.avail_out = Half;
+            int Result = inflate(&DStream, Z_NO_FLUSH);
+            if(Result == Z_STREAM_END){
+                DStreamEnded = true;
+            }
+            else if((Result != Z_OK) && (Result != Z_BUF_ERROR)){
+                DFailed = true;
+            }
+            DOffset = DBase;
+            DLength = DBase + Half - DStream.avail_out;
+        }
+        return true;
+    }
+
+    std::size_t ReadSpan(std::span<char> buf){
+        std::size_t Total = 0;
+        while((Total < buf.size()) && Fill()){
+            std::size_t Length = std::min(buf.size() - Total, DLength - DOffset);
+            std::memcpy(buf.data() + Total, DOutput.data() + DOffset, Length);
+            DOffset += Length;
+            Total += Length;
+        }
+        return Total;
+    }
+};
+
+CGzipDataSource::CGzipDataSource(std::shared_ptr< CDataSource > src, std::size_t blocksize){
+    DImplementation = std::make_unique<SImplementation>(src, blocksize);
+}
+
+CGzipDataSource::~CGzipDataSource(){
+
+}
+
+bool CGzipDataSource::Failed() const noexcept{
+    return DImplementation->DFailed;
+}
+
+bool CGzipDataSource::End() const noexcept{
+    return !DImplementation->Fill();
+}
+
+bool CGzipDataSource::Get(char &ch) noexcept{
+    if(!DImplementation->Fill()){
+        return false;
+    }
+    ch = DImplementation->DOutput[DImplementation->DOffset++];
+    return true;
+}
+
+bool CGzipDataSource::Peek(char &ch) noexcept{
+    if(!DImplementation->Fill()){
+        return false;
+    }
+    ch = DImplementation->DOutput[DImplementation->DOffset];
+    return true;
+}
+
+bool CGzipDataSource::Read(std::vector<char> &buf, std::size_t count) noexcept{
+    buf.resize(count);
+    buf.resize(DImplementation->ReadSpan(buf));
+    return !buf.empty();
+}
+
+std::size_t CGzipDataSource::ReadSpan(std::span<char> buf) noexcept{
+    return DImplementation->ReadSpan(buf);
+}
+
+bool CGzipDataSource::Borrow(std::span<const char> &span, std::size_t count) noexcept{
+    if(!count || !DImplementation->Fill()){
+        return false;
+    }
+    std::size_t Length = std::min(count, DImplementation->DLength - DImplementation->DOffset);
+    span = std::span<const char>(DImplementation->DOutput.data() + DImplementation->DOffset, Length);
+    DImplementation->DOffset += Length;
+    return true;
+}
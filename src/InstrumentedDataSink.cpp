@@ -0,0 +1,43 @@
+#include "InstrumentedDataSink.h"
+
+CInstrumentedDataSink::CInstrumentedDataSink(std::shared_ptr< CDataSink > sink) : DSink(sink){
+
+}
+
+const SDataStatistics &CInstrumentedDataSink::Statistics() const noexcept{
+    return DStatistics;
+}
+
+void CInstrumentedDataSink::ResetStatistics() noexcept{
+    DStatistics = SDataStatistics();
+}
+
+bool CInstrumentedDataSink::Put(const char &ch) noexcept{
+    CDataStatisticsTimer Timer(DStatistics);
+    DStatistics.DPutCalls++;
+    if(DSink->Put(ch)){
+        DStatistics.DBytes++;
+        return true;
+    }
+    return false;
+}
+
+bool CInstrumentedDataSink::Write(const std::vector<char> &buf) noexcept{
+    return WriteSpan(buf);
+}
+
+bool CInstrumentedDataSink::WriteSpan(std::span<const char> buf) noexcept{
+    CDataStatisticsTimer Timer(DStatistics);
+    DStatistics.DWriteCalls++;
+    if(DSink->WriteSpan(buf)){
+        DStatistics.DBytes += buf.size();
+        return true;
+    }
+    return false;
+}
+
+bool CInstrumentedDataSink::Flush() noexcept{
+    CDataStatisticsTimer Timer(DStatistics);
+    DStatistics.DFlushCalls++;
+    return DSink->Flush();
+}
@@ -0,0 +1,80 @@
+#include "InstrumentedDataSource.h"
+
+CInstrumentedDataSource::CInstrumentedDataSource(std::shared_ptr< CDataSource > src) : DSource(src){
+
+}
+
+const SDataStatistics &CInstrumentedDataSource::Statistics() const noexcept{
+    return DStatistics;
+}
+
+void CInstrumentedDataSource::ResetStatistics() noexcept{
+    DStatistics = SDataStatistics();
+}
+
+bool CInstrumentedDataSource::End() const noexcept{
+    CDataStatisticsTimer Timer(DStatistics);
+    return DSource->End();
+}
+
+bool CInstrumentedDataSource::Get(char &ch) noexcept{
+    CDataStatisticsTimer Timer(DStatistics);
+    DStatistics.DGetCalls++;
+    if(DSource->Get(ch)){
+        DStatistics.DBytes++;
+        return true;
+    }
+    return false;
+}
+
+bool CInstrumentedDataSource::Peek(char &ch) noexcept{
+    CDataStatisticsTimer Timer(DStatistics);
+    DStatistics.DPeekCalls++;
+    return DSource->Peek(ch);
+}
+
+bool CInstrumentedDataSource::Read(std::vector<char> &buf, std::size_t count) noexcept{
+    CDataStatisticsTimer Timer(DStatistics);
+    DStatistics.DReadCalls++;
+    bool Result = DSource->Read(buf, count);
+    if(Result){
+        DStatistics.DBytes += buf.size();
+    }
+    return Result;
+}
+
+std::size_t CInstrumentedDataSource::ReadSpan(std::span<char> buf) noexcept{
+    CDataStatisticsTimer Timer(DStatistics);
+    DStatistics.DReadCalls++;
+    std::size_t Length = DSource->ReadSpan(buf);
+    DStatistics.DBytes += Length;
+    return Length;
+}
+
+bool CInstrumentedDataSource::Borrow(std::span<const char> &span, std::size_t count) noexcept{
+    CDataStatisticsTimer Timer(DStatistics);
+    DStatistics.DReadCalls++;
+    if(DSource->Borrow(span, count)){
+        DStatistics.DBytes += span.size();
+        return true;
+    }
+    return false;
+}
+
+bool CInstrumentedDataSource::ReadLine(std::string &line) noexcept{
+    CDataStatisticsTimer Timer(DStatistics);
+    DStatistics.DReadCalls++;
+    if(DSource->ReadLine(line)){
+        DStatistics.DBytes += line.size();
+        return true;
+    }
+    return false;
+}
+
+bool CInstrumentedDataSource::Seek(std::size_t offset) noexcept{
+    return DSource->Seek(offset);
+}
+
+bool CInstrumentedDataSource::Tell(std::size_t &offset) const noexcept{
+    return DSource->Tell(offset);
+}
@@ -1,15 +1,17 @@
 #include "KMLWriter.h"
-#include "XMLWriter.h"
 #include "StringUtils.h"
 #include <unordered_set>
 #include <sstream>
 #include <iomanip>
 
+// Paths can be long, so the XML is handed to the sink in blocks of this size
+constexpr std::size_t KMLWriteBatchSize = 65536;
+
 struct CKMLWriter::SImplementation{
     std::shared_ptr<CXMLWriter> DXMLWriter;
     std::unordered_set<std::string> DPointStyles;
     std::unordered_set<std::string> DLineStyles;
-    std::size_t DIndentionLevel;
+    CXMLWriter::EFormat DFormat;
 
     static const std::string DKMLTag;
     static const std::string DDocumentTag;
@@ -31,69 +33,55 @@ struct CKMLWriter::SImplementation{
     static const std::string DXMLNSKey;
     static const std::string DXMLNSValue;
 
-    bool OutputIndent(){
+    // The XML writer lays out the tags, so only the data needs indenting here
+    bool StartTag(const std::string &name, const TAttributes &attributes){
         SXMLEntity Entity;
-        Entity.DType = SXMLEntity::EType::CharData;
-        Entity.DNameData = std::string("\n") + std::string(DIndentionLevel*2,' ');
+        Entity.DType = SXMLEntity::EType::StartElement;
+        Entity.DNameData = name;
+        Entity.DAttributes = attributes;
         return DXMLWriter->WriteEntity(Entity);
     }
 
-    bool StartTag(const std::string &name, const TAttributes &attributes){
-        if(OutputIndent()){
-            SXMLEntity Entity;
-            Entity.DType = SXMLEntity::EType::StartElement;
-            Entity.DNameData = name;
-            Entity.DAttributes = attributes;
-            if(DXMLWriter->WriteEntity(Entity)){
-                DIndentionLevel++;
-                return true;
-            }
-        }
-        return false;
-    }
-
     bool EndTag(const std::string &name){
-        if(DIndentionLevel){
-            DIndentionLevel--;
-            if(OutputIndent()){
-                SXMLEntity Entity;
-                Entity.DType = SXMLEntity::EType::EndElement;
-                Entity.DNameData = name;
-                if(DXMLWriter->WriteEntity(Entity)){
-                    return true;
-                }
-            }
-        }
-        return false;
+        SXMLEntity Entity;
+        Entity.DType = SXMLEntity::EType::EndElement;
+        Entity.DNameData = name;
+        return DXMLWriter->WriteEntity(Entity);
     }
 
     bool StartTagDataEndTag(const std::string &name, const std::string &data){
-        if(OutputIndent()){
-            SXMLEntity TagEntity, DataEntity;
-            TagEntity.DType = SXMLEntity::EType::StartElement;
-            TagEntity.DNameData = name;
-            DataEntity.DType = SXMLEntity::EType::CharData;
-            DataEntity.DNameData = data;
-            if(DXMLWriter->WriteEntity(TagEntity) && DXMLWriter->WriteEntity(DataEntity)){
-                TagEntity.DType = SXMLEntity::EType::EndElement;
-                return DXMLWriter->WriteEntity(TagEntity);
-            }
+        SXMLEntity TagEntity, DataEntity;
+        TagEntity.DType = SXMLEntity::EType::StartElement;
+        TagEntity.DNameData = name;
+        DataEntity.DType = SXMLEntity::EType::CharData;
+        DataEntity.DNameData = data;
+        if(DXMLWriter->WriteEntity(TagEntity) && DXMLWriter->WriteEntity(DataEntity)){
+            TagEntity.DType = SXMLEntity::EType::EndElement;
+            return DXMLWriter->WriteEntity(TagEntity);
         }
         return false;
     }
 
+    // Each line goes on its own line one level in when indenting, otherwise
+    // the lines are separated by single spaces
     bool IndentedData(const std::vector<std::string> &datalines){
         SXMLEntity Entity;
         Entity.DType = SXMLEntity::EType::CharData;
-        Entity.DNameData = std::string("\n") + std::string(DIndentionLevel*2,' ') + StringUtils::Join(std::string("\n") + std::string(DIndentionLevel*2,' '),datalines);
+        if(DFormat == CXMLWriter::EFormat::Indented){
+            std::string Indent = std::string("\n") + std::string(DXMLWriter->Depth()*2,' ');
+            Entity.DNameData = Indent + StringUtils::Join(Indent,datalines);
+        }
+        else{
+            Entity.DNameData = StringUtils::Join(" ",datalines);
+        }
         return DXMLWriter->WriteEntity(Entity);
     }
 
-    SImplementation(std::shared_ptr< CDataSink > sink, const std::string &name, const std::string &desc){
+    SImplementation(std::shared_ptr< CDataSink > sink, const std::string &name, const std::string &desc, CXMLWriter::EFormat format){
         const std::string XMLEncoding = "<?xml version='1.0' encoding='UTF-8'?>";
-        sink->Write(std::vector<char>(XMLEncoding.begin(),XMLEncoding.end()));
-        DXMLWriter = std::make_shared<CXMLWriter>(sink);
-        DIndentionLevel = 0;
+        DFormat = format;
+        sink->WriteString(DFormat == CXMLWriter::EFormat::Indented ? XMLEncoding + "\n" : XMLEncoding);
+        DXMLWriter = std::make_shared<CXMLWriter>(sink, KMLWriteBatchSize, DFormat);
 
         if(StartTag(DKMLTag,{{DXMLNSKey,DXMLNSValue}}) && StartTag(DDocumentTag,{}) && StartTagDataEndTag(DNameTag,name) && StartTagDataEndTag(DDescriptionTag,desc)){
            // Good  
@@ -103,6 +91,7 @@ struct CKMLWriter::SImplementation{
     ~SImplementation(){
         EndTag(DDocumentTag);
         EndTag(DKMLTag);
+        DXMLWriter->Flush();
     }
 
     bool CreatePointStyle(const std::string &stylename, unsigned int color){
@@ -207,8 +196,8 @@ const std::string CKMLWriter::SImplementation::DIDKey = "id";
 const std::string CKMLWriter::SImplementation::DXMLNSKey = "xmlns";
 const std::string CKMLWriter::SImplementation::DXMLNSValue = "http://www.opengis.net/kml/2.2";
         
-CKMLWriter::CKMLWriter(std::shared_ptr< CDataSink > sink, const std::string &name, const std::string &desc){
-    DImplementation = std::make_unique<SImplementation>(sink, name, desc);
+CKMLWriter::CKMLWriter(std::shared_ptr< CDataSink > sink, const std::string &name, const std::string &desc, CXMLWriter::EFormat format){
+    DImplementation = std::make_unique<SImplementation>(sink, name, desc, format);
 }
 
 CKMLWriter::~CKMLWriter(){
@@ -0,0 +1,43 @@
+#include "MappedFile.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+CMappedFile::CMappedFile(const std::string &filename) : DData(nullptr), DSize(0), DMapping(nullptr){
+    int FileHandle = open(filename.c_str(), O_RDONLY);
+    if(FileHandle < 0){
+        return;
+    }
+    struct stat FileStatus;
+    if((fstat(FileHandle,&FileStatus) == 0) && S_ISREG(FileStatus.st_mode) && (FileStatus.st_size > 0)){
+        void *Mapping = mmap(nullptr, FileStatus.st_size, PROT_READ, MAP_PRIVATE, FileHandle, 0);
+        if(Mapping != MAP_FAILED){
+            madvise(Mapping, FileStatus.st_size, MADV_SEQUENTIAL);
+            DMapping = Mapping;
+            DData = static_cast<const char *>(Mapping);
+            DSize = FileStatus.st_size;
+        }
+    }
+    if(!DMapping){
+        // Pipes, procfs entries and the like cannot be mapped, so slurp them instead
+        char Chunk[4096];
+        ssize_t Length;
+        while((Length = read(FileHandle, Chunk, sizeof(Chunk))) > 0){
+            DBuffer.insert(DBuffer.end(), Chunk, Chunk + Length);
+        }
+        DData = DBuffer.data();
+        DSize = DBuffer.size();
+    }
+    close(FileHandle);
+}
+
+CMappedFile::~CMappedFile(){
+    if(DMapping){
+        munmap(DMapping, DSize);
+    }
+}
+
+std::span<const char> CMappedFile::Contents() const noexcept{
+    return std::span<const char>(DData, DSize);
+}
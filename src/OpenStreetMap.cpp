@@ -1,264 +1,370 @@
 #include "OpenStreetMap.h"
+#include "FlatIDIndex.h"
+#include "FreeListAllocator.h"
 
+#include <charconv>
 #include <limits>
+#include <span>
 #include <string>
-#include <unordered_map>
+#include <unordered_set>
 #include <utility>
 #include <vector>
 
+namespace
+{
+    template <typename T>
+    bool ParseNumber(std::string_view text, T &value)
+    {
+        auto [End, Error] = std::from_chars(text.data(), text.data() + text.size(), value);
+        return !text.empty() && (Error == std::errc()) && (End == text.data() + text.size());
+    }
+}
+
 struct COpenStreetMap::SImplementation
 {
-    struct SNodeImpl : public CStreetMap::SNode
+    // A tag of a node or way, its value is a slice of the value pool
+    struct SAttributeRef
     {
-        TNodeID DID;
-        TLocation DLocation;
-        std::vector<TAttribute> DAttributes;
+        TXMLAtom DKey;
+        uint32_t DValueOffset;
+        uint32_t DValueLength;
+    };
+
+    struct SStorage;
 
-        SNodeImpl(TNodeID id, double lat, double lon)
-            : DID(id), DLocation(std::make_pair(lat, lon))
+    // Handles are made on request and only know their position; everything
+    // else is read from the arrays in SStorage, which they keep alive. They
+    // come from a free list, so a lookup normally does not allocate.
+    struct SNodeHandle : public CStreetMap::SNode
+    {
+        std::shared_ptr<const SStorage> DStorage;
+        uint32_t DIndex;
+
+        SNodeHandle(std::shared_ptr<const SStorage> storage, uint32_t index)
+            : DStorage(std::move(storage)), DIndex(index)
         {
         }
 
         TNodeID ID() const noexcept override
         {
-            return DID;
+            return DStorage->DNodeIDs[DIndex];
         }
 
-        TLocation Location() const noexcept override
+        SLocation Location() const noexcept override
         {
-            return DLocation;
+            return SLocation(DStorage->DNodeLatitudes[DIndex], DStorage->DNodeLongitudes[DIndex]);
         }
 
         std::size_t AttributeCount() const noexcept override
         {
-            return DAttributes.size();
+            return Attributes().size();
         }
 
         std::string GetAttributeKey(std::size_t index) const noexcept override
         {
-            if (index >= DAttributes.size())
-            {
-                return std::string();
-            }
-            return DAttributes[index].first;
+            return DStorage->AttributeKey(Attributes(), index);
         }
 
         bool HasAttribute(const std::string &key) const noexcept override
         {
-            for (const auto &Attr : DAttributes)
-            {
-                if (Attr.first == key)
-                {
-                    return true;
-                }
-            }
-            return false;
+            return DStorage->FindAttribute(Attributes(), key) != nullptr;
         }
 
         std::string GetAttribute(const std::string &key) const noexcept override
         {
-            for (const auto &Attr : DAttributes)
-            {
-                if (Attr.first == key)
-                {
-                    return Attr.second;
-                }
-            }
-            return std::string();
+            return DStorage->AttributeValue(Attributes(), key);
+        }
+
+        std::string GetAttributeValue(std::size_t index) const noexcept override
+        {
+            return DStorage->AttributeValue(Attributes(), index);
+        }
+
+        std::span<const SAttributeRef> Attributes() const noexcept
+        {
+            return DStorage->Range(DStorage->DNodeAttributes, DStorage->DNodeAttributeOffsets, DIndex);
         }
     };
 
-    struct SWayImpl : public CStreetMap::SWay
+    struct SWayHandle : public CStreetMap::SWay
     {
-        TWayID DID;
-        std::vector<TNodeID> DNodeIDs;
-        std::vector<TAttribute> DAttributes;
+        std::shared_ptr<const SStorage> DStorage;
+        uint32_t DIndex;
 
-        explicit SWayImpl(TWayID id)
-            : DID(id)
+        SWayHandle(std::shared_ptr<const SStorage> storage, uint32_t index)
+            : DStorage(std::move(storage)), DIndex(index)
         {
         }
 
         TWayID ID() const noexcept override
         {
-            return DID;
+            return DStorage->DWayIDs[DIndex];
         }
 
         std::size_t NodeCount() const noexcept override
         {
-            return DNodeIDs.size();
+            return NodeIDs().size();
         }
 
         TNodeID GetNodeID(std::size_t index) const noexcept override
         {
-            if (index >= DNodeIDs.size())
+            auto NodeIDs = this->NodeIDs();
+            if (index >= NodeIDs.size())
             {
                 return std::numeric_limits<CStreetMap::TNodeID>::max();
             }
-            return DNodeIDs[index];
+            return NodeIDs[index];
         }
 
         std::size_t AttributeCount() const noexcept override
         {
-            return DAttributes.size();
+            return Attributes().size();
         }
 
         std::string GetAttributeKey(std::size_t index) const noexcept override
         {
-            if (index >= DAttributes.size())
+            return DStorage->AttributeKey(Attributes(), index);
+        }
+
+        bool HasAttribute(const std::string &key) const noexcept override
+        {
+            return DStorage->FindAttribute(Attributes(), key) != nullptr;
+        }
+
+        std::string GetAttribute(const std::string &key) const noexcept override
+        {
+            return DStorage->AttributeValue(Attributes(), key);
+        }
+
+        std::string GetAttributeValue(std::size_t index) const noexcept override
+        {
+            return DStorage->AttributeValue(Attributes(), index);
+        }
+
+        std::span<const TNodeID> NodeIDs() const noexcept
+        {
+            return DStorage->Range(DStorage->DWayNodeIDs, DStorage->DWayNodeOffsets, DIndex);
+        }
+
+        std::span<const SAttributeRef> Attributes() const noexcept
+        {
+            return DStorage->Range(DStorage->DWayAttributes, DStorage->DWayAttributeOffsets, DIndex);
+        }
+    };
+
+    // Nodes and ways as parallel arrays. The node refs and tags of each
+    // element are runs in shared pools, where element i owns entries
+    // offsets[i] up to offsets[i + 1]. Handles share ownership of the
+    // storage, so they stay valid after the map itself is destroyed.
+    struct SStorage
+    {
+        std::vector<TNodeID> DNodeIDs;
+        std::vector<double> DNodeLatitudes;
+        std::vector<double> DNodeLongitudes;
+        std::vector<uint32_t> DNodeAttributeOffsets{0};
+        std::vector<SAttributeRef> DNodeAttributes;
+
+        std::vector<TWayID> DWayIDs;
+        std::vector<uint32_t> DWayNodeOffsets{0};
+        std::vector<TNodeID> DWayNodeIDs;
+        std::vector<uint32_t> DWayAttributeOffsets{0};
+        std::vector<SAttributeRef> DWayAttributes;
+
+        // tag keys repeat constantly so each is stored once
+        CXMLAtomTable DKeys;
+        std::string DValues;
+
+        template <typename T>
+        static std::span<const T> Range(const std::vector<T> &pool, const std::vector<uint32_t> &offsets, uint32_t index) noexcept
+        {
+            return std::span<const T>(pool).subspan(offsets[index], offsets[index + 1] - offsets[index]);
+        }
+
+        std::string AttributeKey(std::span<const SAttributeRef> attributes, std::size_t index) const noexcept
+        {
+            if (index >= attributes.size())
             {
                 return std::string();
             }
-            return DAttributes[index].first;
+            return std::string(DKeys.Name(attributes[index].DKey));
         }
 
-        bool HasAttribute(const std::string &key) const noexcept override
+        const SAttributeRef *FindAttribute(std::span<const SAttributeRef> attributes, const std::string &key) const noexcept
         {
-            for (const auto &Attr : DAttributes)
+            // a key that was never interned is on no element
+            TXMLAtom Key = attributes.empty() ? CXMLAtomTable::InvalidAtom : DKeys.Find(key);
+            if (Key == CXMLAtomTable::InvalidAtom)
             {
-                if (Attr.first == key)
+                return nullptr;
+            }
+            for (const auto &Attr : attributes)
+            {
+                if (Attr.DKey == Key)
                 {
-                    return true;
+                    return &Attr;
                 }
             }
-            return false;
+            return nullptr;
         }
 
-        std::string GetAttribute(const std::string &key) const noexcept override
+        std::string Value(const SAttributeRef *attr) const noexcept
         {
-            for (const auto &Attr : DAttributes)
+            if (!attr)
             {
-                if (Attr.first == key)
-                {
-                    return Attr.second;
-                }
+                return std::string();
             }
-            return std::string();
+            return DValues.substr(attr->DValueOffset, attr->DValueLength);
         }
-    };
 
-    std::vector<std::shared_ptr<SNodeImpl>> DNodesByIndex;
-    std::unordered_map<TNodeID, std::shared_ptr<SNodeImpl>> DNodesByID;
+        std::string AttributeValue(std::span<const SAttributeRef> attributes, const std::string &key) const noexcept
+        {
+            return Value(FindAttribute(attributes, key));
+        }
 
-    std::vector<std::shared_ptr<SWayImpl>> DWaysByIndex;
-    std::unordered_map<TWayID, std::shared_ptr<SWayImpl>> DWaysByID;
+        std::string AttributeValue(std::span<const SAttributeRef> attributes, std::size_t index) const noexcept
+        {
+            return Value(index < attributes.size() ? &attributes[index] : nullptr);
+        }
 
-    SImplementation(std::shared_ptr<CXMLReader> src)
+        SAttributeRef AddAttribute(std::string_view key, std::string_view value)
+        {
+            SAttributeRef Attr{DKeys.Intern(key), static_cast<uint32_t>(DValues.size()), static_cast<uint32_t>(value.size())};
+            DValues.append(value);
+            return Attr;
+        }
+    };
+
+    std::shared_ptr<SStorage> DStorage = std::make_shared<SStorage>();
+    // positions of nodes and ways in the storage arrays, built once loaded
+    CFlatIDIndex DNodesByID;
+    CFlatIDIndex DWaysByID;
+
+    // Builds nodes and ways straight from the parser's events, comparing the
+    // atoms of names rather than the names themselves. Only the most recently
+    // added node or way can be open, so tags and refs always extend the last
+    // run in their pool.
+    struct SLoader : public CXMLHandler
     {
-        SXMLEntity Entity;
-        std::shared_ptr<SNodeImpl> CurrentNode = nullptr;
-        std::shared_ptr<SWayImpl> CurrentWay = nullptr;
+        SStorage &DStorage;
+        // only needed while loading to skip repeated IDs
+        std::unordered_set<TNodeID> DSeenNodeIDs;
+        std::unordered_set<TWayID> DSeenWayIDs;
+        bool DInNode = false;
+        bool DInWay = false;
+        TXMLAtom DNodeAtom, DWayAtom, DNdAtom, DTagAtom;
+        TXMLAtom DIDAtom, DLatAtom, DLonAtom, DRefAtom, DKeyAtom, DValueAtom;
+
+        SLoader(SStorage &storage, CXMLAtomTable &atoms)
+            : DStorage(storage),
+              DNodeAtom(atoms.Intern("node")),
+              DWayAtom(atoms.Intern("way")),
+              DNdAtom(atoms.Intern("nd")),
+              DTagAtom(atoms.Intern("tag")),
+              DIDAtom(atoms.Intern("id")),
+              DLatAtom(atoms.Intern("lat")),
+              DLonAtom(atoms.Intern("lon")),
+              DRefAtom(atoms.Intern("ref")),
+              DKeyAtom(atoms.Intern("k")),
+              DValueAtom(atoms.Intern("v"))
+        {
+        }
 
-        while (src->ReadEntity(Entity, true))
+        void StartElement(TXMLAtom atom, std::string_view /*name*/, const CXMLAttributes &attributes) override
         {
-            if (Entity.DType == SXMLEntity::EType::StartElement)
+            if (atom == DNodeAtom)
             {
-                if (Entity.DNameData == "node")
-                {
-                    if (!Entity.AttributeExists("id") ||
-                        !Entity.AttributeExists("lat") ||
-                        !Entity.AttributeExists("lon"))
-                    {
-                        CurrentNode = nullptr;
-                        continue;
-                    }
-
-                    try
-                    {
-                        TNodeID ID = std::stoull(Entity.AttributeValue("id"));
-                        double Lat = std::stod(Entity.AttributeValue("lat"));
-                        double Lon = std::stod(Entity.AttributeValue("lon"));
-
-                        if (DNodesByID.find(ID) != DNodesByID.end())
-                        {
-                            CurrentNode = nullptr;
-                            continue;
-                        }
-
-                        auto Node = std::make_shared<SNodeImpl>(ID, Lat, Lon);
-                        DNodesByIndex.push_back(Node);
-                        DNodesByID[ID] = Node;
-                        CurrentNode = Node;
-                    }
-                    catch (...)
-                    {
-                        CurrentNode = nullptr;
-                    }
-                }
-                else if (Entity.DNameData == "way")
+                TNodeID ID;
+                double Lat, Lon;
+                DInNode = false;
+                if (!ParseNumber(attributes.Value(DIDAtom), ID) ||
+                    !ParseNumber(attributes.Value(DLatAtom), Lat) ||
+                    !ParseNumber(attributes.Value(DLonAtom), Lon) ||
+                    !DSeenNodeIDs.insert(ID).second)
                 {
-                    if (!Entity.AttributeExists("id"))
-                    {
-                        CurrentWay = nullptr;
-                        continue;
-                    }
-
-                    try
-                    {
-                        TWayID ID = std::stoull(Entity.AttributeValue("id"));
-
-                        if (DWaysByID.find(ID) != DWaysByID.end())
-                        {
-                            CurrentWay = nullptr;
-                            continue;
-                        }
-
-                        auto Way = std::make_shared<SWayImpl>(ID);
-                        DWaysByIndex.push_back(Way);
-                        DWaysByID[ID] = Way;
-                        CurrentWay = Way;
-                    }
-                    catch (...)
-                    {
-                        CurrentWay = nullptr;
-                    }
+                    return;
                 }
-                else if (Entity.DNameData == "nd" && CurrentWay != nullptr)
+                DStorage.DNodeIDs.push_back(ID);
+                DStorage.DNodeLatitudes.push_back(Lat);
+                DStorage.DNodeLongitudes.push_back(Lon);
+                DStorage.DNodeAttributeOffsets.push_back(DStorage.DNodeAttributeOffsets.back());
+                DInNode = true;
+            }
+            else if (atom == DWayAtom)
+            {
+                TWayID ID;
+                DInWay = false;
+                if (!ParseNumber(attributes.Value(DIDAtom), ID) ||
+                    !DSeenWayIDs.insert(ID).second)
                 {
-                    if (Entity.AttributeExists("ref"))
-                    {
-                        try
-                        {
-                            TNodeID Ref = std::stoull(Entity.AttributeValue("ref"));
-                            CurrentWay->DNodeIDs.push_back(Ref);
-                        }
-                        catch (...)
-                        {
-                            // ignore malformed nd ref
-                        }
-                    }
+                    return;
                 }
-                else if (Entity.DNameData == "tag")
+                DStorage.DWayIDs.push_back(ID);
+                DStorage.DWayNodeOffsets.push_back(DStorage.DWayNodeOffsets.back());
+                DStorage.DWayAttributeOffsets.push_back(DStorage.DWayAttributeOffsets.back());
+                DInWay = true;
+            }
+            else if (atom == DNdAtom && DInWay)
+            {
+                TNodeID Ref;
+                // malformed refs are ignored
+                if (ParseNumber(attributes.Value(DRefAtom), Ref))
                 {
-                    if (Entity.AttributeExists("k") && Entity.AttributeExists("v"))
-                    {
-                        auto KV = std::make_pair(Entity.AttributeValue("k"),
-                                                 Entity.AttributeValue("v"));
-
-                        // prefer way tags if inside a way
-                        if (CurrentWay != nullptr)
-                        {
-                            CurrentWay->DAttributes.push_back(KV);
-                        }
-                        else if (CurrentNode != nullptr)
-                        {
-                            CurrentNode->DAttributes.push_back(KV);
-                        }
-                    }
+                    DStorage.DWayNodeIDs.push_back(Ref);
+                    DStorage.DWayNodeOffsets.back()++;
                 }
             }
-            else if (Entity.DType == SXMLEntity::EType::EndElement)
+            else if (atom == DTagAtom)
             {
-                if (Entity.DNameData == "node")
+                if (!attributes.Exists(DKeyAtom) || !attributes.Exists(DValueAtom))
                 {
-                    CurrentNode = nullptr;
+                    return;
                 }
-                else if (Entity.DNameData == "way")
+                // prefer way tags if inside a way
+                if (DInWay)
                 {
-                    CurrentWay = nullptr;
+                    DStorage.DWayAttributes.push_back(DStorage.AddAttribute(attributes.Value(DKeyAtom), attributes.Value(DValueAtom)));
+                    DStorage.DWayAttributeOffsets.back()++;
                 }
+                else if (DInNode)
+                {
+                    DStorage.DNodeAttributes.push_back(DStorage.AddAttribute(attributes.Value(DKeyAtom), attributes.Value(DValueAtom)));
+                    DStorage.DNodeAttributeOffsets.back()++;
+                }
+            }
+        }
+
+        void EndElement(TXMLAtom atom, std::string_view /*name*/) override
+        {
+            if (atom == DNodeAtom)
+            {
+                DInNode = false;
+            }
+            else if (atom == DWayAtom)
+            {
+                DInWay = false;
             }
         }
+    };
+
+    SImplementation(std::shared_ptr<CXMLReader> src)
+    {
+        auto &Storage = *DStorage;
+        {
+            SLoader Loader(Storage, src->Atoms());
+            src->Parse(Loader);
+        }
+        DNodesByID = CFlatIDIndex(Storage.DNodeIDs);
+        DWaysByID = CFlatIDIndex(Storage.DWayIDs);
+    }
+
+    std::shared_ptr<SNodeHandle> Node(uint32_t index) const noexcept
+    {
+        return std::allocate_shared<SNodeHandle>(CFreeListAllocator<SNodeHandle>(), DStorage, index);
+    }
+
+    std::shared_ptr<SWayHandle> Way(uint32_t index) const noexcept
+    {
+        return std::allocate_shared<SWayHandle>(CFreeListAllocator<SWayHandle>(), DStorage, index);
     }
 };
 
@@ -271,48 +377,48 @@ COpenStreetMap::~COpenStreetMap() = default;
 
 std::size_t COpenStreetMap::NodeCount() const noexcept
 {
-    return DImplementation->DNodesByIndex.size();
+    return DImplementation->DStorage->DNodeIDs.size();
 }
 
 std::size_t COpenStreetMap::WayCount() const noexcept
 {
-    return DImplementation->DWaysByIndex.size();
+    return DImplementation->DStorage->DWayIDs.size();
 }
 
 std::shared_ptr<CStreetMap::SNode> COpenStreetMap::NodeByIndex(std::size_t index) const noexcept
 {
-    if (index >= DImplementation->DNodesByIndex.size())
+    if (index >= NodeCount())
     {
         return nullptr;
     }
-    return DImplementation->DNodesByIndex[index];
+    return DImplementation->Node(index);
 }
 
 std::shared_ptr<CStreetMap::SNode> COpenStreetMap::NodeByID(TNodeID id) const noexcept
 {
-    auto It = DImplementation->DNodesByID.find(id);
-    if (It == DImplementation->DNodesByID.end())
+    auto Position = DImplementation->DNodesByID.Find(id);
+    if (Position == CFlatIDIndex::InvalidPosition)
     {
         return nullptr;
     }
-    return It->second;
+    return DImplementation->Node(Position);
 }
 
 std::shared_ptr<CStreetMap::SWay> COpenStreetMap::WayByIndex(std::size_t index) const noexcept
 {
-    if (index >= DImplementation->DWaysByIndex.size())
+    if (index >= WayCount())
     {
         return nullptr;
     }
-    return DImplementation->DWaysByIndex[index];
+    return DImplementation->Way(index);
 }
 
 std::shared_ptr<CStreetMap::SWay> COpenStreetMap::WayByID(TWayID id) const noexcept
 {
-    auto It = DImplementation->DWaysByID.find(id);
-    if (It == DImplementation->DWaysByID.end())
+    auto Position = DImplementation->DWaysByID.Find(id);
+    if (Position == CFlatIDIndex::InvalidPosition)
     {
         return nullptr;
     }
-    return It->second;
+    return DImplementation->Way(Position);
 }
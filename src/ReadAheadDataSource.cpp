@@ -0,0 +1,189 @@
+#include "ReadAheadDataSource.h"
+#include <algorithm>
+#include <condition_variable>
+#include <cstring>
+#include <mutex>
+#include <thread>
+
+struct CReadAheadDataSource::SImplementation{
+    std::shared_ptr< CDataSource > DSource;
+    std::vector< std::vector<char> > DChunks;
+    std::vector< std::size_t > DLengths;
+    std::mutex DMutex;
+    std::condition_variable DChunkFilled;
+    std::condition_variable DChunkReleased;
+    std::size_t DFilledCount;
+    std::size_t DProducerIndex;
+    std::size_t DConsumerIndex;
+    bool DSourceDone;
+    bool DSourceFailed;
+    bool DStopping;
+    // State of the chunk the reader currently owns, only touched by the reader
+    bool DHaveChunk;
+    std::size_t DOffset;
+    std::thread DThread;
+
+    SImplementation(std::shared_ptr< CDataSource > src, std::size_t chunksize, std::size_t chunkcount){
+        DSource = src;
+        // End() needs room for the producer to fill a chunk while the reader
+        // still holds its finished one
+        DChunks.resize(std::max<std::size_t>(chunkcount, 2), std::vector<char>(chunksize ? chunksize : 1));
+        DLengths.resize(DChunks.size(), 0);
+        DFilledCount = 0;
+        DProducerIndex = 0;
+        DConsumerIndex = 0;
+        DSourceDone = false;
+        DSourceFailed = false;
+        DStopping = false;
+        DHaveChunk = false;
+        DOffset = 0;
+        DThread = std::thread([this]{ Produce(); });
+    }
+
+    ~SImplementation(){
+        {
+            std::lock_guard<std::mutex> Lock(DMutex);
+            DStopping = true;
+        }
+        DChunkReleased.notify_all();
+        DThread.join();
+    }
+
+    void Produce(){
+        while(true){
+            {
+                std::unique_lock<std::mutex> Lock(DMutex);
+                DChunkReleased.wait(Lock, [this]{ return DStopping || (DFilledCount < DChunks.size()); });
+                if(DStopping){
+                    return;
+                }
+            }
+            // The chunk at the producer index is free, fill it without holding the lock
+            std::size_t Length = DSource->ReadSpan(DChunks[DProducerIndex]);
+            {
+                std::lock_guard<std::mutex> Lock(DMutex);
+                if(!Length){
+                    DSourceDone = true;
+                    DSourceFailed = DSource->Failed();
+                }
+                else{
+                    DLengths[DProducerIndex] = Length;
+                    DProducerIndex = (DProducerIndex + 1) % DChunks.size();
+                    DFilledCount++;
+                }
+            }
+            DChunkFilled.notify_one();
+            if(!Length){
+                return;
+            }
+        }
+    }
+
+    // Makes sure the reader owns a chunk with unread bytes, waiting on the
+    // producer if needed. Returns false once everything has been consumed.
+    bool Fill(){
+        if(DHaveChunk && (DOffset < DLengths[DConsumerIndex])){
+            return true;
+        }
+        std::unique_lock<std::mutex> Lock(DMutex);
+        if(DHaveChunk){
+            DHaveChunk = false;
+            DConsumerIndex = (DConsumerIndex + 1) % DChunks.size();
+            DFilledCount--;
+            DChunkReleased.notify_one();
+        }
+        DChunkFilled.wait(Lock, [this]{ return DSourceDone || DFilledCount; });
+        if(!DFilledCount){
+            return false;
+        }
+        DHaveChunk = true;
+        DOffset = 0;
+        return true;
+    }
+
+    // Whether everything has been consumed. Waits on the producer like
+    // Fill(), but keeps the chunk the reader owns, so a view lent from it
+    // stays valid.
+    bool Drained(){
+        if(DHaveChunk && (DOffset < DLengths[DConsumerIndex])){
+            return false;
+        }
+        std::size_t Owned = DHaveChunk ? 1 : 0;
+        std::unique_lock<std::mutex> Lock(DMutex);
+        DChunkFilled.wait(Lock, [this, Owned]{ return DSourceDone || (DFilledCount > Owned); });
+        return DFilledCount <= Owned;
+    }
+
+    const char *Current() const{
+        return DChunks[DConsumerIndex].data() + DOffset;
+    }
+
+    std::size_t Available() const{
+        return DLengths[DConsumerIndex] - DOffset;
+    }
+
+    std::size_t ReadSpan(std::span<char> buf){
+        std::size_t Total = 0;
+        while((Total < buf.size()) && Fill()){
+            std::size_t Length = std::min(buf.size() - Total, Available());
+            std::memcpy(buf.data() + Total, Current(), Length);
+            DOffset += Length;
+            Total += Length;
+        }
+        return Total;
+    }
+};
+
+CReadAheadDataSource::CReadAheadDataSource(std::shared_ptr< CDataSource > src, std::size_t chunksize, std::size_t chunkcount){
+    DImplementation = std::make_unique<SImplementation>(src, chunksize, chunkcount);
+}
+
+CReadAheadDataSource::~CReadAheadDataSource(){
+
+}
+
+bool CReadAheadDataSource::Failed() const noexcept{
+    std::lock_guard<std::mutex> Lock(DImplementation->DMutex);
+    return DImplementation->DSourceFailed;
+}
+
+bool CReadAheadDataSource::End() const noexcept{
+    return DImplementation->Drained();
+}
+
+bool CReadAheadDataSource::Get(char &ch) noexcept{
+    if(!DImplementation->Fill()){
+        return false;
+    }
+    ch = *DImplementation->Current();
+    DImplementation->DOffset++;
+    return true;
+}
+
+bool CReadAheadDataSource::Peek(char &ch) noexcept{
+    if(!DImplementation->Fill()){
+        return false;
+    }
+    ch = *DImplementation->Current();
+    return true;
+}
+
+bool CReadAheadDataSource::Read(std::vector<char> &buf, std::size_t count) noexcept{
+    buf.resize(count);
+    buf.resize(DImplementation->ReadSpan(buf));
+    return !buf.empty();
+}
+
+std::size_t CReadAheadDataSource::ReadSpan(std::span<char> buf) noexcept{
+    return DImplementation->ReadSpan(buf);
+}
+
+bool CReadAheadDataSource::Borrow(std::span<const char> &span, std::size_t count) noexcept{
+    if(!count || !DImplementation->Fill()){
+        return false;
+    }
+    std::size_t Length = std::min(count, DImplementation->Available());
+    span = std::span<const char>(DImplementation->Current(), Length);
+    DImplementation->DOffset += Length;
+    return true;
+}
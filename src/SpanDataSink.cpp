@@ -0,0 +1,43 @@
+#include "SpanDataSink.h"
+#include <cstring>
+
+CSpanDataSink::CSpanDataSink(std::span<char> buf) : DBuffer(buf), DLength(0){
+
+}
+
+std::size_t CSpanDataSink::Length() const noexcept{
+    return DLength;
+}
+
+std::string_view CSpanDataSink::View() const noexcept{
+    return std::string_view(DBuffer.data(), DLength);
+}
+
+void CSpanDataSink::Clear() noexcept{
+    DLength = 0;
+}
+
+bool CSpanDataSink::Put(const char &ch) noexcept{
+    if(DLength >= DBuffer.size()){
+        return false;
+    }
+    DBuffer[DLength++] = ch;
+    return true;
+}
+
+bool CSpanDataSink::Write(const std::vector<char> &buf) noexcept{
+    return WriteSpan(buf);
+}
+
+bool CSpanDataSink::WriteSpan(std::span<const char> buf) noexcept{
+    if(buf.size() > DBuffer.size() - DLength){
+        return false;
+    }
+    // an empty span may have no data pointer at all, which memcpy rejects
+    if(buf.empty()){
+        return true;
+    }
+    std::memcpy(DBuffer.data() + DLength, buf.data(), buf.size());
+    DLength += buf.size();
+    return true;
+}
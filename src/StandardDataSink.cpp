@@ -7,6 +7,10 @@ bool CStandardDataSink::Put(const char &ch) noexcept{
 }
 
 bool CStandardDataSink::Write(const std::vector<char> &buf) noexcept{
+    return WriteSpan(buf);
+}
+
+bool CStandardDataSink::WriteSpan(std::span<const char> buf) noexcept{
     std::cout.write(buf.data(),buf.size());
     return std::cout.good();
-}
\ No newline at end of file
+}
@@ -1,38 +1,146 @@
 #include "StandardDataSource.h"
-#include <iostream>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <sys/stat.h>
+#include <unistd.h>
+
+CStandardDataSource::CStandardDataSource(std::size_t buffersize) : CStandardDataSource(STDIN_FILENO, buffersize){
+
+}
+
+CStandardDataSource::CStandardDataSource(int handle, std::size_t buffersize) : DHandle(handle), DBuffer(std::max<std::size_t>(buffersize, 1)), DOffset(0), DLength(0), DEndOfFile(false){
+
+}
+
+// Refills the buffer once it has been drained, blocking only until some input
+// is available. Returns false once end of file (or an error) is reached.
+bool CStandardDataSource::Fill() noexcept{
+    if(DOffset < DLength){
+        return true;
+    }
+    DOffset = DLength = 0;
+    while(!DEndOfFile){
+        ssize_t Result = read(DHandle, DBuffer.data(), DBuffer.size());
+        if(0 < Result){
+            DLength = Result;
+            return true;
+        }
+        if((Result < 0)&&(errno == EINTR)){
+            continue;
+        }
+        DEndOfFile = true;
+    }
+    return false;
+}
 
 bool CStandardDataSource::End() const noexcept{
-    return std::cin.eof();
+    return DEndOfFile && (DOffset >= DLength);
 }
 
 bool CStandardDataSource::Get(char &ch) noexcept{
-    if(!std::cin.good()){
+    if(!Fill()){
         return false;
     }
-    ch = std::cin.get();
-    if((ch != EOF)&&(ch != '\n')){
-        std::cin.peek();
-    }
-    return ch != EOF;
+    ch = DBuffer[DOffset++];
+    return true;
 }
 
 bool CStandardDataSource::Peek(char &ch) noexcept{
-    if(!std::cin.good()){
+    if(!Fill()){
         return false;
     }
-    ch = std::cin.peek();
-    return ch != EOF;
+    ch = DBuffer[DOffset];
+    return true;
 }
 
 bool CStandardDataSource::Read(std::vector<char> &buf, std::size_t count) noexcept{
-    if(!std::cin.good()){
+    buf.resize(count);
+    buf.resize(ReadSpan(buf));
+    return !buf.empty();
+}
+
+std::size_t CStandardDataSource::ReadSpan(std::span<char> buf) noexcept{
+    std::size_t Total = 0;
+    while(Total < buf.size()){
+        if((DOffset >= DLength) && (buf.size() - Total >= DBuffer.size()) && !DEndOfFile){
+            // Large requests skip the intermediate copy
+            ssize_t Result = read(DHandle, buf.data() + Total, buf.size() - Total);
+            if(0 < Result){
+                Total += Result;
+                continue;
+            }
+            if((Result < 0)&&(errno == EINTR)){
+                continue;
+            }
+            DEndOfFile = true;
+            break;
+        }
+        if(!Fill()){
+            break;
+        }
+        std::size_t Length = std::min(buf.size() - Total, DLength - DOffset);
+        std::memcpy(buf.data() + Total, DBuffer.data() + DOffset, Length);
+        DOffset += Length;
+        Total += Length;
+    }
+    return Total;
+}
+
+bool CStandardDataSource::Borrow(std::span<const char> &span, std::size_t count) noexcept{
+    if(!count || !Fill()){
         return false;
     }
-    char TempCh;
-    buf.clear();
-    buf.reserve(count);
-    while(buf.size() < count && Get(TempCh)){
-        buf.push_back(TempCh);
+    std::size_t Length = std::min(count, DLength - DOffset);
+    span = std::span<const char>(DBuffer.data() + DOffset, Length);
+    DOffset += Length;
+    return true;
+}
+
+bool CStandardDataSource::ReadLine(std::string &line) noexcept{
+    line.clear();
+    if(!Fill()){
+        return false;
     }
-    return !buf.empty();
+    do{
+        const char *Start = DBuffer.data() + DOffset;
+        std::size_t Remaining = DLength - DOffset;
+        const char *NewLine = static_cast<const char *>(std::memchr(Start, '\n', Remaining));
+        if(NewLine){
+            line.append(Start, NewLine - Start);
+            DOffset += NewLine - Start + 1;
+            return true;
+        }
+        line.append(Start, Remaining);
+        DOffset = DLength;
+    }while(Fill());
+    return true;
+}
+
+// Only works for descriptors of regular files, pipes and terminals fail in lseek
+bool CStandardDataSource::Seek(std::size_t offset) noexcept{
+    struct stat Status;
+    if((fstat(DHandle, &Status) != 0) || !S_ISREG(Status.st_mode) || (offset > static_cast<std::size_t>(Status.st_size))){
+        return false;
+    }
+    if(lseek(DHandle, offset, SEEK_SET) < 0){
+        return false;
+    }
+    DOffset = DLength = 0;
+    DEndOfFile = false;
+    return true;
+}
+
+// The descriptor is ahead of the caller by whatever is still buffered
+bool CStandardDataSource::Tell(std::size_t &offset) const noexcept{
+    struct stat Status;
+    if((fstat(DHandle, &Status) != 0) || !S_ISREG(Status.st_mode)){
+        return false;
+    }
+    off_t Position = lseek(DHandle, 0, SEEK_CUR);
+    if(Position < 0){
+        return false;
+    }
+    offset = Position - (DLength - DOffset);
+    return true;
 }
@@ -7,6 +7,10 @@ bool CStandardErrorDataSink::Put(const char &ch) noexcept{
 }
 
 bool CStandardErrorDataSink::Write(const std::vector<char> &buf) noexcept{
+    return WriteSpan(buf);
+}
+
+bool CStandardErrorDataSink::WriteSpan(std::span<const char> buf) noexcept{
     std::cerr.write(buf.data(),buf.size());
     return std::cerr.good();
-}
\ No newline at end of file
+}
@@ -0,0 +1,572 @@
+#include "StreetMapSnapshot.h"
+#include "FlatIDIndex.h"
+#include "FreeListAllocator.h"
+#include "XMLAtoms.h"
+
+#include <bit>
+#include <cstring>
+#include <limits>
+#include <span>
+#include <string>
+#include <vector>
+#include <sys/stat.h>
+
+namespace
+{
+    constexpr char kMagic[8] = {'S', 'M', 'A', 'P', 'S', 'N', 'A', 'P'};
+    constexpr uint32_t kVersion = 2;
+    // reads back differently on a machine of the other byte order
+    constexpr uint32_t kByteOrderMark = 0x01020304;
+    // every section starts on this boundary so the arrays can be used in place
+    constexpr std::size_t kAlignment = 8;
+
+    // The header is followed by these sections in order:
+    //   node IDs, latitudes, longitudes, tag offsets, tags
+    //   way IDs, node ref offsets, node refs, tag offsets, tags
+    //   tag key offsets, key bytes, value bytes
+    //   node ID index IDs, positions, way ID index IDs, positions
+    // where the offsets arrays have one entry more than there are elements
+    // and element i owns entries offsets[i] up to offsets[i + 1].
+    struct SHeader
+    {
+        char DMagic[8];
+        uint32_t DByteOrder;
+        uint32_t DVersion;
+        uint64_t DNodeCount;
+        uint64_t DWayCount;
+        uint64_t DWayNodeCount;
+        uint64_t DNodeAttributeCount;
+        uint64_t DWayAttributeCount;
+        uint64_t DKeyCount;
+        uint64_t DKeyBytes;
+        uint64_t DValueBytes;
+        uint64_t DNodeIndexSlots;
+        uint64_t DWayIndexSlots;
+        // stamp of the file the map was read from, zero if none was given
+        uint64_t DSourceSize;
+        uint64_t DSourceModified;
+    };
+
+    // Size and modification time in nanoseconds of filename
+    bool SourceStamp(const std::string &filename, uint64_t &size, uint64_t &modified) noexcept
+    {
+        struct stat Status;
+        if (filename.empty() || (stat(filename.c_str(), &Status) != 0))
+        {
+            return false;
+        }
+        size = Status.st_size;
+        modified = static_cast<uint64_t>(Status.st_mtim.tv_sec) * 1000000000ULL + Status.st_mtim.tv_nsec;
+        return true;
+    }
+
+    // A tag: the key by number and the value as a slice of the value bytes
+    struct SAttributeRef
+    {
+        uint32_t DKey;
+        uint32_t DValueOffset;
+        uint32_t DValueLength;
+    };
+
+    std::size_t Padding(std::size_t size) noexcept
+    {
+        return (kAlignment - size % kAlignment) % kAlignment;
+    }
+
+    template <typename T>
+    bool WriteSection(CDataSink &sink, std::span<const T> data)
+    {
+        const char Zeros[kAlignment] = {};
+        std::size_t Size = data.size() * sizeof(T);
+        return sink.WriteSpan(std::span<const char>(reinterpret_cast<const char *>(data.data()), Size)) &&
+               sink.WriteSpan(std::span<const char>(Zeros, Padding(Size)));
+    }
+
+    // Hands out consecutive sections of the mapped file
+    class CSectionReader
+    {
+        private:
+            std::span<const char> DData;
+            std::size_t DOffset = 0;
+            bool DValid = true;
+
+        public:
+            CSectionReader(std::span<const char> data, std::size_t offset)
+                : DData(data), DOffset(offset)
+            {
+            }
+
+            bool Valid() const noexcept
+            {
+                return DValid;
+            }
+
+            template <typename T>
+            std::span<const T> Next(uint64_t count) noexcept
+            {
+                std::size_t Remaining = DOffset <= DData.size() ? DData.size() - DOffset : 0;
+                if (!DValid || (count > Remaining / sizeof(T)))
+                {
+                    DValid = false;
+                    return std::span<const T>();
+                }
+                std::span<const T> Section(reinterpret_cast<const T *>(DData.data() + DOffset), count);
+                std::size_t Size = count * sizeof(T);
+                DOffset += Size + Padding(Size);
+                return Section;
+            }
+    };
+}
+
+struct CStreetMapSnapshot::SImplementation
+{
+    // Handles are made on request and keep the mapping alive; as in
+    // COpenStreetMap they come from a free list rather than the heap
+    struct SNodeHandle : public CStreetMap::SNode
+    {
+        std::shared_ptr<const SImplementation> DMap;
+        uint32_t DIndex;
+
+        SNodeHandle(std::shared_ptr<const SImplementation> map, uint32_t index)
+            : DMap(std::move(map)), DIndex(index)
+        {
+        }
+
+        TNodeID ID() const noexcept override
+        {
+            return DMap->DNodeIDs[DIndex];
+        }
+
+        SLocation Location() const noexcept override
+        {
+            return SLocation(DMap->DNodeLatitudes[DIndex], DMap->DNodeLongitudes[DIndex]);
+        }
+
+        std::size_t AttributeCount() const noexcept override
+        {
+            return Attributes().size();
+        }
+
+        std::string GetAttributeKey(std::size_t index) const noexcept override
+        {
+            return DMap->AttributeKey(Attributes(), index);
+        }
+
+        bool HasAttribute(const std::string &key) const noexcept override
+        {
+            return DMap->FindAttribute(Attributes(), key) != nullptr;
+        }
+
+        std::string GetAttribute(const std::string &key) const noexcept override
+        {
+            return DMap->AttributeValue(Attributes(), key);
+        }
+
+        std::string GetAttributeValue(std::size_t index) const noexcept override
+        {
+            return DMap->AttributeValue(Attributes(), index);
+        }
+
+        std::span<const SAttributeRef> Attributes() const noexcept
+        {
+            return Range(DMap->DNodeAttributes, DMap->DNodeAttributeOffsets, DIndex);
+        }
+    };
+
+    struct SWayHandle : public CStreetMap::SWay
+    {
+        std::shared_ptr<const SImplementation> DMap;
+        uint32_t DIndex;
+
+        SWayHandle(std::shared_ptr<const SImplementation> map, uint32_t index)
+            : DMap(std::move(map)), DIndex(index)
+        {
+        }
+
+        TWayID ID() const noexcept override
+        {
+            return DMap->DWayIDs[DIndex];
+        }
+
+        std::size_t NodeCount() const noexcept override
+        {
+            return NodeIDs().size();
+        }
+
+        TNodeID GetNodeID(std::size_t index) const noexcept override
+        {
+            auto NodeIDs = this->NodeIDs();
+            if (index >= NodeIDs.size())
+            {
+                return std::numeric_limits<CStreetMap::TNodeID>::max();
+            }
+            return NodeIDs[index];
+        }
+
+        std::size_t AttributeCount() const noexcept override
+        {
+            return Attributes().size();
+        }
+
+        std::string GetAttributeKey(std::size_t index) const noexcept override
+        {
+            return DMap->AttributeKey(Attributes(), index);
+        }
+
+        bool HasAttribute(const std::string &key) const noexcept override
+        {
+            return DMap->FindAttribute(Attributes(), key) != nullptr;
+        }
+
+        std::string GetAttribute(const std::string &key) const noexcept override
+        {
+            return DMap->AttributeValue(Attributes(), key);
+        }
+
+        std::string GetAttributeValue(std::size_t index) const noexcept override
+        {
+            return DMap->AttributeValue(Attributes(), index);
+        }
+
+        std::span<const TNodeID> NodeIDs() const noexcept
+        {
+            return Range(DMap->DWayNodeIDs, DMap->DWayNodeOffsets, DIndex);
+        }
+
+        std::span<const SAttributeRef> Attributes() const noexcept
+        {
+            return Range(DMap->DWayAttributes, DMap->DWayAttributeOffsets, DIndex);
+        }
+    };
+
+    std::shared_ptr<const CMappedFile> DFile;
+    bool DValid = false;
+    uint64_t DSourceSize = 0;
+    uint64_t DSourceModified = 0;
+
+    std::span<const TNodeID> DNodeIDs;
+    std::span<const double> DNodeLatitudes;
+    std::span<const double> DNodeLongitudes;
+    std::span<const uint32_t> DNodeAttributeOffsets;
+    std::span<const SAttributeRef> DNodeAttributes;
+    std::span<const TWayID> DWayIDs;
+    std::span<const uint32_t> DWayNodeOffsets;
+    std::span<const TNodeID> DWayNodeIDs;
+    std::span<const uint32_t> DWayAttributeOffsets;
+    std::span<const SAttributeRef> DWayAttributes;
+    std::span<const uint32_t> DKeyOffsets;
+    std::span<const char> DKeyBytes;
+    std::span<const char> DValueBytes;
+    std::span<const uint64_t> DNodeIndexIDs;
+    std::span<const uint32_t> DNodeIndexPositions;
+    std::span<const uint64_t> DWayIndexIDs;
+    std::span<const uint32_t> DWayIndexPositions;
+
+    // Element index's run of pool. Offsets are not checked on open, so a
+    // corrupt run comes back empty rather than reaching outside the file.
+    template <typename T>
+    static std::span<const T> Range(std::span<const T> pool, std::span<const uint32_t> offsets, uint32_t index) noexcept
+    {
+        uint32_t Begin = offsets[index];
+        uint32_t End = offsets[index + 1];
+        if ((Begin > End) || (End > pool.size()))
+        {
+            return std::span<const T>();
+        }
+        return pool.subspan(Begin, End - Begin);
+    }
+
+    std::string_view Key(uint32_t key) const noexcept
+    {
+        if (key + 1 >= DKeyOffsets.size())
+        {
+            return std::string_view();
+        }
+        uint32_t Begin = DKeyOffsets[key];
+        uint32_t End = DKeyOffsets[key + 1];
+        if ((Begin > End) || (End > DKeyBytes.size()))
+        {
+            return std::string_view();
+        }
+        return std::string_view(DKeyBytes.data() + Begin, End - Begin);
+    }
+
+    std::string AttributeKey(std::span<const SAttributeRef> attributes, std::size_t index) const noexcept
+    {
+        if (index >= attributes.size())
+        {
+            return std::string();
+        }
+        return std::string(Key(attributes[index].DKey));
+    }
+
+    const SAttributeRef *FindAttribute(std::span<const SAttributeRef> attributes, const std::string &key) const noexcept
+    {
+        for (const auto &Attr : attributes)
+        {
+            if (Key(Attr.DKey) == key)
+            {
+                return &Attr;
+            }
+        }
+        return nullptr;
+    }
+
+    std::string Value(const SAttributeRef *attr) const noexcept
+    {
+        if (!attr || (attr->DValueOffset > DValueBytes.size()) || (attr->DValueLength > DValueBytes.size() - attr->DValueOffset))
+        {
+            return std::string();
+        }
+        return std::string(DValueBytes.data() + attr->DValueOffset, attr->DValueLength);
+    }
+
+    std::string AttributeValue(std::span<const SAttributeRef> attributes, const std::string &key) const noexcept
+    {
+        return Value(FindAttribute(attributes, key));
+    }
+
+    std::string AttributeValue(std::span<const SAttributeRef> attributes, std::size_t index) const noexcept
+    {
+        return Value(index < attributes.size() ? &attributes[index] : nullptr);
+    }
+
+    SImplementation(std::shared_ptr<const CMappedFile> file)
+        : DFile(file)
+    {
+        DValid = Open();
+        if (!DValid)
+        {
+            *this = SImplementation();
+        }
+    }
+
+    SImplementation() = default;
+    SImplementation &operator=(SImplementation &&) = default;
+
+    bool Open()
+    {
+        auto Data = DFile ? DFile->Contents() : std::span<const char>();
+        SHeader Header;
+        if ((Data.size() < sizeof(Header)) || (reinterpret_cast<std::uintptr_t>(Data.data()) % kAlignment))
+        {
+            return false;
+        }
+        std::memcpy(&Header, Data.data(), sizeof(Header));
+        if (std::memcmp(Header.DMagic, kMagic, sizeof(kMagic)) || (Header.DByteOrder != kByteOrderMark) || (Header.DVersion != kVersion))
+        {
+            return false;
+        }
+        // positions and offsets are 32 bits
+        constexpr uint64_t MaxCount = std::numeric_limits<uint32_t>::max() - 1;
+        if ((Header.DNodeCount > MaxCount) || (Header.DWayCount > MaxCount))
+        {
+            return false;
+        }
+
+        DSourceSize = Header.DSourceSize;
+        DSourceModified = Header.DSourceModified;
+
+        CSectionReader Sections(Data, sizeof(Header) + Padding(sizeof(Header)));
+        DNodeIDs = Sections.Next<TNodeID>(Header.DNodeCount);
+        DNodeLatitudes = Sections.Next<double>(Header.DNodeCount);
+        DNodeLongitudes = Sections.Next<double>(Header.DNodeCount);
+        DNodeAttributeOffsets = Sections.Next<uint32_t>(Header.DNodeCount + 1);
+        DNodeAttributes = Sections.Next<SAttributeRef>(Header.DNodeAttributeCount);
+        DWayIDs = Sections.Next<TWayID>(Header.DWayCount);
+        DWayNodeOffsets = Sections.Next<uint32_t>(Header.DWayCount + 1);
+        DWayNodeIDs = Sections.Next<TNodeID>(Header.DWayNodeCount);
+        DWayAttributeOffsets = Sections.Next<uint32_t>(Header.DWayCount + 1);
+        DWayAttributes = Sections.Next<SAttributeRef>(Header.DWayAttributeCount);
+        DKeyOffsets = Sections.Next<uint32_t>(Header.DKeyCount + 1);
+        DKeyBytes = Sections.Next<char>(Header.DKeyBytes);
+        DValueBytes = Sections.Next<char>(Header.DValueBytes);
+        DNodeIndexIDs = Sections.Next<uint64_t>(Header.DNodeIndexSlots);
+        DNodeIndexPositions = Sections.Next<uint32_t>(Header.DNodeIndexSlots);
+        DWayIndexIDs = Sections.Next<uint64_t>(Header.DWayIndexSlots);
+        DWayIndexPositions = Sections.Next<uint32_t>(Header.DWayIndexSlots);
+        // a corrupt index could send a lookup probing forever or past the
+        // elements, so its slots are checked once here
+        return Sections.Valid() &&
+               CFlatIDIndex::Valid(DNodeIndexIDs, DNodeIndexPositions, Header.DNodeCount) &&
+               CFlatIDIndex::Valid(DWayIndexIDs, DWayIndexPositions, Header.DWayCount);
+    }
+
+    std::shared_ptr<SNodeHandle> Node(uint32_t index, const std::shared_ptr<SImplementation> &self) const noexcept
+    {
+        if (index >= DNodeIDs.size())
+        {
+            return nullptr;
+        }
+        return std::allocate_shared<SNodeHandle>(CFreeListAllocator<SNodeHandle>(), self, index);
+    }
+
+    std::shared_ptr<SWayHandle> Way(uint32_t index, const std::shared_ptr<SImplementation> &self) const noexcept
+    {
+        if (index >= DWayIDs.size())
+        {
+            return nullptr;
+        }
+        return std::allocate_shared<SWayHandle>(CFreeListAllocator<SWayHandle>(), self, index);
+    }
+};
+
+CStreetMapSnapshot::CStreetMapSnapshot(std::shared_ptr<const CMappedFile> file)
+    : DImplementation(std::make_shared<SImplementation>(file))
+{
+}
+
+CStreetMapSnapshot::~CStreetMapSnapshot() = default;
+
+bool CStreetMapSnapshot::Valid() const noexcept
+{
+    return DImplementation->DValid;
+}
+
+bool CStreetMapSnapshot::MatchesSource(const std::string &filename) const noexcept
+{
+    uint64_t Size, Modified;
+    return DImplementation->DValid && DImplementation->DSourceModified && SourceStamp(filename, Size, Modified) &&
+           (Size == DImplementation->DSourceSize) && (Modified == DImplementation->DSourceModified);
+}
+
+bool CStreetMapSnapshot::Write(const CStreetMap &map, std::shared_ptr<CDataSink> sink, const std::string &source)
+{
+    std::vector<TNodeID> NodeIDs;
+    std::vector<double> NodeLatitudes, NodeLongitudes;
+    std::vector<uint32_t> NodeAttributeOffsets{0};
+    std::vector<SAttributeRef> NodeAttributes;
+    std::vector<TWayID> WayIDs;
+    std::vector<uint32_t> WayNodeOffsets{0};
+    std::vector<TNodeID> WayNodeIDs;
+    std::vector<uint32_t> WayAttributeOffsets{0};
+    std::vector<SAttributeRef> WayAttributes;
+    CXMLAtomTable Keys;
+    std::string ValueBytes;
+    constexpr std::size_t MaxSize = std::numeric_limits<uint32_t>::max() - 1;
+
+    auto AddAttributes = [&](const auto &element, std::vector<SAttributeRef> &attributes) {
+        for (std::size_t Index = 0; Index < element.AttributeCount(); Index++)
+        {
+            auto Key = element.GetAttributeKey(Index);
+            auto Value = element.GetAttributeValue(Index);
+            attributes.push_back(SAttributeRef{Keys.Intern(Key), static_cast<uint32_t>(ValueBytes.size()), static_cast<uint32_t>(Value.size())});
+            ValueBytes.append(Value);
+        }
+    };
+    for (std::size_t Index = 0; Index < map.NodeCount(); Index++)
+    {
+        auto Node = map.NodeByIndex(Index);
+        auto Location = Node->Location();
+        NodeIDs.push_back(Node->ID());
+        NodeLatitudes.push_back(Location.DLatitude);
+        NodeLongitudes.push_back(Location.DLongitude);
+        AddAttributes(*Node, NodeAttributes);
+        NodeAttributeOffsets.push_back(static_cast<uint32_t>(NodeAttributes.size()));
+    }
+    for (std::size_t Index = 0; Index < map.WayCount(); Index++)
+    {
+        auto Way = map.WayByIndex(Index);
+        WayIDs.push_back(Way->ID());
+        for (std::size_t Node = 0; Node < Way->NodeCount(); Node++)
+        {
+            WayNodeIDs.push_back(Way->GetNodeID(Node));
+        }
+        WayNodeOffsets.push_back(static_cast<uint32_t>(WayNodeIDs.size()));
+        AddAttributes(*Way, WayAttributes);
+        WayAttributeOffsets.push_back(static_cast<uint32_t>(WayAttributes.size()));
+    }
+    if ((NodeIDs.size() > MaxSize) || (WayIDs.size() > MaxSize) || (NodeAttributes.size() > MaxSize) ||
+        (WayNodeIDs.size() > MaxSize) || (WayAttributes.size() > MaxSize) || (ValueBytes.size() > MaxSize))
+    {
+        return false;
+    }
+
+    std::vector<uint32_t> KeyOffsets{0};
+    std::string KeyBytes;
+    for (TXMLAtom Key = 0; Key < Keys.Size(); Key++)
+    {
+        KeyBytes.append(Keys.Name(Key));
+        KeyOffsets.push_back(static_cast<uint32_t>(KeyBytes.size()));
+    }
+    CFlatIDIndex NodeIndex(NodeIDs);
+    CFlatIDIndex WayIndex(WayIDs);
+
+    SHeader Header{};
+    std::memcpy(Header.DMagic, kMagic, sizeof(kMagic));
+    Header.DByteOrder = kByteOrderMark;
+    Header.DVersion = kVersion;
+    Header.DNodeCount = NodeIDs.size();
+    Header.DWayCount = WayIDs.size();
+    Header.DWayNodeCount = WayNodeIDs.size();
+    Header.DNodeAttributeCount = NodeAttributes.size();
+    Header.DWayAttributeCount = WayAttributes.size();
+    Header.DKeyCount = Keys.Size();
+    Header.DKeyBytes = KeyBytes.size();
+    Header.DValueBytes = ValueBytes.size();
+    Header.DNodeIndexSlots = NodeIndex.IDs().size();
+    Header.DWayIndexSlots = WayIndex.IDs().size();
+    if (!SourceStamp(source, Header.DSourceSize, Header.DSourceModified))
+    {
+        Header.DSourceSize = Header.DSourceModified = 0;
+    }
+
+    auto &Sink = *sink;
+    return WriteSection<char>(Sink, std::span<const char>(reinterpret_cast<const char *>(&Header), sizeof(Header))) &&
+           WriteSection<TNodeID>(Sink, NodeIDs) &&
+           WriteSection<double>(Sink, NodeLatitudes) &&
+           WriteSection<double>(Sink, NodeLongitudes) &&
+           WriteSection<uint32_t>(Sink, NodeAttributeOffsets) &&
+           WriteSection<SAttributeRef>(Sink, NodeAttributes) &&
+           WriteSection<TWayID>(Sink, WayIDs) &&
+           WriteSection<uint32_t>(Sink, WayNodeOffsets) &&
+           WriteSection<TNodeID>(Sink, WayNodeIDs) &&
+           WriteSection<uint32_t>(Sink, WayAttributeOffsets) &&
+           WriteSection<SAttributeRef>(Sink, WayAttributes) &&
+           WriteSection<uint32_t>(Sink, KeyOffsets) &&
+           WriteSection<char>(Sink, KeyBytes) &&
+           WriteSection<char>(Sink, ValueBytes) &&
+           WriteSection<uint64_t>(Sink, NodeIndex.IDs()) &&
+           WriteSection<uint32_t>(Sink, NodeIndex.Positions()) &&
+           WriteSection<uint64_t>(Sink, WayIndex.IDs()) &&
+           WriteSection<uint32_t>(Sink, WayIndex.Positions()) &&
+           Sink.Flush();
+}
+
+std::size_t CStreetMapSnapshot::NodeCount() const noexcept
+{
+    return DImplementation->DNodeIDs.size();
+}
+
+std::size_t CStreetMapSnapshot::WayCount() const noexcept
+{
+    return DImplementation->DWayIDs.size();
+}
+
+std::shared_ptr<CStreetMap::SNode> CStreetMapSnapshot::NodeByIndex(std::size_t index) const noexcept
+{
+    if (index >= NodeCount())
+    {
+        return nullptr;
+    }
+    return DImplementation->Node(index, DImplementation);
+}
+
+std::shared_ptr<CStreetMap::SNode> CStreetMapSnapshot::NodeByID(TNodeID id) const noexcept
+{
+    return DImplementation->Node(CFlatIDIndex::Find(DImplementation->DNodeIndexIDs, DImplementation->DNodeIndexPositions, id), DImplementation);
+}
+
+std::shared_ptr<CStreetMap::SWay> CStreetMapSnapshot::WayByIndex(std::size_t index) const noexcept
+{
+    if (index >= WayCount())
+    {
+        return nullptr;
+    }
+    return DImplementation->Way(index, DImplementation);
+}
+
+std::shared_ptr<CStreetMap::SWay> CStreetMapSnapshot::WayByID(TWayID id) const noexcept
+{
+    return DImplementation->Way(CFlatIDIndex::Find(DImplementation->DWayIndexIDs, DImplementation->DWayIndexPositions, id), DImplementation);
+}
@@ -1,15 +1,33 @@
 #include "StringDataSink.h"
 
+CStringDataSink::CStringDataSink(std::size_t capacity){
+    DString.reserve(capacity);
+}
+
 const std::string &CStringDataSink::String() const{
     return DString;
 }
 
+void CStringDataSink::Reserve(std::size_t capacity){
+    DString.reserve(capacity);
+}
+
+std::string CStringDataSink::Release() noexcept{
+    std::string Result = std::move(DString);
+    DString.clear();
+    return Result;
+}
+
 bool CStringDataSink::Put(const char &ch) noexcept{
-    DString += std::string(1,ch);
+    DString.push_back(ch);
     return true;
 }
 
 bool CStringDataSink::Write(const std::vector<char> &buf) noexcept{
-    DString += std::string(buf.data(),buf.size());
+    return WriteSpan(buf);
+}
+
+bool CStringDataSink::WriteSpan(std::span<const char> buf) noexcept{
+    DString.append(buf.data(),buf.size());
     return true;
 }
@@ -0,0 +1,69 @@
+#include "StringViewDataSource.h"
+#include <algorithm>
+#include <cstring>
+
+CStringViewDataSource::CStringViewDataSource(std::string_view str) : DString(str), DIndex(0){
+
+}
+
+bool CStringViewDataSource::End() const noexcept{
+    return DIndex >= DString.length();
+}
+
+bool CStringViewDataSource::Get(char &ch) noexcept{
+    if(DIndex < DString.length()){
+        ch = DString[DIndex];
+        DIndex++;
+        return true;
+    }
+    return false;
+}
+
+bool CStringViewDataSource::Peek(char &ch) noexcept{
+    if(DIndex < DString.length()){
+        ch = DString[DIndex];
+        return true;
+    }
+    return false;
+}
+
+bool CStringViewDataSource::Read(std::vector<char> &buf, std::size_t count) noexcept{
+    std::size_t Length = std::min(count, DString.length() - DIndex);
+    buf.assign(DString.data() + DIndex, DString.data() + DIndex + Length);
+    DIndex += Length;
+    return !buf.empty();
+}
+
+std::size_t CStringViewDataSource::ReadSpan(std::span<char> buf) noexcept{
+    std::size_t Length = std::min(buf.size(), DString.length() - DIndex);
+    std::memcpy(buf.data(), DString.data() + DIndex, Length);
+    DIndex += Length;
+    return Length;
+}
+
+bool CStringViewDataSource::Borrow(std::span<const char> &span, std::size_t count) noexcept{
+    std::size_t Length = std::min(count, DString.length() - DIndex);
+    if(!Length){
+        return false;
+    }
+    span = std::span<const char>(DString.data() + DIndex, Length);
+    DIndex += Length;
+    return true;
+}
+
+bool CStringViewDataSource::ReadLine(std::string &line) noexcept{
+    return ReadLineFrom(DString, DIndex, line);
+}
+
+bool CStringViewDataSource::Seek(std::size_t offset) noexcept{
+    if(offset > DString.length()){
+        return false;
+    }
+    DIndex = offset;
+    return true;
+}
+
+bool CStringViewDataSource::Tell(std::size_t &offset) const noexcept{
+    offset = DIndex;
+    return true;
+}
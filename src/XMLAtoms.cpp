@@ -0,0 +1,103 @@
+#include "XMLAtoms.h"
+
+namespace
+{
+    constexpr std::size_t kInitialSlots = 64;
+
+    // FNV-1a, names are only a few bytes long
+    std::size_t HashName(std::string_view name) noexcept
+    {
+        std::size_t Hash = 14695981039346656037ULL;
+        for (auto Ch : name)
+        {
+            Hash = (Hash ^ static_cast<unsigned char>(Ch)) * 1099511628211ULL;
+        }
+        return Hash;
+    }
+}
+
+// Slot holding name, or the empty slot where it belongs
+std::size_t CXMLAtomTable::FindSlot(std::string_view name) const noexcept
+{
+    std::size_t Mask = DSlots.size() - 1;
+    std::size_t Slot = HashName(name) & Mask;
+    while ((DSlots[Slot] != InvalidAtom) && (DSlotNames[Slot] != name))
+    {
+        Slot = (Slot + 1) & Mask;
+    }
+    return Slot;
+}
+
+TXMLAtom CXMLAtomTable::Intern(std::string_view name)
+{
+    if (DSlots.empty())
+    {
+        DSlots.assign(kInitialSlots, InvalidAtom);
+        DSlotNames.resize(kInitialSlots);
+    }
+    std::size_t Slot = FindSlot(name);
+    if (DSlots[Slot] != InvalidAtom)
+    {
+        return DSlots[Slot];
+    }
+    TXMLAtom Atom = static_cast<TXMLAtom>(DNames.size());
+    DSlots[Slot] = Atom;
+    DSlotNames[Slot] = DNames.emplace_back(name);
+    // keep the table at most half full so probes stay short
+    if (DNames.size() * 2 > DSlots.size())
+    {
+        DSlots.assign(DSlots.size() * 2, InvalidAtom);
+        DSlotNames.assign(DSlots.size(), std::string_view());
+        for (TXMLAtom Index = 0; Index < DNames.size(); Index++)
+        {
+            Slot = FindSlot(DNames[Index]);
+            DSlots[Slot] = Index;
+            DSlotNames[Slot] = DNames[Index];
+        }
+    }
+    return Atom;
+}
+
+TXMLAtom CXMLAtomTable::Find(std::string_view name) const noexcept
+{
+    if (DSlots.empty())
+    {
+        return InvalidAtom;
+    }
+    return DSlots[FindSlot(name)];
+}
+
+std::string_view CXMLAtomTable::Name(TXMLAtom atom) const noexcept
+{
+    return atom < DNames.size() ? std::string_view(DNames[atom]) : std::string_view();
+}
+
+std::size_t CXMLAtomTable::Size() const noexcept
+{
+    return DNames.size();
+}
+
+void CXMLAttributes::Clear() noexcept
+{
+    // only the positions of the previous element need resetting
+    for (auto Atom : DAtoms)
+    {
+        DPositions[Atom] = 0;
+    }
+    DAttributes.clear();
+    DAtoms.clear();
+}
+
+void CXMLAttributes::Add(TXMLAtom atom, std::string_view name, std::string_view value)
+{
+    if (atom >= DPositions.size())
+    {
+        DPositions.resize(atom + 1, 0);
+    }
+    if (!DPositions[atom])
+    {
+        DPositions[atom] = static_cast<uint32_t>(DAttributes.size() + 1);
+    }
+    DAttributes.emplace_back(name, value);
+    DAtoms.push_back(atom);
+}
@@ -1,29 +1,87 @@
 #include "XMLReader.h"
+#include "XMLTokenizer.h"
 
 #include <expat.h>
 
+#include <array>
 #include <deque>
 #include <vector>
 
 namespace
 {
     constexpr std::size_t kReadBufferSize = 4096;
+    // borrowed chunks cost nothing to produce, so hand expat bigger slices
+    constexpr std::size_t kBorrowSize = 65536;
 }
 
 struct CXMLReader::SImplementation
 {
+    // Turns events into entities for the pull interface
+    struct SQueueHandler : public CXMLHandler
+    {
+        std::deque<SXMLEntity> DQueue;
+
+        void StartElement(TXMLAtom /*atom*/, std::string_view name, const CXMLAttributes &attributes) override
+        {
+            SXMLEntity &Entity = DQueue.emplace_back();
+            Entity.DType = SXMLEntity::EType::StartElement;
+            Entity.DNameData.assign(name);
+            Entity.DAttributes.reserve(attributes.Count());
+            for (auto &Attribute : attributes.Views())
+            {
+                Entity.DAttributes.emplace_back(std::string(Attribute.first), std::string(Attribute.second));
+            }
+        }
+
+        void EndElement(TXMLAtom /*atom*/, std::string_view name) override
+        {
+            SXMLEntity &Entity = DQueue.emplace_back();
+            Entity.DType = SXMLEntity::EType::EndElement;
+            Entity.DNameData.assign(name);
+        }
+
+        void CharData(std::string_view data) override
+        {
+            SXMLEntity &Entity = DQueue.emplace_back();
+            Entity.DType = SXMLEntity::EType::CharData;
+            Entity.DNameData.assign(data);
+        }
+    };
+
     std::shared_ptr<CDataSource> DSource;
+    // only one of the parsers is created
+    std::unique_ptr<CXMLTokenizer> DTokenizer;
+    SXMLToken DToken;
     XML_Parser DParser;
-    std::deque<SXMLEntity> DQueue;
+    SQueueHandler DQueueHandler;
+    std::deque<SXMLEntity> &DQueue;
+    // where expat events go, the queue unless Parse is running
+    CXMLHandler *DHandler;
+    CXMLAtomTable DAtoms;
+    CXMLAttributes DAttributes;
+    // atom and name of the attribute last seen at each position; elements of
+    // one kind list their attributes in the same order, so most names match
+    // and skip hashing
+    std::vector<std::pair<std::string_view, TXMLAtom>> DAttributeAtomCache;
+    // atoms of the open elements, which end elements reuse
+    std::vector<TXMLAtom> DOpenAtoms;
+    std::array<char, kReadBufferSize> DBuffer;
     bool DDone;
     bool DParseError;
 
-    SImplementation(std::shared_ptr<CDataSource> src)
+    SImplementation(std::shared_ptr<CDataSource> src, EParser parser)
         : DSource(src),
           DParser(nullptr),
+          DQueue(DQueueHandler.DQueue),
+          DHandler(&DQueueHandler),
           DDone(false),
           DParseError(false)
     {
+        if (parser == EParser::Native)
+        {
+            DTokenizer = std::make_unique<CXMLTokenizer>(src);
+            return;
+        }
         // init Expat
         DParser = XML_ParserCreate(nullptr);
         // if (!DParser)
@@ -47,48 +105,163 @@ struct CXMLReader::SImplementation
     static void StartElementHandler(void *userData, const XML_Char *name, const XML_Char **atts)
     {
         auto *This = static_cast<SImplementation *>(userData);
-        SXMLEntity Entity;
-        Entity.DType = SXMLEntity::EType::StartElement;
-        Entity.DNameData = name ? std::string(name) : std::string();
-
+        This->DAttributes.Clear();
         if (atts)
         {
             for (int Index = 0; atts[Index] != nullptr; Index += 2)
             {
-                std::string AttrName = atts[Index] ? std::string(atts[Index]) : std::string();
-                std::string AttrValue = atts[Index + 1] ? std::string(atts[Index + 1]) : std::string();
-                Entity.DAttributes.push_back(std::make_pair(AttrName, AttrValue));
+                This->AddAttribute(atts[Index], atts[Index + 1] ? atts[Index + 1] : "");
             }
         }
-        This->DQueue.push_back(Entity);
+        std::string_view Name = name ? name : "";
+        This->DHandler->StartElement(This->StartAtom(Name), Name, This->DAttributes);
     }
 
     static void EndElementHandler(void *userData, const XML_Char *name)
     {
         auto *This = static_cast<SImplementation *>(userData);
-        SXMLEntity Entity;
-        Entity.DType = SXMLEntity::EType::EndElement;
-        Entity.DNameData = name ? std::string(name) : std::string();
-        This->DQueue.push_back(Entity);
+        std::string_view Name = name ? name : "";
+        This->DHandler->EndElement(This->EndAtom(Name), Name);
     }
 
     static void CharacterDataHandler(void *userData, const XML_Char *s, int len)
     {
         auto *This = static_cast<SImplementation *>(userData);
-        SXMLEntity Entity;
-        Entity.DType = SXMLEntity::EType::CharData;
-        Entity.DNameData.assign(s, s + len);
-        This->DQueue.push_back(Entity);
+        This->DHandler->CharData(std::string_view(s, len));
+    }
+
+    void AddAttribute(std::string_view name, std::string_view value)
+    {
+        std::size_t Index = DAttributes.Count();
+        if (Index >= DAttributeAtomCache.size())
+        {
+            DAttributeAtomCache.resize(Index + 1, std::make_pair(std::string_view(), CXMLAtomTable::InvalidAtom));
+        }
+        auto &Cached = DAttributeAtomCache[Index];
+        if ((Cached.second == CXMLAtomTable::InvalidAtom) || (Cached.first != name))
+        {
+            Cached.second = DAtoms.Intern(name);
+            Cached.first = DAtoms.Name(Cached.second);
+        }
+        DAttributes.Add(Cached.second, name, value);
+    }
+
+    TXMLAtom StartAtom(std::string_view name)
+    {
+        return DOpenAtoms.emplace_back(DAtoms.Intern(name));
+    }
+
+    // the parsers check that end tags match, so the atom is the open
+    // element's, unless it was opened by ReadEntity before Parse was called
+    TXMLAtom EndAtom(std::string_view name)
+    {
+        if (DOpenAtoms.empty())
+        {
+            return DAtoms.Intern(name);
+        }
+        TXMLAtom Atom = DOpenAtoms.back();
+        DOpenAtoms.pop_back();
+        return Atom;
+    }
+
+    bool Parse(CXMLHandler &handler)
+    {
+        if (DTokenizer)
+        {
+            while (DTokenizer->ReadToken(DToken))
+            {
+                switch (DToken.DType)
+                {
+                case SXMLEntity::EType::StartElement:
+                    DAttributes.Clear();
+                    for (auto &Attribute : DToken.DAttributes)
+                    {
+                        AddAttribute(Attribute.first, Attribute.second);
+                    }
+                    handler.StartElement(StartAtom(DToken.DNameData), DToken.DNameData, DAttributes);
+                    break;
+                case SXMLEntity::EType::EndElement:
+                    handler.EndElement(EndAtom(DToken.DNameData), DToken.DNameData);
+                    break;
+                default:
+                    handler.CharData(DToken.DNameData);
+                    break;
+                }
+            }
+            return !DTokenizer->Failed();
+        }
+        // entities parsed ahead for ReadEntity come first
+        for (auto &Entity : DQueue)
+        {
+            switch (Entity.DType)
+            {
+            case SXMLEntity::EType::StartElement:
+                DAttributes.Clear();
+                for (auto &Attribute : Entity.DAttributes)
+                {
+                    AddAttribute(Attribute.first, Attribute.second);
+                }
+                handler.StartElement(DAtoms.Intern(Entity.DNameData), Entity.DNameData, DAttributes);
+                break;
+            case SXMLEntity::EType::EndElement:
+                handler.EndElement(DAtoms.Intern(Entity.DNameData), Entity.DNameData);
+                break;
+            default:
+                handler.CharData(Entity.DNameData);
+                break;
+            }
+        }
+        DQueue.clear();
+        DHandler = &handler;
+        while (!DDone && !DParseError)
+        {
+            ParseMore();
+        }
+        DHandler = &DQueueHandler;
+        return !DParseError;
+    }
+
+    // Copies the next token into entity, reusing the strings it already holds
+    bool ReadToken(SXMLEntity &entity, bool skipcdata)
+    {
+        do
+        {
+            if (!DTokenizer->ReadToken(DToken))
+            {
+                return false;
+            }
+        } while (skipcdata && (DToken.DType == SXMLEntity::EType::CharData));
+        entity.DType = DToken.DType;
+        entity.DNameData.assign(DToken.DNameData);
+        entity.DAttributes.resize(DToken.DAttributes.size());
+        for (std::size_t Index = 0; Index < DToken.DAttributes.size(); Index++)
+        {
+            entity.DAttributes[Index].first.assign(DToken.DAttributes[Index].first);
+            entity.DAttributes[Index].second.assign(DToken.DAttributes[Index].second);
+        }
+        return true;
     }
 
     bool ParseMore()
     {
+        std::span<const char> Borrowed;
+        if (DSource->Borrow(Borrowed, kBorrowSize))
+        {
+            // parse straight out of the source's storage
+            if (XML_Parse(DParser, Borrowed.data(), static_cast<int>(Borrowed.size()), XML_FALSE) == XML_STATUS_ERROR)
+            {
+                DParseError = true;
+                DQueue.clear();
+                return false;
+            }
+            return true;
+        }
 
-        std::vector<char> Buffer;
-        if (DSource->Read(Buffer, kReadBufferSize) && !Buffer.empty())
+        std::size_t Length = DSource->ReadSpan(DBuffer);
+        if (Length)
         {
             // feed next chunk into expat
-            if (XML_Parse(DParser, Buffer.data(), static_cast<int>(Buffer.size()), XML_FALSE) == XML_STATUS_ERROR)
+            if (XML_Parse(DParser, DBuffer.data(), static_cast<int>(Length), XML_FALSE) == XML_STATUS_ERROR)
             {
                 DParseError = true;
                 DQueue.clear();
@@ -109,21 +282,29 @@ struct CXMLReader::SImplementation
     }
 };
 
-CXMLReader::CXMLReader(std::shared_ptr<CDataSource> src)
+CXMLReader::CXMLReader(std::shared_ptr<CDataSource> src, EParser parser)
 {
-    DImplementation = std::make_unique<SImplementation>(src);
+    DImplementation = std::make_unique<SImplementation>(src, parser);
 }
 
 CXMLReader::~CXMLReader() = default;
 
 bool CXMLReader::End() const
 {
+    if (DImplementation->DTokenizer)
+    {
+        return DImplementation->DTokenizer->End();
+    }
     // parsing is complete if 1) no more input OR 2) error OR 3) queue is empty
     return (DImplementation->DDone || DImplementation->DParseError) && DImplementation->DQueue.empty();
 }
 
 bool CXMLReader::ReadEntity(SXMLEntity &entity, bool skipcdata)
 {
+    if (DImplementation->DTokenizer)
+    {
+        return DImplementation->ReadToken(entity, skipcdata);
+    }
     while (true)
     {
         if (DImplementation->DQueue.empty())
@@ -148,3 +329,13 @@ bool CXMLReader::ReadEntity(SXMLEntity &entity, bool skipcdata)
     }
     return false;
 }
+
+bool CXMLReader::Parse(CXMLHandler &handler)
+{
+    return DImplementation->Parse(handler);
+}
+
+CXMLAtomTable &CXMLReader::Atoms()
+{
+    return DImplementation->DAtoms;
+}
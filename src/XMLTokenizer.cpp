@@ -0,0 +1,648 @@
+#include "XMLTokenizer.h"
+#include "ByteScan.h"
+
+#include <charconv>
+#include <cstdint>
+#include <cstring>
+
+namespace
+{
+    constexpr std::size_t kReadSize = 65536;
+    // how much of a lent block is first copied behind a token split across
+    // blocks; it doubles while the token is still incomplete
+    constexpr std::size_t kStraddleCopySize = 4096;
+
+    bool IsSpace(char ch)
+    {
+        return (ch == ' ') || (ch == '\t') || (ch == '\n') || (ch == '\r');
+    }
+
+    // Appends code as UTF-8, returning false for values that are not characters
+    bool AppendUTF8(std::string &out, uint32_t code)
+    {
+        if ((code == 0) || ((0xD800 <= code) && (code <= 0xDFFF)) || (0x10FFFF < code))
+        {
+            return false;
+        }
+        if (code < 0x80)
+        {
+            out += char(code);
+        }
+        else if (code < 0x800)
+        {
+            out += char(0xC0 | (code >> 6));
+            out += char(0x80 | (code & 0x3F));
+        }
+        else if (code < 0x10000)
+        {
+            out += char(0xE0 | (code >> 12));
+            out += char(0x80 | ((code >> 6) & 0x3F));
+            out += char(0x80 | (code & 0x3F));
+        }
+        else
+        {
+            out += char(0xF0 | (code >> 18));
+            out += char(0x80 | ((code >> 12) & 0x3F));
+            out += char(0x80 | ((code >> 6) & 0x3F));
+            out += char(0x80 | (code & 0x3F));
+        }
+        return true;
+    }
+}
+
+// Tokens are parsed straight out of the blocks the source lends through
+// Borrow. Each markup or text run is parsed from its first byte; if it is
+// not complete yet nothing is consumed, and the unparsed tail is copied to
+// DBuffer followed by the start of the next block, growing until the token
+// is complete. Parsing then moves back onto the lent block. Sources that
+// cannot lend are read into DBuffer a block at a time. Names and values are
+// views into the current input unless references or line ends had to be
+// rewritten, in which case they live in DScratch.
+struct CXMLTokenizer::SImplementation
+{
+    enum class EResult
+    {
+        Token,
+        Skipped,
+        More,
+        Error
+    };
+
+    enum class EText
+    {
+        CharData,
+        Attribute,
+        CData
+    };
+
+    // Location of a name or value, either in DInput or in DScratch
+    struct SPiece
+    {
+        bool DInScratch;
+        std::size_t DOffset;
+        std::size_t DLength;
+    };
+
+    std::shared_ptr<CDataSource> DSource;
+    // the input being parsed, a lent block or DBuffer
+    std::string_view DInput;
+    std::size_t DOffset;
+    std::string DBuffer;
+    // lent block whose first DLentCopied bytes were copied into DBuffer from
+    // DLentStart on, to be returned to once parsing gets past DLentStart
+    std::span<const char> DLent;
+    std::size_t DLentStart;
+    std::size_t DLentCopied;
+    std::string DScratch;
+    std::vector<std::pair<SPiece, SPiece>> DAttributes;
+    // copies of the open element names, DDepth of them are in use
+    std::vector<std::string> DOpenElements;
+    std::size_t DDepth;
+    bool DSeenRoot;
+    bool DPendingEnd;
+    bool DFinished;
+    bool DFailed;
+
+    SImplementation(std::shared_ptr<CDataSource> src)
+        : DSource(src),
+          DOffset(0),
+          DLentStart(0),
+          DLentCopied(0),
+          DDepth(0),
+          DSeenRoot(false),
+          DPendingEnd(false),
+          DFinished(false),
+          DFailed(false)
+    {
+    }
+
+    // Copies the next stretch of the lent block behind the unparsed input
+    void CopyLent()
+    {
+        std::size_t Length = std::min(DLent.size() - DLentCopied, std::max(DBuffer.size(), kStraddleCopySize));
+        DBuffer.append(DLent.data() + DLentCopied, Length);
+        DLentCopied += Length;
+        DInput = DBuffer;
+    }
+
+    // Moves back onto the lent block once the token that straddled into it
+    // has been parsed out of DBuffer
+    void Resume()
+    {
+        if (DLent.empty() || (DOffset < DLentStart))
+        {
+            return;
+        }
+        DInput = std::string_view(DLent.data(), DLent.size());
+        DOffset -= DLentStart;
+        DLent = std::span<const char>();
+        DBuffer.clear();
+    }
+
+    // Makes more input available behind the unparsed rest of DInput,
+    // returns false at the end of the source
+    bool Fill()
+    {
+        if (!DLent.empty())
+        {
+            // still inside the token that straddles into the lent block
+            DBuffer.erase(0, DOffset);
+            DLentStart -= DOffset;
+            DOffset = 0;
+            if (DLentCopied < DLent.size())
+            {
+                CopyLent();
+                return true;
+            }
+            // all of it copied, so nothing refers to the block any more
+            DLent = std::span<const char>();
+        }
+        else if (DInput.data() != DBuffer.data())
+        {
+            // the rest of a lent block has to be kept before borrowing again
+            DBuffer.assign(DInput.substr(DOffset));
+            DOffset = 0;
+        }
+        else
+        {
+            DBuffer.erase(0, DOffset);
+            DOffset = 0;
+        }
+        std::span<const char> Block;
+        if (DSource->Borrow(Block, kReadSize))
+        {
+            if (DBuffer.empty())
+            {
+                DInput = std::string_view(Block.data(), Block.size());
+                return true;
+            }
+            DLent = Block;
+            DLentStart = DBuffer.size();
+            DLentCopied = 0;
+            CopyLent();
+            return true;
+        }
+        std::size_t Used = DBuffer.size();
+        DBuffer.resize(Used + kReadSize);
+        std::size_t Length = DSource->ReadSpan(std::span<char>(DBuffer.data() + Used, kReadSize));
+        DBuffer.resize(Used + Length);
+        DInput = DBuffer;
+        return Length != 0;
+    }
+
+    std::string_view View(const SPiece &piece) const
+    {
+        return (piece.DInScratch ? std::string_view(DScratch) : DInput).substr(piece.DOffset, piece.DLength);
+    }
+
+    bool DecodeReference(std::string_view name)
+    {
+        if (name == "lt")
+        {
+            DScratch += '<';
+        }
+        else if (name == "gt")
+        {
+            DScratch += '>';
+        }
+        else if (name == "amp")
+        {
+            DScratch += '&';
+        }
+        else if (name == "quot")
+        {
+            DScratch += '\"';
+        }
+        else if (name == "apos")
+        {
+            DScratch += '\'';
+        }
+        else
+        {
+            // only character references are left, &#NNN; or &#xHHH;
+            if ((name.size() < 2) || (name[0] != '#'))
+            {
+                return false;
+            }
+            int Base = name[1] == 'x' ? 16 : 10;
+            name.remove_prefix(Base == 16 ? 2 : 1);
+            uint32_t Code;
+            auto [End, Error] = std::from_chars(name.data(), name.data() + name.size(), Code, Base);
+            if (name.empty() || (Error != std::errc()) || (End != name.data() + name.size()))
+            {
+                return false;
+            }
+            return AppendUTF8(DScratch, Code);
+        }
+        return true;
+    }
+
+    // Appends raw to DScratch resolving references and normalizing line ends
+    // (and, in attributes, whitespace) the way an XML processor must
+    bool Decode(std::string_view raw, EText kind)
+    {
+        std::string_view Special = kind == EText::Attribute ? "&\r\t\n" : (kind == EText::CharData ? "&\r" : "\r");
+        while (!raw.empty())
+        {
+            std::size_t Length = ByteScan::FindAny(raw, Special);
+            DScratch.append(raw.data(), Length);
+            if (Length == raw.size())
+            {
+                break;
+            }
+            char Ch = raw[Length];
+            raw.remove_prefix(Length + 1);
+            if (Ch == '&')
+            {
+                auto Semicolon = raw.find(';');
+                if ((Semicolon == std::string_view::npos) || !DecodeReference(raw.substr(0, Semicolon)))
+                {
+                    return false;
+                }
+                raw.remove_prefix(Semicolon + 1);
+                continue;
+            }
+            if ((Ch == '\r') && !raw.empty() && (raw[0] == '\n'))
+            {
+                raw.remove_prefix(1);
+            }
+            DScratch += kind == EText::Attribute ? ' ' : '\n';
+        }
+        return true;
+    }
+
+    void SetToken(SXMLToken &token, SXMLEntity::EType type, std::string_view name)
+    {
+        token.DType = type;
+        token.DNameData = name;
+        token.DAttributes.clear();
+    }
+
+    EResult ParseText(SXMLToken &token, std::string_view input)
+    {
+        std::size_t Special = ByteScan::FindAny(input, "<&\r");
+        std::size_t Length = Special;
+        if ((Special < input.size()) && (input[Special] != '<'))
+        {
+            auto Less = input.find('<', Special);
+            Length = Less == std::string_view::npos ? input.size() : Less;
+        }
+        if (Length == input.size())
+        {
+            return EResult::More;
+        }
+        std::string_view Raw = input.substr(0, Length);
+        if (!DDepth)
+        {
+            // only whitespace may surround the root element
+            for (auto Ch : Raw)
+            {
+                if (!IsSpace(Ch))
+                {
+                    return EResult::Error;
+                }
+            }
+            DOffset += Length;
+            return EResult::Skipped;
+        }
+        if (Special == Length)
+        {
+            SetToken(token, SXMLEntity::EType::CharData, Raw);
+        }
+        else
+        {
+            DScratch.clear();
+            if (!Decode(Raw, EText::CharData))
+            {
+                return EResult::Error;
+            }
+            SetToken(token, SXMLEntity::EType::CharData, DScratch);
+        }
+        DOffset += Length;
+        return EResult::Token;
+    }
+
+    EResult ParseDeclaration(SXMLToken &token, std::string_view input)
+    {
+        const std::string_view Comment = "<!--";
+        const std::string_view CData = "<![CDATA[";
+        const std::string_view DocType = "<!DOCTYPE";
+        if (input.starts_with(Comment))
+        {
+            auto Close = input.find("-->", Comment.size());
+            if (Close == std::string_view::npos)
+            {
+                return EResult::More;
+            }
+            DOffset += Close + 3;
+            return EResult::Skipped;
+        }
+        if (input.starts_with(CData))
+        {
+            auto Close = input.find("]]>", CData.size());
+            if (!DDepth)
+            {
+                return EResult::Error;
+            }
+            if (Close == std::string_view::npos)
+            {
+                return EResult::More;
+            }
+            std::string_view Raw = input.substr(CData.size(), Close - CData.size());
+            if (Raw.find('\r') == std::string_view::npos)
+            {
+                SetToken(token, SXMLEntity::EType::CharData, Raw);
+            }
+            else
+            {
+                DScratch.clear();
+                Decode(Raw, EText::CData);
+                SetToken(token, SXMLEntity::EType::CharData, DScratch);
+            }
+            DOffset += Close + 3;
+            return EResult::Token;
+        }
+        if (input.starts_with(DocType))
+        {
+            std::size_t Close = DocType.size() + ByteScan::FindAny(input.substr(DocType.size()), "[>");
+            if (DSeenRoot || ((Close < input.size()) && (input[Close] == '[')))
+            {
+                return EResult::Error;
+            }
+            if (Close == input.size())
+            {
+                return EResult::More;
+            }
+            DOffset += Close + 1;
+            return EResult::Skipped;
+        }
+        for (auto Prefix : {Comment, CData, DocType})
+        {
+            if (Prefix.starts_with(input))
+            {
+                return EResult::More;
+            }
+        }
+        return EResult::Error;
+    }
+
+    EResult ParseEndTag(SXMLToken &token, std::string_view input)
+    {
+        auto Close = input.find('>', 2);
+        if (Close == std::string_view::npos)
+        {
+            return EResult::More;
+        }
+        std::string_view Name = input.substr(2, Close - 2);
+        while (!Name.empty() && IsSpace(Name.back()))
+        {
+            Name.remove_suffix(1);
+        }
+        if (!DDepth || (Name != DOpenElements[DDepth - 1]))
+        {
+            return EResult::Error;
+        }
+        DDepth--;
+        SetToken(token, SXMLEntity::EType::EndElement, Name);
+        DOffset += Close + 1;
+        return EResult::Token;
+    }
+
+    EResult ParseStartTag(SXMLToken &token, std::string_view input)
+    {
+        if (DSeenRoot && !DDepth)
+        {
+            return EResult::Error;
+        }
+        std::size_t Size = input.size();
+        std::size_t NameLength = ByteScan::FindAny(input.substr(1), " \t\r\n/>");
+        if (1 + NameLength == Size)
+        {
+            return EResult::More;
+        }
+        if (!NameLength)
+        {
+            return EResult::Error;
+        }
+        std::size_t Position = 1 + NameLength;
+        bool SelfClosing = false;
+        DScratch.clear();
+        DAttributes.clear();
+        while (true)
+        {
+            bool Separated = false;
+            while ((Position < Size) && IsSpace(input[Position]))
+            {
+                Position++;
+                Separated = true;
+            }
+            if (Position == Size)
+            {
+                return EResult::More;
+            }
+            if (input[Position] == '>')
+            {
+                Position++;
+                break;
+            }
+            if (input[Position] == '/')
+            {
+                if (Position + 1 == Size)
+                {
+                    return EResult::More;
+                }
+                if (input[Position + 1] != '>')
+                {
+                    return EResult::Error;
+                }
+                Position += 2;
+                SelfClosing = true;
+                break;
+            }
+            std::size_t KeyLength = ByteScan::FindAny(input.substr(Position), " \t\r\n=/>");
+            if (Position + KeyLength == Size)
+            {
+                return EResult::More;
+            }
+            if (!Separated || !KeyLength)
+            {
+                return EResult::Error;
+            }
+            SPiece Key{false, DOffset + Position, KeyLength};
+            Position += KeyLength;
+            while ((Position < Size) && IsSpace(input[Position]))
+            {
+                Position++;
+            }
+            if ((Position < Size) && (input[Position] != '='))
+            {
+                return EResult::Error;
+            }
+            Position++;
+            while ((Position < Size) && IsSpace(input[Position]))
+            {
+                Position++;
+            }
+            if (Position >= Size)
+            {
+                return EResult::More;
+            }
+            char Quote = input[Position];
+            if ((Quote != '\"') && (Quote != '\''))
+            {
+                return EResult::Error;
+            }
+            Position++;
+            auto Close = input.find(Quote, Position);
+            if (Close == std::string_view::npos)
+            {
+                return EResult::More;
+            }
+            std::string_view Raw = input.substr(Position, Close - Position);
+            SPiece Value{false, DOffset + Position, Raw.size()};
+            if (ByteScan::FindAny(Raw, "<&\t\n\r") < Raw.size())
+            {
+                Value.DInScratch = true;
+                Value.DOffset = DScratch.size();
+                if ((Raw.find('<') != std::string_view::npos) || !Decode(Raw, EText::Attribute))
+                {
+                    return EResult::Error;
+                }
+                Value.DLength = DScratch.size() - Value.DOffset;
+            }
+            for (auto &Attribute : DAttributes)
+            {
+                if (View(Attribute.first) == View(Key))
+                {
+                    return EResult::Error;
+                }
+            }
+            DAttributes.emplace_back(Key, Value);
+            Position = Close + 1;
+        }
+        std::string_view Name = input.substr(1, NameLength);
+        if (DOpenElements.size() == DDepth)
+        {
+            DOpenElements.emplace_back();
+        }
+        DOpenElements[DDepth++].assign(Name);
+        DSeenRoot = true;
+        DPendingEnd = SelfClosing;
+        SetToken(token, SXMLEntity::EType::StartElement, Name);
+        for (auto &Attribute : DAttributes)
+        {
+            token.DAttributes.emplace_back(View(Attribute.first), View(Attribute.second));
+        }
+        DOffset += Position;
+        return EResult::Token;
+    }
+
+    EResult ParseNext(SXMLToken &token)
+    {
+        Resume();
+        std::string_view Input = DInput.substr(DOffset);
+        if (Input.empty())
+        {
+            return EResult::More;
+        }
+        if (Input[0] != '<')
+        {
+            return ParseText(token, Input);
+        }
+        if (Input.size() < 2)
+        {
+            return EResult::More;
+        }
+        switch (Input[1])
+        {
+        case '?':
+        {
+            // the XML declaration and processing instructions are skipped
+            auto Close = Input.find("?>", 2);
+            if (Close == std::string_view::npos)
+            {
+                return EResult::More;
+            }
+            DOffset += Close + 2;
+            return EResult::Skipped;
+        }
+        case '!':
+            return ParseDeclaration(token, Input);
+        case '/':
+            return ParseEndTag(token, Input);
+        default:
+            return ParseStartTag(token, Input);
+        }
+    }
+
+    bool ReadToken(SXMLToken &token)
+    {
+        if (DFailed || DFinished)
+        {
+            return false;
+        }
+        if (DPendingEnd)
+        {
+            // second half of an empty element tag
+            DPendingEnd = false;
+            DDepth--;
+            SetToken(token, SXMLEntity::EType::EndElement, DOpenElements[DDepth]);
+            return true;
+        }
+        while (true)
+        {
+            switch (ParseNext(token))
+            {
+            case EResult::Token:
+                return true;
+            case EResult::Skipped:
+                continue;
+            case EResult::Error:
+                DFailed = true;
+                return false;
+            case EResult::More:
+                break;
+            }
+            if (!Fill())
+            {
+                // the document is complete if only whitespace is left after the root
+                bool Trailing = DOffset < DInput.size();
+                for (std::size_t Index = DOffset; Index < DInput.size(); Index++)
+                {
+                    Trailing &= IsSpace(DInput[Index]);
+                }
+                if (DSeenRoot && !DDepth && ((DOffset == DInput.size()) || Trailing))
+                {
+                    DFinished = true;
+                }
+                else
+                {
+                    DFailed = true;
+                }
+                return false;
+            }
+        }
+    }
+};
+
+CXMLTokenizer::CXMLTokenizer(std::shared_ptr<CDataSource> src)
+{
+    DImplementation = std::make_unique<SImplementation>(src);
+}
+
+CXMLTokenizer::~CXMLTokenizer() = default;
+
+bool CXMLTokenizer::End() const
+{
+    return DImplementation->DFinished || DImplementation->DFailed;
+}
+
+bool CXMLTokenizer::Failed() const
+{
+    return DImplementation->DFailed;
+}
+
+bool CXMLTokenizer::ReadToken(SXMLToken &token)
+{
+    return DImplementation->ReadToken(token);
+}
@@ -1,196 +1,225 @@
 #include "XMLWriter.h"
 
+#include "ByteScan.h"
+
+#include <algorithm>
 #include <vector>
 
 namespace
 {
-    std::string EscapeText(const std::string &value)
+    constexpr std::string_view kTextSpecials = "&<>";
+    constexpr std::string_view kAttributeSpecials = "&<>\"\'";
+    // Below this length a table lookup per character beats setting up a
+    // vector scan, which pays off on long character data
+    constexpr std::size_t kShortValue = 32;
+
+    // Replacement for each character, null for ones written as is
+    struct SEscapeTable
     {
-        std::string Out;
-        Out.reserve(value.size());
-        for (char ch : value)
+        const char *DEscapes[256] = {};
+
+        constexpr SEscapeTable(bool attribute)
         {
-            // TODO: i should probalby change this to switch statements over time
-            if (ch == '&')
-            {
-                Out += "&amp;";
-            }
-            else if (ch == '<')
-            {
-                Out += "&lt;";
-            }
-            else if (ch == '>')
+            DEscapes[static_cast<unsigned char>('&')] = "&amp;";
+            DEscapes[static_cast<unsigned char>('<')] = "&lt;";
+            DEscapes[static_cast<unsigned char>('>')] = "&gt;";
+            if (attribute)
             {
-                Out += "&gt;";
-            }
-            else
-            {
-                Out += ch;
+                DEscapes[static_cast<unsigned char>('\"')] = "&quot;";
+                DEscapes[static_cast<unsigned char>('\'')] = "&apos;";
             }
         }
-        return Out;
-    }
+    };
+
+    constexpr SEscapeTable kTextEscapes(false);
+    constexpr SEscapeTable kAttributeEscapes(true);
 
-    std::string EscapeAttribute(const std::string &value)
+    // Appends value to out with the characters in specials escaped. Clean
+    // runs of long values are found in bulk by ByteScan and copied whole.
+    void AppendEscaped(std::string &out, std::string_view value, std::string_view specials, const SEscapeTable &table)
     {
-        std::string Out;
-        Out.reserve(value.size());
-        for (char ch : value)
+        std::size_t Start = 0;
+        while (Start < value.size())
         {
-            // this maybe shoudl be switch statements over time
-            if (ch == '&')
+            std::size_t Special = Start;
+            if (value.size() - Start < kShortValue)
             {
-                Out += "&amp;";
+                while ((Special < value.size()) && !table.DEscapes[static_cast<unsigned char>(value[Special])])
+                {
+                    Special++;
+                }
             }
-            else if (ch == '<')
-            {
-                Out += "&lt;";
-            }
-            else if (ch == '>')
-            {
-                Out += "&gt;";
-            }
-            else if (ch == '\"')
-            {
-                Out += "&quot;";
-            }
-            else if (ch == '\'')
+            else
             {
-                Out += "&apos;";
+                Special += ByteScan::FindAny(value.substr(Start), specials);
             }
-            else
+            out.append(value.data() + Start, Special - Start);
+            if (Special == value.size())
             {
-                Out += ch;
+                return;
             }
+            out.append(table.DEscapes[static_cast<unsigned char>(value[Special])]);
+            Start = Special + 1;
         }
-        return Out;
+    }
+
+    void AppendEscapedText(std::string &out, std::string_view value)
+    {
+        AppendEscaped(out, value, kTextSpecials, kTextEscapes);
+    }
+
+    void AppendEscapedAttribute(std::string &out, std::string_view value)
+    {
+        AppendEscaped(out, value, kAttributeSpecials, kAttributeEscapes);
     }
 }
 
+// Each entity is formatted into DBuffer, which is handed to the sink in one
+// write per entity or, with a batch size, once enough entities are pending.
 struct CXMLWriter::SImplementation
 {
     std::shared_ptr<CDataSink> DSink;
     std::vector<std::string> DElementStack;
+    // whether each open element holds child elements or multi-line text, in
+    // which case its end tag goes on its own line when indenting
+    std::vector<bool> DElementIsBlock;
+    std::size_t DBatchSize;
+    std::string DBuffer;
+    EFormat DFormat;
+    std::size_t DIndentWidth;
+    // a newline followed by enough spaces for the deepest element so far
+    std::string DIndent;
+    bool DWritten;
+    // Indented and Minified hold back whitespace-only text until the next
+    // entity shows whether it sits between elements, where it is dropped,
+    // or is all an element holds or part of longer text, where it is kept
+    std::string DPendingSpace;
+    bool DOpenElementEmpty = false;
+    bool DAfterText = false;
 
-    SImplementation(std::shared_ptr<CDataSink> sink) : DSink(sink)
+    SImplementation(std::shared_ptr<CDataSink> sink, std::size_t batchsize, EFormat format, std::size_t indentwidth)
+        : DSink(sink), DBatchSize(batchsize), DFormat(format), DIndentWidth(indentwidth), DIndent(1, '\n'), DWritten(false)
     {
     }
 
-    bool WriteString(const std::string &value)
+    ~SImplementation()
     {
-        std::vector<char> Buffer(value.begin(), value.end());
-        return DSink->Write(Buffer);
+        FlushBuffer();
     }
 
-    bool WriteStartTag(const SXMLEntity &entity)
+    bool FlushBuffer()
     {
-        // should validate DNameData isn't empty before starting
-        if (!WriteString("<"))
-        {
-            return false;
-        }
-        if (!WriteString(entity.DNameData))
-        {
-            return false;
-        }
-        for (const auto &Attribute : entity.DAttributes)
-        {
-            if (!WriteString(" "))
-            {
-                return false;
-            }
-            if (!WriteString(Attribute.first))
-            {
-                return false;
-            }
-            if (!WriteString("=\""))
-            {
-                return false;
-            }
-            if (!WriteString(EscapeAttribute(Attribute.second)))
-            {
-                return false;
-            }
-            if (!WriteString("\""))
-            {
-                return false;
-            }
-        }
-        if (!WriteString(">"))
+        if (DBuffer.empty())
         {
-            return false;
+            return true;
         }
-        return true;
+        bool Result = DSink->WriteSpan(DBuffer);
+        DBuffer.clear();
+        return Result;
     }
 
-    bool WriteEndTag(const std::string &name)
+    // Hands the buffer over once the batch is full
+    bool Commit()
     {
-        // end is either terminated or empty
-        if (!WriteString("</"))
-        {
-            return false;
-        }
-        if (!WriteString(name))
-        {
-            return false;
-        }
-        if (!WriteString(">"))
+        return DBuffer.size() < DBatchSize ? true : FlushBuffer();
+    }
+
+    // Starts a new line indented for depth open elements
+    void AppendIndent(std::size_t depth)
+    {
+        std::size_t Length = 1 + depth * DIndentWidth;
+        if (DIndent.size() < Length)
         {
-            return false;
+            DIndent.resize(std::max(Length, DIndent.size() * 2), ' ');
         }
-        return true;
+        DBuffer.append(DIndent, 0, Length);
     }
 
-    bool WriteCompleteTag(const SXMLEntity &entity)
+    void AppendText(std::string_view text)
     {
-        // use <tag/> or <tag></tag>?
-        if (!WriteString("<"))
+        if (!DElementIsBlock.empty() && (text.find('\n') != std::string_view::npos))
         {
-            return false;
+            DElementIsBlock.back() = true;
         }
-        if (!WriteString(entity.DNameData))
+        DWritten |= !text.empty();
+        DOpenElementEmpty = false;
+        DAfterText = true;
+        AppendEscapedText(DBuffer, text);
+    }
+
+    // Whitespace before the end tag is kept only if the element holds nothing else
+    void BeforeEndTag()
+    {
+        if (DOpenElementEmpty && !DPendingSpace.empty())
         {
-            return false;
+            AppendText(DPendingSpace);
         }
-        for (const auto &Attribute : entity.DAttributes)
+        DPendingSpace.clear();
+        DOpenElementEmpty = false;
+        DAfterText = false;
+    }
+
+    // Lays out a start or complete tag about to be written
+    void BeforeTag()
+    {
+        DPendingSpace.clear();
+        DOpenElementEmpty = false;
+        DAfterText = false;
+        if (DFormat == EFormat::Indented)
         {
-            if (!WriteString(" "))
-            {
-                return false;
-            }
-            if (!WriteString(Attribute.first))
+            if (DWritten)
             {
-                return false;
-            }
-            if (!WriteString("=\""))
-            {
-                return false;
+                AppendIndent(DElementStack.size());
             }
-            if (!WriteString(EscapeAttribute(Attribute.second)))
+            if (!DElementIsBlock.empty())
             {
-                return false;
-            }
-            if (!WriteString("\""))
-            {
-                return false;
+                DElementIsBlock.back() = true;
             }
         }
-        if (!WriteString("/>"))
+        DWritten = true;
+    }
+
+    void AppendTag(const SXMLEntity &entity, std::string_view close)
+    {
+        // should validate DNameData isn't empty before starting
+        DBuffer += '<';
+        DBuffer.append(entity.DNameData);
+        for (const auto &Attribute : entity.DAttributes)
+        {
+            DBuffer += ' ';
+            DBuffer.append(Attribute.first);
+            DBuffer.append("=\"");
+            AppendEscapedAttribute(DBuffer, Attribute.second);
+            DBuffer += '"';
+        }
+        DBuffer.append(close);
+    }
+
+    void AppendEndTag(std::string_view name)
+    {
+        if ((DFormat == EFormat::Indented) && !DElementIsBlock.empty() && DElementIsBlock.back())
         {
-            return false;
+            AppendIndent(DElementStack.size() - 1);
         }
-        return true;
+        // end is either terminated or empty
+        DBuffer.append("</");
+        DBuffer.append(name);
+        DBuffer += '>';
     }
 
     bool WriteEntity(const SXMLEntity &entity)
     {
         if (entity.DType == SXMLEntity::EType::StartElement)
         {
-            if (!WriteStartTag(entity))
+            BeforeTag();
+            AppendTag(entity, ">");
+            if (!Commit())
             {
                 return false;
             }
             DElementStack.push_back(entity.DNameData);
+            DElementIsBlock.push_back(false);
+            DOpenElementEmpty = true;
             return true;
         }
         if (entity.DType == SXMLEntity::EType::EndElement)
@@ -200,24 +229,42 @@ struct CXMLWriter::SImplementation
             {
                 return false;
             }
-            std::string Name = entity.DNameData.empty() ? DElementStack.back() : entity.DNameData;
-            if (!WriteEndTag(Name))
+            const std::string &Name = entity.DNameData.empty() ? DElementStack.back() : entity.DNameData;
+            BeforeEndTag();
+            AppendEndTag(Name);
+            if (!Commit())
             {
                 return false;
             }
-            if (!DElementStack.empty() && DElementStack.back() == Name)
+            if (DElementStack.back() == Name)
             {
                 DElementStack.pop_back();
+                DElementIsBlock.pop_back();
             }
             return true;
         }
         if (entity.DType == SXMLEntity::EType::CompleteElement)
         {
-            return WriteCompleteTag(entity);
+            // use <tag/> or <tag></tag>?
+            BeforeTag();
+            AppendTag(entity, "/>");
+            return Commit();
         }
         if (entity.DType == SXMLEntity::EType::CharData)
         {
-            return WriteString(EscapeText(entity.DNameData));
+            if ((DFormat != EFormat::Raw) && !DAfterText && (entity.DNameData.find_first_not_of(" \t\r\n") == std::string::npos))
+            {
+                DPendingSpace.append(entity.DNameData);
+                return true;
+            }
+            if (!DPendingSpace.empty())
+            {
+                std::string Pending = std::move(DPendingSpace);
+                DPendingSpace.clear();
+                AppendText(Pending);
+            }
+            AppendText(entity.DNameData);
+            return Commit();
         }
         return false;
     }
@@ -226,21 +273,18 @@ struct CXMLWriter::SImplementation
     {
         while (!DElementStack.empty())
         {
-            std::string Name = DElementStack.back();
+            BeforeEndTag();
+            AppendEndTag(DElementStack.back());
             DElementStack.pop_back();
-
-            if (!WriteEndTag(Name))
-            {
-                return false;
-            }
+            DElementIsBlock.pop_back();
         }
-        return true;
+        return FlushBuffer() && DSink->Flush();
     }
 };
 
-CXMLWriter::CXMLWriter(std::shared_ptr<CDataSink> sink)
+CXMLWriter::CXMLWriter(std::shared_ptr<CDataSink> sink, std::size_t batchsize, EFormat format, std::size_t indentwidth)
 {
-    DImplementation = std::make_unique<SImplementation>(sink);
+    DImplementation = std::make_unique<SImplementation>(sink, batchsize, format, indentwidth);
 }
 
 CXMLWriter::~CXMLWriter() = default;
@@ -254,3 +298,8 @@ bool CXMLWriter::WriteEntity(const SXMLEntity &entity)
 {
     return DImplementation->WriteEntity(entity);
 }
+
+std::size_t CXMLWriter::Depth() const
+{
+    return DImplementation->DElementStack.size();
+}
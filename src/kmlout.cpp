@@ -1,8 +1,11 @@
 #include "OpenStreetMap.h"
+#include "StreetMapSnapshot.h"
 #include "BusSystem.h"
 #include "DSVReader.h"
+#include "DSVColumnReader.h"
+#include "DSVTable.h"
 #include "DSVWriter.h"
-#include "FileDataFactory.h"
+#include "CachingDataFactory.h"
 #include "FileDataSource.h"
 #include "FileDataSink.h"
 #include "StandardDataSource.h"
@@ -56,6 +59,8 @@ class CKMLTranslator{
 int main(int argc, char *argv[]){
     std::vector<std::string> Arguments;
     const std::string OSMFilename = "city.osm";
+    // written by osmsnapshot, used instead of city.osm while it matches
+    const std::string SnapshotFilename = "city.smap";
     const std::string StopFilename = "stops.csv";
     const std::string BusPathFilename = "buspaths.csv";
 
@@ -68,15 +73,20 @@ int main(int argc, char *argv[]){
     if(!Parser.ArgumentsValid()){
         return EXIT_FAILURE;
     }
-    auto DataFactory = std::make_shared<CFileDataFactory>(Parser.DataDirectory());
+    auto DataFactory = std::make_shared<CCachingDataFactory>(Parser.DataDirectory());
     auto ResultsFactory = std::make_shared<CFileDataFactory>(Parser.ResultsDirectory());
     auto StdIn = std::make_shared<CStandardDataSource>();
     auto StdOut = std::make_shared<CStandardDataSink>();
     auto StdErr = std::make_shared<CStandardErrorDataSink>();
     auto StopReader = std::make_shared<CDSVReader>(DataFactory->CreateSource(StopFilename),',');
     auto BusPathReader = std::make_shared<CDSVReader>(DataFactory->CreateSource(BusPathFilename),',');
-    auto XMLReader = std::make_shared<CXMLReader>(DataFactory->CreateSource(OSMFilename));
-    auto StreetMap = std::make_shared<COpenStreetMap>(XMLReader);
+    auto Snapshot = std::make_shared<CStreetMapSnapshot>(std::make_shared<CMappedFile>(Parser.DataDirectory() + "/" + SnapshotFilename));
+    std::shared_ptr<CStreetMap> StreetMap = Snapshot;
+    bool UseSnapshot = Snapshot->Valid() && Snapshot->MatchesSource(Parser.DataDirectory() + "/" + OSMFilename);
+    if(!UseSnapshot){
+        auto XMLReader = std::make_shared<CXMLReader>(DataFactory->CreateSource(OSMFilename),CXMLReader::EParser::Native);
+        StreetMap = std::make_shared<COpenStreetMap>(XMLReader);
+    }
     CKMLTranslator KMLTranslator(StreetMap,StopReader,BusPathReader);
 
     for(auto &Filename : Parser.Filenames()){
@@ -148,60 +158,45 @@ CKMLTranslator::CKMLTranslator(std::shared_ptr<CStreetMap> map, std::shared_ptr<
         auto Node = map->NodeByIndex(Index);
         DNodeIDToLocation[Node->ID()] = Node->Location();
     }
-    std::vector<std::string> TempRow;
-    if(stops->ReadRow(TempRow)){
-        auto StopIDIndex = TempRow.size();
-        auto NodeIDIndex = StopIDIndex;
-        for(size_t Index = 0; Index < TempRow.size(); Index++){
-            if(TempRow[Index] == StopIDHeading){
-                StopIDIndex = Index;
-            }
-            else if(TempRow[Index] == NodeIDHeading){
-                NodeIDIndex = Index;
-            }
-        }
-        if((StopIDIndex >= TempRow.size())||(NodeIDIndex >= TempRow.size())){
+    CDSVTable StopTable(stops);
+    if(StopTable.HeaderValid()){
+        auto StopIDIndex = StopTable.Column(StopIDHeading);
+        auto NodeIDIndex = StopTable.Column(NodeIDHeading);
+        if((StopIDIndex == CDSVTable::InvalidColumn)||(NodeIDIndex == CDSVTable::InvalidColumn)){
             throw std::runtime_error("Missing stops header!");
         }
-        while(stops->ReadRow(TempRow)){
-            auto StopID = std::stoull(TempRow[StopIDIndex]);
-            auto NodeID = std::stoull(TempRow[NodeIDIndex]);
+        for(std::size_t Row = 0; Row < StopTable.RowCount(); Row++){
+            uint64_t StopID, NodeID;
+            if(!StopTable.GetUInt64(StopIDIndex, Row, StopID) || !StopTable.GetUInt64(NodeIDIndex, Row, NodeID)){
+                throw std::runtime_error("Invalid stop on row " + std::to_string(Row + 1) + "!");
+            }
             DNodeIDToStopID[NodeID] = StopID;
         }
     }
-    if(buspaths->ReadRow(TempRow)){
-        auto SourceIDIndex = TempRow.size();
-        auto DestinationIDIndex = SourceIDIndex;
-        auto RoutesIndex = SourceIDIndex;
-        auto PathIndex = SourceIDIndex;
-        for(size_t Index = 0; Index < TempRow.size(); Index++){
-            if(TempRow[Index] == SourceIDHeading){
-                SourceIDIndex = Index;
-            }
-            else if(TempRow[Index] == DestinationIDHeading){
-                DestinationIDIndex = Index;
-            }
-            else if(TempRow[Index] == RoutesHeading){
-                RoutesIndex = Index;
-            }
-            else if(TempRow[Index] == PathHeading){
-                PathIndex = Index;
-            }
-        }
-        if((SourceIDIndex >= TempRow.size())||(DestinationIDIndex >= TempRow.size())||(RoutesIndex >= TempRow.size())||(PathIndex >= TempRow.size())){
+    // a path of a single node would otherwise be read as a number
+    CDSVTable BusPathTable(buspaths, {PathHeading});
+    if(BusPathTable.HeaderValid()){
+        auto SourceIDIndex = BusPathTable.Column(SourceIDHeading);
+        auto DestinationIDIndex = BusPathTable.Column(DestinationIDHeading);
+        auto RoutesIndex = BusPathTable.Column(RoutesHeading);
+        auto PathIndex = BusPathTable.Column(PathHeading);
+        if((SourceIDIndex == CDSVTable::InvalidColumn)||(DestinationIDIndex == CDSVTable::InvalidColumn)||(RoutesIndex == CDSVTable::InvalidColumn)||(PathIndex == CDSVTable::InvalidColumn)){
             throw std::runtime_error("Missing buspath header!");
         }
-        while(buspaths->ReadRow(TempRow)){
-            auto SourceID = std::stoull(TempRow[SourceIDIndex]);
-            auto DestinationID = std::stoull(TempRow[DestinationIDIndex]);
-            auto Routes = StringUtils::Split(TempRow[RoutesIndex],"_");
-            auto PathStrings = StringUtils::Split(TempRow[PathIndex],",");
+        for(std::size_t Row = 0; Row < BusPathTable.RowCount(); Row++){
+            uint64_t SourceID, DestinationID, NodeID;
+            if(!BusPathTable.GetUInt64(SourceIDIndex, Row, SourceID) || !BusPathTable.GetUInt64(DestinationIDIndex, Row, DestinationID)){
+                throw std::runtime_error("Invalid buspath on row " + std::to_string(Row + 1) + "!");
+            }
             std::vector<CStreetMap::SLocation> LocationList;
-            for(auto &NodeIDString : PathStrings){
-                auto NodeID = std::stoull(NodeIDString);
+            CIntegerListDecoder PathDecoder(BusPathTable.String(PathIndex, Row));
+            while(PathDecoder.Next(NodeID)){
                 auto Node = map->NodeByID(NodeID);
                 LocationList.push_back(Node->Location());
             }
+            if(PathDecoder.Failed()){
+                throw std::runtime_error("Invalid buspath on row " + std::to_string(Row + 1) + "!");
+            }
             DBusSegmentToLocations[std::make_pair(SourceID,DestinationID)] = LocationList;
         }
     }
@@ -287,28 +282,22 @@ std::vector<std::pair<std::string,CStreetMap::TNodeID> > CKMLTranslator::ParsePa
     const std::string ModeHeading = "mode";
     const std::string NodeIDHeading = "node_id";
     
-    std::vector<std::string> TempRow;
-    if(path->ReadRow(TempRow)){
-        auto ModeIndex = TempRow.size();
-        auto NodeIDIndex = ModeIndex;
-        for(size_t Index = 0; Index < TempRow.size(); Index++){
-            if(TempRow[Index] == ModeHeading){
-                ModeIndex = Index;
-            }
-            else if(TempRow[Index] == NodeIDHeading){
-                NodeIDIndex = Index;
-            }
-        }
-        if((ModeIndex >= TempRow.size())||(NodeIDIndex >= TempRow.size())){
+    CDSVTable PathTable(path, {ModeHeading});
+    if(PathTable.HeaderValid()){
+        auto ModeIndex = PathTable.Column(ModeHeading);
+        auto NodeIDIndex = PathTable.Column(NodeIDHeading);
+        if((ModeIndex == CDSVTable::InvalidColumn)||(NodeIDIndex == CDSVTable::InvalidColumn)){
             return {};
         }
         std::vector<std::pair<std::string,CStreetMap::TNodeID> > ReturnVector;
-        while(path->ReadRow(TempRow)){
-            auto Mode = TempRow[ModeIndex];
-            auto NodeID = std::stoull(TempRow[NodeIDIndex]);
-            ReturnVector.push_back(std::make_pair(Mode,NodeID));
+        for(std::size_t Row = 0; Row < PathTable.RowCount(); Row++){
+            uint64_t NodeID;
+            if(!PathTable.GetUInt64(NodeIDIndex, Row, NodeID)){
+                throw std::runtime_error("Invalid path step on row " + std::to_string(Row + 1) + "!");
+            }
+            ReturnVector.push_back(std::make_pair(std::string(PathTable.String(ModeIndex, Row)),NodeID));
         }
         return ReturnVector;
     }
     return {};
-}
\ No newline at end of file
+}
@@ -0,0 +1,112 @@
+#include "OpenStreetMap.h"
+#include "FlatIDIndex.h"
+#include "StreetMapSnapshot.h"
+#include "FileDataSink.h"
+#include "FileDataSource.h"
+#include "StringUtils.h"
+#include <chrono>
+#include <cstdio>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Time to get a street map in memory by parsing the OSM XML and by opening a
+// snapshot of it, then random node ID lookups, the access pattern of path
+// reconstruction and KML output, through the ID index on its own, through an
+// unordered_map like the one COpenStreetMap used to keep, and through
+// NodeByID of both maps.
+
+template <typename TLoad>
+static void RunLoadBenchmark(const std::string &label, std::size_t iterations, TLoad load){
+    std::size_t Nodes = 0;
+    auto Start = std::chrono::steady_clock::now();
+    for(std::size_t Index = 0; Index < iterations; Index++){
+        Nodes = load()->NodeCount();
+    }
+    auto Duration = std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+    double Milliseconds = Duration * 1e3 / double(iterations);
+    std::cout<<StringUtils::LJust(label,32)<<StringUtils::RJust(std::to_string(Milliseconds).substr(0,5),8)<<" ms/load "<<StringUtils::RJust(std::to_string(Nodes),10)<<" nodes"<<std::endl;
+}
+
+template <typename TLookup>
+static void RunBenchmark(const std::string &label, const std::vector<CStreetMap::TNodeID> &queries, std::size_t iterations, TLookup lookup){
+    std::size_t Found = 0;
+    auto Start = std::chrono::steady_clock::now();
+    for(std::size_t Index = 0; Index < iterations; Index++){
+        for(auto ID : queries){
+            Found += lookup(ID);
+        }
+    }
+    auto Duration = std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+    double Nanoseconds = Duration * 1e9 / double(queries.size() * iterations);
+    std::cout<<StringUtils::LJust(label,32)<<StringUtils::RJust(std::to_string(Nanoseconds).substr(0,5),8)<<" ns/lookup"<<StringUtils::RJust(std::to_string(Found / iterations),10)<<" found"<<std::endl;
+}
+
+int main(int argc, char *argv[]){
+    std::size_t Iterations = 50;
+    std::vector<std::string> Filenames = {"./data/city.osm", "./data/davis.osm"};
+    if(argc > 1){
+        Iterations = std::stoull(argv[1]);
+    }
+    if(argc > 2){
+        Filenames.assign(argv + 2, argv + argc);
+    }
+    for(auto &Filename : Filenames){
+        auto File = std::make_shared<CMappedFile>(Filename);
+        COpenStreetMap Map(std::make_shared<CXMLReader>(std::make_shared<CFileDataSource>(File), CXMLReader::EParser::Native));
+
+        std::vector<CStreetMap::TNodeID> IDs;
+        std::unordered_map<CStreetMap::TNodeID, std::shared_ptr<CStreetMap::SNode>> HashMap;
+        for(std::size_t Index = 0; Index < Map.NodeCount(); Index++){
+            auto Node = Map.NodeByIndex(Index);
+            IDs.push_back(Node->ID());
+            HashMap[Node->ID()] = Node;
+        }
+        CFlatIDIndex Index(IDs);
+
+        auto SnapshotFilename = Filename + ".smap";
+        if(!CStreetMapSnapshot::Write(Map,std::make_shared<CFileDataSink>(SnapshotFilename),Filename)){
+            std::cerr<<"Unable to write "<<SnapshotFilename<<std::endl;
+            std::remove(SnapshotFilename.c_str());
+            return EXIT_FAILURE;
+        }
+        CStreetMapSnapshot Snapshot(std::make_shared<CMappedFile>(SnapshotFilename));
+
+        // mostly IDs that exist with some misses mixed in
+        std::mt19937_64 Generator(1);
+        std::vector<CStreetMap::TNodeID> Queries;
+        for(std::size_t Count = 0; Count < 100000 && !IDs.empty(); Count++){
+            auto ID = IDs[Generator() % IDs.size()];
+            Queries.push_back(Count % 8 ? ID : ID + 1);
+        }
+
+        std::cout<<Filename<<" ("<<IDs.size()<<" nodes, "<<Queries.size()<<" lookups x "<<Iterations<<")"<<std::endl;
+        RunLoadBenchmark("parse COpenStreetMap",Iterations,[&](){
+            return std::make_shared<COpenStreetMap>(std::make_shared<CXMLReader>(std::make_shared<CFileDataSource>(File), CXMLReader::EParser::Native));
+        });
+        RunLoadBenchmark("open CStreetMapSnapshot",Iterations,[&](){
+            return std::make_shared<CStreetMapSnapshot>(std::make_shared<CMappedFile>(SnapshotFilename));
+        });
+        // copies the pointer out as the old NodeByID did, so it compares
+        // with the NodeByID rows end to end
+        RunBenchmark("unordered_map NodeByID",Queries,Iterations,[&](CStreetMap::TNodeID id){
+            auto Search = HashMap.find(id);
+            auto Node = Search != HashMap.end() ? Search->second : nullptr;
+            return Node != nullptr;
+        });
+        RunBenchmark("CFlatIDIndex::Find",Queries,Iterations,[&](CStreetMap::TNodeID id){
+            return Index.Find(id) != CFlatIDIndex::InvalidPosition;
+        });
+        RunBenchmark("COpenStreetMap::NodeByID",Queries,Iterations,[&](CStreetMap::TNodeID id){
+            return Map.NodeByID(id) != nullptr;
+        });
+        RunBenchmark("CStreetMapSnapshot::NodeByID",Queries,Iterations,[&](CStreetMap::TNodeID id){
+            return Snapshot.NodeByID(id) != nullptr;
+        });
+        std::remove(SnapshotFilename.c_str());
+    }
+    return EXIT_SUCCESS;
+}
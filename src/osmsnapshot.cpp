@@ -0,0 +1,30 @@
+#include "OpenStreetMap.h"
+#include "StreetMapSnapshot.h"
+#include "FileDataSource.h"
+#include "FileDataSink.h"
+#include <iostream>
+#include <memory>
+#include <string>
+
+// Converts OSM XML into a street map snapshot that speedtest and kmlout load
+// instead of the XML. The snapshot records the size and modification time of
+// the XML, and the tools go back to parsing the XML once it no longer
+// matches, so rerun this after replacing the OSM file.
+int main(int argc, char *argv[]){
+    if(argc != 3){
+        std::cerr<<"Syntax Error: osmsnapshot input.osm output.smap"<<std::endl;
+        return EXIT_FAILURE;
+    }
+    auto File = std::make_shared<CMappedFile>(argv[1]);
+    if(File->Contents().empty()){
+        std::cerr<<"Unable to read "<<argv[1]<<std::endl;
+        return EXIT_FAILURE;
+    }
+    COpenStreetMap Map(std::make_shared<CXMLReader>(std::make_shared<CFileDataSource>(File),CXMLReader::EParser::Native));
+    if(!CStreetMapSnapshot::Write(Map,std::make_shared<CFileDataSink>(argv[2]),argv[1])){
+        std::cerr<<"Unable to write "<<argv[2]<<std::endl;
+        return EXIT_FAILURE;
+    }
+    std::cout<<argv[2]<<": "<<Map.NodeCount()<<" nodes, "<<Map.WayCount()<<" ways"<<std::endl;
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,103 @@
+#include "FileDataSink.h"
+#include "StringUtils.h"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// The stream-backed sink CFileDataSink used to be, kept here as the baseline
+class CStreamFileDataSink : public CDataSink{
+    private:
+        std::ofstream DFile;
+    public:
+        CStreamFileDataSink(const std::string &filename){
+            DFile.open(filename);
+        }
+
+        bool Put(const char &ch) noexcept override{
+            DFile.put(ch);
+            return DFile.good();
+        }
+
+        bool Write(const std::vector<char> &buf) noexcept override{
+            DFile.write(buf.data(),buf.size());
+            return DFile.good();
+        }
+};
+
+using TSinkCreator = std::function< std::shared_ptr< CDataSink >(const std::string &) >;
+
+// Writes roughly bytes worth of CSV-like rows: short fields separated by Put
+// delimiters, the same pattern CDSVWriter produces.
+static std::size_t WriteRows(std::shared_ptr< CDataSink > sink, std::size_t bytes){
+    const std::vector<std::string> Fields = {"12345678", "Walk", "38.5450123", "-121.7401234"};
+    std::size_t Written = 0;
+    while(Written < bytes){
+        for(std::size_t Index = 0; Index < Fields.size(); Index++){
+            if(Index){
+                sink->Put(',');
+                Written++;
+            }
+            sink->WriteString(Fields[Index]);
+            Written += Fields[Index].size();
+        }
+        sink->Put('\n');
+        Written++;
+    }
+    sink->Flush();
+    return Written;
+}
+
+// Writes bytes one Put at a time
+static std::size_t PutBytes(std::shared_ptr< CDataSink > sink, std::size_t bytes){
+    for(std::size_t Index = 0; Index < bytes; Index++){
+        sink->Put('a' + Index % 26);
+    }
+    sink->Flush();
+    return bytes;
+}
+
+static void RunBenchmark(const std::string &label, const std::string &filename, TSinkCreator creator, std::size_t (*workload)(std::shared_ptr< CDataSink >, std::size_t), std::size_t bytes){
+    auto Start = std::chrono::steady_clock::now();
+    std::size_t Written;
+    {
+        auto Sink = creator(filename);
+        Written = workload(Sink,bytes);
+    }
+    auto Duration = std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+    std::cout<<StringUtils::LJust(label,32)<<StringUtils::RJust(std::to_string(long(Written / Duration / 1048576.0)),8)<<" MB/s"<<std::endl;
+    std::remove(filename.c_str());
+}
+
+int main(int argc, char *argv[]){
+    std::size_t Megabytes = 32;
+    std::string Filename = "sinkbench.tmp";
+    if(argc > 1){
+        Megabytes = std::stoull(argv[1]);
+    }
+    if(argc > 2){
+        Filename = argv[2];
+    }
+    std::size_t Bytes = Megabytes * 1048576;
+    std::vector< std::pair< std::string, TSinkCreator > > Sinks = {
+        {"ofstream (previous sink)", [](const std::string &name){ return std::make_shared<CStreamFileDataSink>(name); }},
+        {"CFileDataSink unbuffered", [](const std::string &name){ return std::make_shared<CFileDataSink>(name,0); }},
+        {"CFileDataSink 4 KiB", [](const std::string &name){ return std::make_shared<CFileDataSink>(name,4096); }},
+        {"CFileDataSink 64 KiB", [](const std::string &name){ return std::make_shared<CFileDataSink>(name); }},
+        {"CFileDataSink 1 MiB", [](const std::string &name){ return std::make_shared<CFileDataSink>(name,1048576); }}
+    };
+    std::cout<<"Put per byte ("<<Megabytes<<" MB)"<<std::endl;
+    for(auto &Sink : Sinks){
+        // unbuffered per-byte puts are one syscall each, keep that run short
+        RunBenchmark(Sink.first,Filename,Sink.second,PutBytes,Sink.first == "CFileDataSink unbuffered" ? Bytes / 64 : Bytes);
+    }
+    std::cout<<"CSV rows ("<<Megabytes<<" MB)"<<std::endl;
+    for(auto &Sink : Sinks){
+        RunBenchmark(Sink.first,Filename,Sink.second,WriteRows,Sink.first == "CFileDataSink unbuffered" ? Bytes / 64 : Bytes);
+    }
+    return EXIT_SUCCESS;
+}
@@ -1,11 +1,13 @@
 #include "TransportationPlannerConfig.h"
 #include "DijkstraTransportationPlanner.h"
 #include "OpenStreetMap.h"
+#include "StreetMapSnapshot.h"
 #include "CSVBusSystem.h"
-#include "FileDataFactory.h"
+#include "CachingDataFactory.h"
 #include "StandardDataSource.h"
 #include "StandardDataSink.h"
 #include "StandardErrorDataSink.h"
+#include "InstrumentedDataSource.h"
 #include "StringUtils.h"
 #include <iostream>
 #include <iomanip>
@@ -48,6 +50,8 @@ class CSpeedTest{
         std::vector< double > DFastestTime;
         uint64_t DLoadDurationCount;
         uint64_t DProcessingDurationCount;
+        uint64_t DInputDurationCount;
+        std::vector< std::pair< std::string, SDataStatistics > > DInputStatistics;
 
         static std::string DistanceToString(double dist);
         static std::string TimeToString(double dur);
@@ -60,6 +64,7 @@ class CSpeedTest{
     public:
         CSpeedTest(std::shared_ptr<CDataSink> out, std::shared_ptr<CDataSink> notify, std::shared_ptr<CTransportationPlanner::SConfiguration> config);
 
+        void ReportInput(uint64_t duration, const std::vector< std::pair< std::string, SDataStatistics > > &statistics);
         bool RunTest(uint64_t seed, uint64_t numpoints, bool verbose);
         bool OutputResults(std::shared_ptr<CDataFactory> results, bool verbose);
 };
@@ -67,6 +72,8 @@ class CSpeedTest{
 int main(int argc, char *argv[]){
     std::vector<std::string> Arguments;
     const std::string OSMFilename = "city.osm";
+    // written by osmsnapshot, used instead of city.osm while it matches
+    const std::string SnapshotFilename = "city.smap";
     const std::string StopFilename = "stops.csv";
     const std::string RouteFilename = "routes.csv";
 
@@ -79,19 +86,32 @@ int main(int argc, char *argv[]){
     if(!Parser.ArgumentsValid()){
         return EXIT_FAILURE;
     }
-    auto DataFactory = std::make_shared<CFileDataFactory>(Parser.DataDirectory());
+    auto DataFactory = std::make_shared<CCachingDataFactory>(Parser.DataDirectory());
     auto ResultsFactory = std::make_shared<CFileDataFactory>(Parser.ResultsDirectory());
     auto StdIn = std::make_shared<CStandardDataSource>();
     auto StdOut = std::make_shared<CStandardDataSink>();
     auto StdErr = std::make_shared<CStandardErrorDataSink>();
-    auto StopReader = std::make_shared<CDSVReader>(DataFactory->CreateSource(StopFilename),',');
-    auto RouteReader = std::make_shared<CDSVReader>(DataFactory->CreateSource(RouteFilename),',');
-    auto BusSystem = std::make_shared<CCSVBusSystem>(StopReader, RouteReader);
-    auto XMLReader = std::make_shared<CXMLReader>(DataFactory->CreateSource(OSMFilename));
-    auto StreetMap = std::make_shared<COpenStreetMap>(XMLReader);
+    auto StopSource = std::make_shared<CInstrumentedDataSource>(DataFactory->CreateSource(StopFilename));
+    auto RouteSource = std::make_shared<CInstrumentedDataSource>(DataFactory->CreateSource(RouteFilename));
+    auto OSMSource = std::make_shared<CInstrumentedDataSource>(DataFactory->CreateSource(OSMFilename));
+    auto InputStart = std::chrono::steady_clock::now();
+    auto BusSystem = std::make_shared<CCSVBusSystem>(StopSource, RouteSource);
+    auto Snapshot = std::make_shared<CStreetMapSnapshot>(std::make_shared<CMappedFile>(Parser.DataDirectory() + "/" + SnapshotFilename));
+    std::shared_ptr<CStreetMap> StreetMap = Snapshot;
+    bool UseSnapshot = Snapshot->Valid() && Snapshot->MatchesSource(Parser.DataDirectory() + "/" + OSMFilename);
+    if(!UseSnapshot){
+        auto XMLReader = std::make_shared<CXMLReader>(OSMSource,CXMLReader::EParser::Native);
+        StreetMap = std::make_shared<COpenStreetMap>(XMLReader);
+    }
+    auto InputDuration = std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now()-InputStart);
     auto PlannerConfig = std::make_shared<STransportationPlannerConfig>(StreetMap, BusSystem);
 
     CSpeedTest SpeedTester(StdOut,StdErr,PlannerConfig);
+    std::vector< std::pair< std::string, SDataStatistics > > InputStatistics = {{StopFilename,StopSource->Statistics()},{RouteFilename,RouteSource->Statistics()}};
+    if(!UseSnapshot){
+        InputStatistics.push_back({OSMFilename,OSMSource->Statistics()});
+    }
+    SpeedTester.ReportInput(InputDuration.count(),InputStatistics);
 
     if(SpeedTester.RunTest(Parser.Seed(),Parser.NumPoints(),Parser.Verbose())){
         if(SpeedTester.OutputResults(ResultsFactory,Parser.Verbose())){
@@ -200,6 +220,12 @@ CSpeedTest::CSpeedTest(std::shared_ptr<CDataSink> out, std::shared_ptr<CDataSink
         NotifyString("Violated precompute time!!!\n");
     }
     DLoadDurationCount = LoadDuration.count();
+    DInputDurationCount = 0;
+}
+
+void CSpeedTest::ReportInput(uint64_t duration, const std::vector< std::pair< std::string, SDataStatistics > > &statistics){
+    DInputDurationCount = duration;
+    DInputStatistics = statistics;
 }
 
 std::string CSpeedTest::DistanceToString(double dist){
@@ -285,7 +311,7 @@ void CSpeedTest::NotifyString(const std::string &str){
 }
 
 void CSpeedTest::WriteStringToSink(std::shared_ptr<CDataSink> sink, const std::string &str){
-    sink->Write(std::vector<char>(str.begin(),str.end()));
+    sink->WriteString(str);
 }
 
 bool CSpeedTest::RunTest(uint64_t seed, uint64_t numpoints, bool verbose){
@@ -341,7 +367,11 @@ bool CSpeedTest::OutputResults(std::shared_ptr<CDataFactory> results, bool verbo
     }
     auto SamplesPerDay = long((86400000 - DLoadDurationCount) / (double(DProcessingDurationCount) / DShortestPaths.size()));
     auto MarginOfError = long(double(SamplesPerDay) / sqrt(DShortestPaths.size()));
-    std::string Summary = "Duration (load): " + std::to_string(DLoadDurationCount) + "\n";
+    std::string Summary = "Duration (input): " + std::to_string(DInputDurationCount) + "\n";
+    for(auto &Input : DInputStatistics){
+        Summary += "I/O (" + Input.first + "): " + Input.second.ToString() + "\n";
+    }
+    Summary += "Duration (load): " + std::to_string(DLoadDurationCount) + "\n";
     Summary += "Duration (proc): " + std::to_string(DProcessingDurationCount) + "\n";
     Summary += "Queries per day: " + std::to_string(SamplesPerDay) + " (+-" + std::to_string(MarginOfError) + "), " + std::to_string(SamplesPerDay - MarginOfError) + " min\n";
 
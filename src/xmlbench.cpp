@@ -0,0 +1,150 @@
+#include "XMLReader.h"
+#include "XMLTokenizer.h"
+#include "FileDataSource.h"
+#include "StringUtils.h"
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Number of entities and a checksum over their contents, with runs of
+// character data joined since expat splits them at other places
+struct SParseSummary{
+    std::size_t DEntities = 0;
+    std::size_t DChecksum = 0;
+    bool DLastCharData = false;
+
+    void Add(SXMLEntity::EType type, std::string_view name){
+        std::hash<std::string_view> Hash;
+        if(type == SXMLEntity::EType::CharData){
+            if(!DLastCharData){
+                DEntities++;
+            }
+            for(auto Ch : name){
+                DChecksum = DChecksum * 31 + static_cast<unsigned char>(Ch);
+            }
+            DLastCharData = true;
+            return;
+        }
+        DEntities++;
+        DChecksum = DChecksum * 131 + static_cast<std::size_t>(type) + Hash(name);
+        DLastCharData = false;
+    }
+
+    bool operator==(const SParseSummary &other) const{
+        return DEntities == other.DEntities && DChecksum == other.DChecksum;
+    }
+};
+
+using TParse = SParseSummary (*)(std::shared_ptr< const CMappedFile >);
+
+static SParseSummary ReadEntities(std::shared_ptr< const CMappedFile > file, CXMLReader::EParser parser){
+    SParseSummary Summary;
+    CXMLReader Reader(std::make_shared<CFileDataSource>(file), parser);
+    SXMLEntity Entity;
+    while(Reader.ReadEntity(Entity)){
+        Summary.Add(Entity.DType,Entity.DNameData);
+        for(auto &Attribute : Entity.DAttributes){
+            Summary.Add(Entity.DType,Attribute.first);
+            Summary.Add(Entity.DType,Attribute.second);
+        }
+    }
+    return Summary;
+}
+
+static SParseSummary ExpatEntities(std::shared_ptr< const CMappedFile > file){
+    return ReadEntities(file,CXMLReader::EParser::Expat);
+}
+
+static SParseSummary NativeEntities(std::shared_ptr< const CMappedFile > file){
+    return ReadEntities(file,CXMLReader::EParser::Native);
+}
+
+struct SSummaryHandler : public CXMLHandler{
+    SParseSummary DSummary;
+
+    void StartElement(TXMLAtom /*atom*/, std::string_view name, const CXMLAttributes &attributes) override{
+        DSummary.Add(SXMLEntity::EType::StartElement,name);
+        for(auto &Attribute : attributes.Views()){
+            DSummary.Add(SXMLEntity::EType::StartElement,Attribute.first);
+            DSummary.Add(SXMLEntity::EType::StartElement,Attribute.second);
+        }
+    }
+
+    void EndElement(TXMLAtom /*atom*/, std::string_view name) override{
+        DSummary.Add(SXMLEntity::EType::EndElement,name);
+    }
+
+    void CharData(std::string_view data) override{
+        DSummary.Add(SXMLEntity::EType::CharData,data);
+    }
+};
+
+static SParseSummary ParseEntities(std::shared_ptr< const CMappedFile > file, CXMLReader::EParser parser){
+    SSummaryHandler Handler;
+    CXMLReader Reader(std::make_shared<CFileDataSource>(file), parser);
+    Reader.Parse(Handler);
+    return Handler.DSummary;
+}
+
+static SParseSummary ExpatParse(std::shared_ptr< const CMappedFile > file){
+    return ParseEntities(file,CXMLReader::EParser::Expat);
+}
+
+static SParseSummary NativeParse(std::shared_ptr< const CMappedFile > file){
+    return ParseEntities(file,CXMLReader::EParser::Native);
+}
+
+// The tokenizer on its own, without copying tokens into entities
+static SParseSummary NativeTokens(std::shared_ptr< const CMappedFile > file){
+    SParseSummary Summary;
+    CXMLTokenizer Tokenizer(std::make_shared<CFileDataSource>(file));
+    SXMLToken Token;
+    while(Tokenizer.ReadToken(Token)){
+        Summary.Add(Token.DType,Token.DNameData);
+        for(auto &Attribute : Token.DAttributes){
+            Summary.Add(Token.DType,Attribute.first);
+            Summary.Add(Token.DType,Attribute.second);
+        }
+    }
+    return Summary;
+}
+
+static SParseSummary RunBenchmark(const std::string &label, std::shared_ptr< const CMappedFile > file, TParse parse, std::size_t iterations){
+    SParseSummary Summary;
+    auto Start = std::chrono::steady_clock::now();
+    for(std::size_t Index = 0; Index < iterations; Index++){
+        Summary = parse(file);
+    }
+    auto Duration = std::chrono::duration<double>(std::chrono::steady_clock::now() - Start).count();
+    double Megabytes = double(file->Contents().size()) * iterations / 1048576.0;
+    std::cout<<StringUtils::LJust(label,32)<<StringUtils::RJust(std::to_string(long(Megabytes / Duration)),8)<<" MB/s"<<StringUtils::RJust(std::to_string(Summary.DEntities),12)<<" entities"<<std::endl;
+    return Summary;
+}
+
+int main(int argc, char *argv[]){
+    std::size_t Iterations = 20;
+    std::vector<std::string> Filenames = {"./data/city.osm", "./data/davis.osm"};
+    if(argc > 1){
+        Iterations = std::stoull(argv[1]);
+    }
+    if(argc > 2){
+        Filenames.assign(argv + 2, argv + argc);
+    }
+    int Result = EXIT_SUCCESS;
+    for(auto &Filename : Filenames){
+        auto File = std::make_shared<CMappedFile>(Filename);
+        std::cout<<Filename<<" ("<<File->Contents().size()<<" bytes, "<<Iterations<<" passes)"<<std::endl;
+        auto Expected = RunBenchmark("expat CXMLReader",File,ExpatEntities,Iterations);
+        auto Native = RunBenchmark("native CXMLReader",File,NativeEntities,Iterations);
+        auto ExpatPushed = RunBenchmark("expat CXMLReader::Parse",File,ExpatParse,Iterations);
+        auto NativePushed = RunBenchmark("native CXMLReader::Parse",File,NativeParse,Iterations);
+        auto Tokens = RunBenchmark("native CXMLTokenizer",File,NativeTokens,Iterations);
+        if(!(Native == Expected) || !(ExpatPushed == Expected) || !(NativePushed == Expected) || !(Tokens == Expected)){
+            std::cout<<"native parser events differ from expat"<<std::endl;
+            Result = EXIT_FAILURE;
+        }
+    }
+    return Result;
+}
@@ -0,0 +1,46 @@
+#include <gtest/gtest.h>
+#include "ByteScan.h"
+#include <string>
+
+namespace{
+    const ByteScan::EImplementation Implementations[] = {ByteScan::EImplementation::Scalar, ByteScan::EImplementation::SSE2, ByteScan::EImplementation::AVX2};
+}
+
+TEST(ByteScan, EmptyTest){
+    for(auto Implementation : Implementations){
+        EXPECT_EQ(ByteScan::FindAny("", ",\n", Implementation),0);
+        EXPECT_EQ(ByteScan::FindAny("abc", "", Implementation),3);
+        EXPECT_EQ(ByteScan::FindAny("abc", "xyz", Implementation),3);
+    }
+}
+
+TEST(ByteScan, EveryPositionTest){
+    // Puts a single match at every offset of buffers spanning several blocks
+    for(auto Implementation : Implementations){
+        for(std::size_t Length = 1; Length < 100; Length++){
+            for(std::size_t Position = 0; Position < Length; Position++){
+                std::string Data(Length, 'a');
+                Data[Position] = Position % 2 ? '\n' : '\"';
+                EXPECT_EQ(ByteScan::FindAny(Data, ",\"\n", Implementation),Position);
+            }
+        }
+    }
+}
+
+TEST(ByteScan, FirstMatchTest){
+    std::string Data = std::string(40, 'x') + "<a & b>" + std::string(40, 'y');
+    for(auto Implementation : Implementations){
+        EXPECT_EQ(ByteScan::FindAny(Data, "&<>", Implementation),40);
+        EXPECT_EQ(ByteScan::FindAny(Data, "&>", Implementation),43);
+        EXPECT_EQ(ByteScan::FindAny(std::string_view(Data).substr(41), "&>", Implementation),2);
+        // Bytes with the high bit set must compare as bytes, not signed values
+        EXPECT_EQ(ByteScan::FindAny(Data + "\xff", "\xff", Implementation),Data.size());
+    }
+}
+
+TEST(ByteScan, ManyNeedlesTest){
+    std::string Data(50, 'q');
+    Data[33] = '9';
+    EXPECT_EQ(ByteScan::FindAny(Data, "123456789"),33);
+    EXPECT_EQ(ByteScan::FindAny(Data, "12345678"),50);
+}
@@ -2,6 +2,8 @@
 #include "CSVBusSystem.h"
 #include "StringDataSource.h"
 #include "DSVReader.h"
+#include <algorithm>
+#include <string>
 
 TEST(CSVBusSystem, SimpleFiles){
     auto StopDataSource = std::make_shared< CStringDataSource >("stop_id,node_id\n"
@@ -514,4 +516,106 @@ TEST(CSVBusSystem, EmptyRouteAndStopFile) {
     CCSVBusSystem BusSystem(StopReader, RouteReader);
 
     EXPECT_EQ(BusSystem.RouteCount(), 0);
-}
\ No newline at end of file
+}
+namespace{
+    // Lends only small pieces, like a source reading ahead in chunks, so the
+    // loader has to copy rather than parse the contents in place
+    class CChunkedDataSource : public CStringDataSource{
+        public:
+            using CStringDataSource::CStringDataSource;
+
+            bool Borrow(std::span<const char> &span, std::size_t count) noexcept override{
+                return CStringDataSource::Borrow(span, std::min<std::size_t>(count, 1000));
+            };
+    };
+
+    // Enough rows that the parallel loader splits the files between threads
+    void MakeLargeFiles(std::string &stops, std::string &routes, std::size_t count){
+        stops = "node_id,stop_id\n";
+        routes = "route,stop_id\n";
+        for(std::size_t Index = 0; Index < count; Index++){
+            // stop IDs deliberately out of order and a quoted value now and then
+            std::size_t StopID = (Index * 7919) % count + 1;
+            stops += std::to_string(1000000 + Index) + "," + (Index % 5 ? std::to_string(StopID) : "\"" + std::to_string(StopID) + "\"") + "\n";
+            routes += (Index % 3 ? "R" + std::to_string(Index % 17) : "\"Route,\n\"\"" + std::to_string(Index % 11) + "\"\"\"") + "," + std::to_string(StopID) + "\n";
+        }
+    }
+
+    void ExpectSameSystems(const CCSVBusSystem &left, const CCSVBusSystem &right){
+        ASSERT_EQ(left.StopCount(),right.StopCount());
+        ASSERT_EQ(left.RouteCount(),right.RouteCount());
+        for(std::size_t Index = 0; Index < left.StopCount(); Index++){
+            EXPECT_EQ(left.StopByIndex(Index)->ID(),right.StopByIndex(Index)->ID());
+            EXPECT_EQ(left.StopByIndex(Index)->NodeID(),right.StopByIndex(Index)->NodeID());
+        }
+        for(std::size_t Index = 0; Index < left.RouteCount(); Index++){
+            auto LeftRoute = left.RouteByIndex(Index);
+            auto RightRoute = right.RouteByIndex(Index);
+            EXPECT_EQ(LeftRoute->Name(),RightRoute->Name());
+            ASSERT_EQ(LeftRoute->StopCount(),RightRoute->StopCount());
+            for(std::size_t StopIndex = 0; StopIndex < LeftRoute->StopCount(); StopIndex++){
+                EXPECT_EQ(LeftRoute->GetStopID(StopIndex),RightRoute->GetStopID(StopIndex));
+            }
+        }
+        EXPECT_EQ(left.LoadError(),right.LoadError());
+    }
+}
+
+TEST(CSVBusSystem, LoadErrorTest){
+    auto StopReader = std::make_shared<CDSVReader>(std::make_shared<CStringDataSource>("stop_id,node_id\n1,10\n2,20\n1,30\n"), ',');
+    auto RouteReader = std::make_shared<CDSVReader>(std::make_shared<CStringDataSource>("route,stop_id\nA,1\nA,2\n"), ',');
+    CCSVBusSystem BusSystem(StopReader, RouteReader);
+
+    EXPECT_EQ(BusSystem.StopCount(),2);
+    EXPECT_EQ(BusSystem.RouteCount(),1);
+    EXPECT_EQ(BusSystem.LoadError(),"stops row 4: duplicate stop_id 1");
+
+    CCSVBusSystem BusSystem2(std::make_shared<CStringDataSource>("stop_id,node_id\n1,10\n"), std::make_shared<CStringDataSource>("route,stop\nA,1\n"));
+    EXPECT_EQ(BusSystem2.StopCount(),1);
+    EXPECT_EQ(BusSystem2.RouteCount(),0);
+    EXPECT_EQ(BusSystem2.LoadError(),"routes: missing route or stop_id header");
+
+    CCSVBusSystem BusSystem3(std::make_shared<CStringDataSource>("stop_id,node_id\n1,10\n"), std::make_shared<CStringDataSource>("route,stop_id\nA,1\nB,1\n"));
+    EXPECT_EQ(BusSystem3.RouteCount(),2);
+    EXPECT_TRUE(BusSystem3.LoadError().empty());
+}
+
+TEST(CSVBusSystem, ParallelLoadTest){
+    std::string Stops, Routes;
+    MakeLargeFiles(Stops, Routes, 30000);
+    ASSERT_GT(Routes.size(),4 * 65536);
+
+    CCSVBusSystem Sequential(std::make_shared<CDSVReader>(std::make_shared<CStringDataSource>(Stops), ','), std::make_shared<CDSVReader>(std::make_shared<CStringDataSource>(Routes), ','));
+    EXPECT_EQ(Sequential.StopCount(),30000);
+    EXPECT_TRUE(Sequential.LoadError().empty());
+    for(std::size_t Threads : {1, 2, 4, 7}){
+        CCSVBusSystem Parallel(std::make_shared<CStringDataSource>(Stops), std::make_shared<CStringDataSource>(Routes), ',', Threads);
+        ExpectSameSystems(Sequential, Parallel);
+        CCSVBusSystem Copied(std::make_shared<CChunkedDataSource>(Stops), std::make_shared<CChunkedDataSource>(Routes), ',', Threads);
+        ExpectSameSystems(Sequential, Copied);
+    }
+}
+
+TEST(CSVBusSystem, ParallelErrorRowTest){
+    std::string Stops, Routes;
+    MakeLargeFiles(Stops, Routes, 20000);
+    // Break a row well into the last piece, counting rows rather than lines
+    // since some route names hold newlines
+    auto BadStop = Stops.find("\n1019001,") + 9;
+    char GoodStop = Stops[BadStop];
+    Stops[BadStop] = 'x';
+    auto BadRoute = Routes.rfind(",", Routes.size() - 2);
+    Routes.insert(BadRoute + 1, "-");
+
+    CCSVBusSystem Sequential(std::make_shared<CDSVReader>(std::make_shared<CStringDataSource>(Stops), ','), std::make_shared<CDSVReader>(std::make_shared<CStringDataSource>(Routes), ','));
+    EXPECT_EQ(Sequential.StopCount(),19001);
+    EXPECT_EQ(Sequential.LoadError(),"stops row 19003: invalid stop_id or node_id");
+    CCSVBusSystem Parallel(std::make_shared<CStringDataSource>(Stops), std::make_shared<CStringDataSource>(Routes), ',', 4);
+    ExpectSameSystems(Sequential, Parallel);
+
+    Stops[BadStop] = GoodStop;
+    CCSVBusSystem Sequential2(std::make_shared<CDSVReader>(std::make_shared<CStringDataSource>(Stops), ','), std::make_shared<CDSVReader>(std::make_shared<CStringDataSource>(Routes), ','));
+    EXPECT_EQ(Sequential2.LoadError(),"routes row 20001: invalid route or stop_id");
+    CCSVBusSystem Parallel2(std::make_shared<CStringDataSource>(Stops), std::make_shared<CStringDataSource>(Routes), ',', 4);
+    ExpectSameSystems(Sequential2, Parallel2);
+}
@@ -0,0 +1,96 @@
+#include <gtest/gtest.h>
+#include "ConcatenatedDataSource.h"
+#include "StringDataSource.h"
+
+namespace{
+    std::vector< std::shared_ptr< CDataSource > > MakeSources(const std::vector< std::string > &strings){
+        std::vector< std::shared_ptr< CDataSource > > Sources;
+        for(auto &String : strings){
+            Sources.push_back(std::make_shared<CStringDataSource>(String));
+        }
+        return Sources;
+    }
+
+    std::string ReadAll(CDataSource &source){
+        std::string Result;
+        char TempCh;
+        while(source.Get(TempCh)){
+            Result += TempCh;
+        }
+        return Result;
+    }
+}
+
+TEST(ConcatenatedDataSource, EmptyTest){
+    CConcatenatedDataSource NoSources({});
+    CConcatenatedDataSource EmptySources(MakeSources({"", "", ""}), true, true);
+    char TempCh = 'x';
+    std::span<const char> Span;
+
+    EXPECT_TRUE(NoSources.End());
+    EXPECT_FALSE(NoSources.Get(TempCh));
+    EXPECT_TRUE(EmptySources.End());
+    EXPECT_FALSE(EmptySources.Peek(TempCh));
+    EXPECT_FALSE(EmptySources.Borrow(Span, 4));
+    EXPECT_EQ(TempCh,'x');
+}
+
+TEST(ConcatenatedDataSource, GetTest){
+    CConcatenatedDataSource Source(MakeSources({"ab", "", "c", "de"}));
+    char TempCh;
+
+    EXPECT_TRUE(Source.Peek(TempCh));
+    EXPECT_EQ(TempCh,'a');
+    EXPECT_EQ(ReadAll(Source),"abcde");
+    EXPECT_TRUE(Source.End());
+}
+
+TEST(ConcatenatedDataSource, ReadTest){
+    CConcatenatedDataSource Source(MakeSources({"Hello", " ", "World"}));
+    std::vector<char> Buffer;
+
+    EXPECT_TRUE(Source.Read(Buffer, 7));
+    EXPECT_EQ(std::string(Buffer.begin(), Buffer.end()),"Hello W");
+    EXPECT_TRUE(Source.Read(Buffer, 100));
+    EXPECT_EQ(std::string(Buffer.begin(), Buffer.end()),"orld");
+    EXPECT_TRUE(Source.End());
+    EXPECT_FALSE(Source.Read(Buffer, 100));
+}
+
+TEST(ConcatenatedDataSource, BorrowTest){
+    CConcatenatedDataSource Source(MakeSources({"abc", "def"}));
+    std::span<const char> Span;
+
+    // Borrowing never crosses from one source into the next
+    EXPECT_TRUE(Source.Borrow(Span, 100));
+    EXPECT_EQ(std::string(Span.data(), Span.size()),"abc");
+    EXPECT_TRUE(Source.Borrow(Span, 2));
+    EXPECT_EQ(std::string(Span.data(), Span.size()),"de");
+    EXPECT_TRUE(Source.Borrow(Span, 2));
+    EXPECT_EQ(std::string(Span.data(), Span.size()),"f");
+    EXPECT_FALSE(Source.Borrow(Span, 2));
+}
+
+TEST(ConcatenatedDataSource, JoinLinesTest){
+    CConcatenatedDataSource Joined(MakeSources({"a,b", "c,d\n", "", "e,f"}), false, true);
+    CConcatenatedDataSource Plain(MakeSources({"a,b", "c,d\n", "", "e,f"}));
+    std::vector<char> Buffer;
+
+    EXPECT_TRUE(Joined.Read(Buffer, 100));
+    EXPECT_EQ(std::string(Buffer.begin(), Buffer.end()),"a,b\nc,d\ne,f");
+    EXPECT_EQ(ReadAll(Plain),"a,bc,d\ne,f");
+}
+
+TEST(ConcatenatedDataSource, SkipHeadersTest){
+    CConcatenatedDataSource Source(MakeSources({"", "id,name\n1,A\n", "id,name\n", "id,name\n2,B"}), true, true);
+    std::string Line;
+
+    EXPECT_TRUE(Source.ReadLine(Line));
+    EXPECT_EQ(Line,"id,name");
+    EXPECT_TRUE(Source.ReadLine(Line));
+    EXPECT_EQ(Line,"1,A");
+    EXPECT_TRUE(Source.ReadLine(Line));
+    EXPECT_EQ(Line,"2,B");
+    EXPECT_TRUE(Source.End());
+    EXPECT_FALSE(Source.ReadLine(Line));
+}
@@ -0,0 +1,114 @@
+#include <gtest/gtest.h>
+#include "DSVColumnReader.h"
+#include "StringDataSource.h"
+
+TEST(DSVFields, ParseTest){
+    uint64_t Unsigned = 7;
+    int64_t Signed = 7;
+    double Double = 7.0;
+
+    EXPECT_TRUE(DSVFields::ParseUInt64("4234732889", Unsigned));
+    EXPECT_EQ(Unsigned,4234732889ULL);
+    EXPECT_TRUE(DSVFields::ParseUInt64(" 18446744073709551615\r", Unsigned));
+    EXPECT_EQ(Unsigned,18446744073709551615ULL);
+    EXPECT_FALSE(DSVFields::ParseUInt64("18446744073709551616", Unsigned));
+    EXPECT_FALSE(DSVFields::ParseUInt64("", Unsigned));
+    EXPECT_FALSE(DSVFields::ParseUInt64("  ", Unsigned));
+    EXPECT_FALSE(DSVFields::ParseUInt64("12abc", Unsigned));
+    EXPECT_FALSE(DSVFields::ParseUInt64("-1", Unsigned));
+    EXPECT_FALSE(DSVFields::ParseUInt64("1 2", Unsigned));
+    EXPECT_EQ(Unsigned,18446744073709551615ULL);
+
+    EXPECT_TRUE(DSVFields::ParseInt64("-42", Signed));
+    EXPECT_EQ(Signed,-42);
+    EXPECT_FALSE(DSVFields::ParseInt64("+42", Signed));
+
+    EXPECT_TRUE(DSVFields::ParseDouble("38.5449", Double));
+    EXPECT_DOUBLE_EQ(Double,38.5449);
+    EXPECT_TRUE(DSVFields::ParseDouble("-1.5e3", Double));
+    EXPECT_DOUBLE_EQ(Double,-1500.0);
+    EXPECT_FALSE(DSVFields::ParseDouble("1.2.3", Double));
+    EXPECT_DOUBLE_EQ(Double,-1500.0);
+}
+
+TEST(IntegerListDecoder, DecodeTest){
+    std::vector<uint64_t> Values;
+    uint64_t Value;
+
+    CIntegerListDecoder Decoder("5598639595,2607436609, 2607436581");
+    while(Decoder.Next(Value)){
+        Values.push_back(Value);
+    }
+    EXPECT_FALSE(Decoder.Failed());
+    EXPECT_EQ(Values,std::vector<uint64_t>({5598639595ULL, 2607436609ULL, 2607436581ULL}));
+
+    CIntegerListDecoder Empty("");
+    EXPECT_FALSE(Empty.Next(Value));
+    EXPECT_FALSE(Empty.Failed());
+
+    CIntegerListDecoder Underscores("1_2", '_');
+    EXPECT_TRUE(Underscores.Next(Value));
+    EXPECT_EQ(Value,1);
+    EXPECT_TRUE(Underscores.Next(Value));
+    EXPECT_EQ(Value,2);
+    EXPECT_FALSE(Underscores.Next(Value));
+    EXPECT_FALSE(Underscores.Failed());
+
+    CIntegerListDecoder Malformed("1,,2");
+    EXPECT_TRUE(Malformed.Next(Value));
+    EXPECT_FALSE(Malformed.Next(Value));
+    EXPECT_TRUE(Malformed.Failed());
+    EXPECT_FALSE(Malformed.Next(Value));
+
+    CIntegerListDecoder Trailing("1,");
+    EXPECT_TRUE(Trailing.Next(Value));
+    EXPECT_FALSE(Trailing.Next(Value));
+    EXPECT_TRUE(Trailing.Failed());
+}
+
+TEST(DSVColumnReader, ColumnTest){
+    auto Source = std::make_shared<CStringDataSource>("src_id,dest_id,routes,path\n"
+                                                      "95709746,265674141,X,\"95709746,2765507080,265674141\"\n"
+                                                      "1,bad\n"
+                                                      "3");
+    CDSVColumnReader Reader(std::make_shared<CDSVReader>(Source, ','));
+    uint64_t Value = 0;
+
+    ASSERT_TRUE(Reader.HeaderValid());
+    EXPECT_EQ(Reader.Header(),std::vector<std::string>({"src_id", "dest_id", "routes", "path"}));
+    EXPECT_EQ(Reader.Column("path"),3);
+    EXPECT_EQ(Reader.Column("missing"),CDSVColumnReader::InvalidColumn);
+    EXPECT_EQ(Reader.RowCount(),0);
+
+    EXPECT_TRUE(Reader.NextRow());
+    EXPECT_EQ(Reader.RowCount(),1);
+    EXPECT_EQ(Reader.ValueCount(),4);
+    EXPECT_TRUE(Reader.GetUInt64(Reader.Column("dest_id"), Value));
+    EXPECT_EQ(Value,265674141);
+    EXPECT_EQ(Reader.Value(2),"X");
+    CIntegerListDecoder Path(Reader.Value(3));
+    EXPECT_TRUE(Path.Next(Value));
+    EXPECT_EQ(Value,95709746);
+
+    EXPECT_TRUE(Reader.NextRow());
+    EXPECT_TRUE(Reader.GetUInt64(0, Value));
+    EXPECT_EQ(Value,1);
+    EXPECT_FALSE(Reader.GetUInt64(1, Value));
+    EXPECT_FALSE(Reader.HasValue(2));
+    EXPECT_EQ(Reader.Value(2),"");
+    EXPECT_FALSE(Reader.GetUInt64(CDSVColumnReader::InvalidColumn, Value));
+    EXPECT_EQ(Value,1);
+
+    EXPECT_TRUE(Reader.NextRow());
+    EXPECT_EQ(Reader.RowCount(),3);
+    EXPECT_FALSE(Reader.NextRow());
+    EXPECT_EQ(Reader.RowCount(),3);
+}
+
+TEST(DSVColumnReader, EmptyTest){
+    CDSVColumnReader Reader(std::make_shared<CDSVReader>(std::make_shared<CStringDataSource>(""), ','));
+
+    EXPECT_FALSE(Reader.HeaderValid());
+    EXPECT_TRUE(Reader.Header().empty());
+    EXPECT_FALSE(Reader.NextRow());
+}
@@ -0,0 +1,146 @@
+#include <gtest/gtest.h>
+#include "DSVTable.h"
+#include "StringDataSource.h"
+
+static std::shared_ptr<CDSVReader> TableReader(const std::string &text){
+    return std::make_shared<CDSVReader>(std::make_shared<CStringDataSource>(text), ',');
+}
+
+TEST(DSVTable, ColumnTypeTest){
+    CDSVTable Table(TableReader("id,lat,name,mixed\n"
+                                "1,38.5,Davis,7\n"
+                                "2,-121,\"Sacramento, CA\",x\n"
+                                "3,,Davis,8\n"));
+
+    ASSERT_TRUE(Table.HeaderValid());
+    EXPECT_EQ(Table.Header(),std::vector<std::string>({"id","lat","name","mixed"}));
+    EXPECT_EQ(Table.ColumnCount(),4);
+    EXPECT_EQ(Table.RowCount(),3);
+    EXPECT_EQ(Table.Column("name"),2);
+    EXPECT_EQ(Table.Column("missing"),CDSVTable::InvalidColumn);
+
+    auto ID = Table.Column("id");
+    EXPECT_EQ(Table.ColumnType(ID),CDSVTable::EColumnType::Integer);
+    EXPECT_EQ(std::vector<int64_t>(Table.Integers(ID).begin(),Table.Integers(ID).end()),std::vector<int64_t>({1,2,3}));
+    EXPECT_TRUE(Table.Doubles(ID).empty());
+    EXPECT_TRUE(Table.StringIDs(ID).empty());
+
+    auto Latitude = Table.Column("lat");
+    EXPECT_EQ(Table.ColumnType(Latitude),CDSVTable::EColumnType::Double);
+    ASSERT_EQ(Table.Doubles(Latitude).size(),3);
+    EXPECT_DOUBLE_EQ(Table.Doubles(Latitude)[0],38.5);
+    EXPECT_DOUBLE_EQ(Table.Doubles(Latitude)[1],-121.0);
+    EXPECT_TRUE(Table.HasValue(Latitude,1));
+    EXPECT_FALSE(Table.HasValue(Latitude,2));
+    EXPECT_FALSE(Table.HasValue(Latitude,3));
+
+    auto Name = Table.Column("name");
+    EXPECT_EQ(Table.ColumnType(Name),CDSVTable::EColumnType::String);
+    EXPECT_EQ(Table.StringCount(Name),2);
+    EXPECT_EQ(std::vector<CDSVTable::TStringID>(Table.StringIDs(Name).begin(),Table.StringIDs(Name).end()),std::vector<CDSVTable::TStringID>({0,1,0}));
+    EXPECT_EQ(Table.StringByID(Name,1),"Sacramento, CA");
+    EXPECT_EQ(Table.FindString(Name,"Davis"),0);
+    EXPECT_EQ(Table.FindString(Name,"Dixon"),CDSVTable::InvalidStringID);
+    EXPECT_EQ(Table.String(Name,2),"Davis");
+    EXPECT_EQ(Table.String(ID,0),"");
+
+    // numbers read before the first text value are kept as they were written
+    auto Mixed = Table.Column("mixed");
+    EXPECT_EQ(Table.ColumnType(Mixed),CDSVTable::EColumnType::String);
+    EXPECT_EQ(Table.String(Mixed,0),"7");
+    EXPECT_EQ(Table.String(Mixed,1),"x");
+    EXPECT_EQ(Table.String(Mixed,2),"8");
+}
+
+TEST(DSVTable, GetValueTest){
+    CDSVTable Table(TableReader("small,big,real,text,short\n"
+                                "-5,18446744073709551615,1.5,12,1\n"
+                                "6,1,2,abc\n"));
+    uint64_t Unsigned = 99;
+    int64_t Signed = 99;
+    double Double = 99.0;
+
+    EXPECT_EQ(Table.ColumnType(0),CDSVTable::EColumnType::Integer);
+    EXPECT_FALSE(Table.GetUInt64(0,0,Unsigned));
+    EXPECT_TRUE(Table.GetInt64(0,0,Signed));
+    EXPECT_EQ(Signed,-5);
+    EXPECT_TRUE(Table.GetUInt64(0,1,Unsigned));
+    EXPECT_EQ(Unsigned,6);
+    EXPECT_TRUE(Table.GetDouble(0,1,Double));
+    EXPECT_DOUBLE_EQ(Double,6.0);
+
+    // too large for int64_t, so kept as text rather than rounded
+    EXPECT_EQ(Table.ColumnType(1),CDSVTable::EColumnType::String);
+    EXPECT_TRUE(Table.GetUInt64(1,0,Unsigned));
+    EXPECT_EQ(Unsigned,18446744073709551615ULL);
+    EXPECT_FALSE(Table.GetInt64(1,0,Signed));
+
+    EXPECT_EQ(Table.ColumnType(2),CDSVTable::EColumnType::Double);
+    EXPECT_FALSE(Table.GetInt64(2,1,Signed));
+    EXPECT_TRUE(Table.GetDouble(2,1,Double));
+    EXPECT_DOUBLE_EQ(Double,2.0);
+
+    EXPECT_TRUE(Table.GetUInt64(3,0,Unsigned));
+    EXPECT_EQ(Unsigned,12);
+    EXPECT_FALSE(Table.GetUInt64(3,1,Unsigned));
+
+    // the second row is short
+    EXPECT_TRUE(Table.HasValue(4,0));
+    EXPECT_FALSE(Table.HasValue(4,1));
+    EXPECT_FALSE(Table.GetInt64(4,1,Signed));
+    EXPECT_FALSE(Table.GetInt64(4,2,Signed));
+    EXPECT_FALSE(Table.GetInt64(5,0,Signed));
+    EXPECT_EQ(Signed,-5);
+}
+
+TEST(DSVTable, StringColumnTest){
+    CDSVTable Table(TableReader("route,stop_id,blank\n010,1,\n10,2,\n"),{"route"});
+
+    EXPECT_EQ(Table.ColumnType(Table.Column("route")),CDSVTable::EColumnType::String);
+    EXPECT_EQ(Table.String(Table.Column("route"),0),"010");
+    EXPECT_EQ(Table.String(Table.Column("route"),1),"10");
+    EXPECT_EQ(Table.ColumnType(Table.Column("stop_id")),CDSVTable::EColumnType::Integer);
+    // a column without any values has nothing to be a number
+    EXPECT_EQ(Table.ColumnType(Table.Column("blank")),CDSVTable::EColumnType::String);
+    EXPECT_FALSE(Table.HasValue(Table.Column("blank"),0));
+}
+
+TEST(DSVTable, NumbersTurnedToTextTest){
+    // every way a number can be written differently from how it prints,
+    // before a text value turns each column into strings
+    CDSVTable Table(TableReader("int,real,big\n"
+                                "007,1.50,9007199254740993\n"
+                                "-0,2,\n"
+                                "12,-3.25,1.5\n"
+                                ",+4,1\n"
+                                "+8,1e3,x\n"
+                                "x,x,\n"));
+
+    for(std::size_t Column = 0; Column < Table.ColumnCount(); Column++){
+        EXPECT_EQ(Table.ColumnType(Column),CDSVTable::EColumnType::String);
+    }
+    std::vector<std::vector<std::string>> Expected = {
+        {"007","-0","12","","+8","x"},
+        {"1.50","2","-3.25","+4","1e3","x"},
+        {"9007199254740993","","1.5","1","x",""}
+    };
+    for(std::size_t Column = 0; Column < Expected.size(); Column++){
+        for(std::size_t Row = 0; Row < Expected[Column].size(); Row++){
+            EXPECT_EQ(Table.String(Column,Row),Expected[Column][Row]);
+            EXPECT_EQ(Table.HasValue(Column,Row),!Expected[Column][Row].empty());
+        }
+    }
+}
+
+TEST(DSVTable, EmptyTest){
+    CDSVTable Empty(TableReader(""));
+    EXPECT_FALSE(Empty.HeaderValid());
+    EXPECT_EQ(Empty.RowCount(),0);
+    EXPECT_EQ(Empty.ColumnCount(),0);
+
+    CDSVTable HeaderOnly(TableReader("a,b\n"));
+    EXPECT_TRUE(HeaderOnly.HeaderValid());
+    EXPECT_EQ(HeaderOnly.RowCount(),0);
+    EXPECT_EQ(HeaderOnly.ColumnCount(),2);
+    EXPECT_EQ(HeaderOnly.ColumnType(0),CDSVTable::EColumnType::String);
+}
@@ -3,6 +3,34 @@
 #include "DSVReader.h"
 #include "StringDataSink.h"
 #include "StringDataSource.h"
+#include "StringViewDataSource.h"
+#include <cstring>
+
+// Hands out at most a couple of bytes per read so quotes, escapes and
+// delimiters land on block boundaries
+class CTrickleDataSource : public CStringDataSource{
+    private:
+        std::size_t DLimit;
+    public:
+        CTrickleDataSource(std::string str, std::size_t limit) : CStringDataSource(std::move(str)), DLimit(limit){}
+
+        std::size_t ReadSpan(std::span<char> buf) noexcept override{
+            return CStringDataSource::ReadSpan(buf.first(std::min(buf.size(), DLimit)));
+        }
+        bool Borrow(std::span<const char> &/*span*/, std::size_t /*count*/) noexcept override{
+            return false;
+        }
+};
+
+// Same as CTrickleDataSource but can only be read forward
+class CStreamDataSource : public CTrickleDataSource{
+    public:
+        using CTrickleDataSource::CTrickleDataSource;
+
+        bool Seek(std::size_t /*offset*/) noexcept override{
+            return false;
+        }
+};
 
 TEST(DSVWriterReaderTest, EmptyRowTest){
     std::shared_ptr<CStringDataSink> DataSink = std::make_shared<CStringDataSink>();
@@ -414,6 +442,64 @@ TEST(DSVWriterReaderTest, DelimiterIsSomethingElseTest){
     EXPECT_EQ(Row1[2], "ef");
 }
 
+TEST(DSVWriterReaderTest, WriteRowViewTest){
+    std::shared_ptr<CStringDataSink> DataSink = std::make_shared<CStringDataSink>();
+    CDSVWriter Writer(DataSink, ',');
+    std::vector<std::string_view> Row = {"plain", "", "with,comma", "say \"hi\"", "two\nlines"};
+
+    EXPECT_TRUE(Writer.WriteRowView(Row));
+    EXPECT_EQ(DataSink->String(), "plain,,\"with,comma\",\"say \"\"hi\"\"\",\"two\nlines\"");
+
+    CDSVReader Reader(std::make_shared<CStringDataSource>(DataSink->String()), ',');
+    std::vector<std::string> ReadBack;
+    EXPECT_TRUE(Reader.ReadRow(ReadBack));
+    EXPECT_EQ(ReadBack, std::vector<std::string>(Row.begin(), Row.end()));
+}
+
+TEST(DSVWriterReaderTest, WriteRowsTest){
+    std::vector<std::vector<std::string>> Rows = {{"a", "b\"c"}, {}, {"d\te", "f"}, {"g"}};
+    std::shared_ptr<CStringDataSink> DataSink = std::make_shared<CStringDataSink>();
+    CDSVWriter Writer(DataSink, '\t');
+
+    EXPECT_TRUE(Writer.WriteRows(Rows));
+    EXPECT_EQ(DataSink->String(), "a\t\"b\"\"c\"\n\n\"d\te\"\tf\ng");
+    EXPECT_TRUE(Writer.WriteRow({"h"}));
+    EXPECT_EQ(DataSink->String(), "a\t\"b\"\"c\"\n\n\"d\te\"\tf\ng\nh");
+}
+
+TEST(DSVWriterReaderTest, BatchedWriteTest){
+    std::vector<std::vector<std::string>> Rows;
+    for(int Index = 0; Index < 1000; Index++){
+        Rows.push_back({std::to_string(Index), Index % 7 ? "value" : "quoted \"value\"", "x,y"});
+    }
+    std::shared_ptr<CStringDataSink> ImmediateSink = std::make_shared<CStringDataSink>();
+    CDSVWriter ImmediateWriter(ImmediateSink, ',', true);
+    for(auto &Row : Rows){
+        EXPECT_TRUE(ImmediateWriter.WriteRow(Row));
+    }
+
+    std::shared_ptr<CStringDataSink> BatchSink = std::make_shared<CStringDataSink>();
+    {
+        CDSVWriter BatchWriter(BatchSink, ',', true, 4096);
+        EXPECT_TRUE(BatchWriter.WriteRow(Rows[0]));
+        EXPECT_EQ(BatchSink->String(), "");
+        for(std::size_t Index = 1; Index < Rows.size(); Index++){
+            EXPECT_TRUE(BatchWriter.WriteRow(Rows[Index]));
+        }
+        EXPECT_FALSE(BatchSink->String().empty());
+        EXPECT_LT(BatchSink->String().size(), ImmediateSink->String().size());
+    }
+    // the rest is written out when the writer goes away
+    EXPECT_EQ(BatchSink->String(), ImmediateSink->String());
+
+    std::shared_ptr<CStringDataSink> FlushSink = std::make_shared<CStringDataSink>();
+    CDSVWriter FlushWriter(FlushSink, ',', true, 1 << 20);
+    EXPECT_TRUE(FlushWriter.WriteRow(Rows[0]));
+    EXPECT_EQ(FlushSink->String(), "");
+    EXPECT_TRUE(FlushWriter.Flush());
+    EXPECT_EQ(FlushSink->String(), "\"0\",\"quoted \"\"value\"\"\",\"x,y\"");
+}
+
 TEST(DSVReaderTest, SingleRowTest){
     std::shared_ptr<CStringDataSink> DataSink = std::make_shared<CStringDataSink>();
     CDSVWriter Writer(DataSink, ',');
@@ -556,3 +642,244 @@ TEST(DSVReaderTest, EndCoverageTest) {
     EXPECT_TRUE(Reader.End());
 
 }
+
+TEST(DSVReaderTest, BlockBoundaryTest){
+    std::string Input = "\"a\"\"b\",\"\"\"\"\n\"x,\ny\"z,,w\n\n\"\"\"";
+    for(std::size_t Limit : {1, 2, 3, 5}){
+        CDSVReader Reader(std::make_shared<CTrickleDataSource>(Input, Limit), ',');
+        std::vector<std::string> Row;
+
+        EXPECT_TRUE(Reader.ReadRow(Row));
+        EXPECT_EQ(Row,std::vector<std::string>({"a\"b", "\""}));
+        EXPECT_TRUE(Reader.ReadRow(Row));
+        EXPECT_EQ(Row,std::vector<std::string>({"x,\nyz", "", "w"}));
+        EXPECT_TRUE(Reader.ReadRow(Row));
+        EXPECT_EQ(Row,std::vector<std::string>({""}));
+        EXPECT_TRUE(Reader.ReadRow(Row));
+        EXPECT_EQ(Row,std::vector<std::string>({"\""}));
+        EXPECT_TRUE(Reader.End());
+        EXPECT_FALSE(Reader.ReadRow(Row));
+    }
+}
+
+TEST(DSVReaderTest, LongValueTest){
+    // Values longer than a vector block, with the delimiter in every lane position
+    std::string Input;
+    std::vector<std::string> Expected;
+    for(std::size_t Length = 0; Length < 70; Length++){
+        Expected.push_back(std::string(Length, 'a' + Length % 26));
+        Input += Expected.back() + "\t";
+    }
+    Input.back() = '\n';
+    CDSVReader Reader(std::make_shared<CStringDataSource>(Input), '\t');
+    std::vector<std::string> Row;
+
+    EXPECT_TRUE(Reader.ReadRow(Row));
+    EXPECT_EQ(Row,Expected);
+    EXPECT_TRUE(Reader.End());
+}
+
+TEST(DSVReaderTest, ReadRowViewTest){
+    std::string Input = "stop_id,node_id\n1,\"2\"\n\"say \"\"hi\"\"\",,\"a,b\"\n\nmid\"dle\"x,y\nlast,";
+    CDSVReader Reader(std::make_shared<CStringViewDataSource>(Input), ',');
+    std::vector<std::string_view> Row;
+
+    EXPECT_TRUE(Reader.ReadRowView(Row));
+    EXPECT_EQ(Row,std::vector<std::string_view>({"stop_id", "node_id"}));
+    // Plain and simply quoted values point straight into the source
+    EXPECT_GE(Row[0].data(),Input.data());
+    EXPECT_LT(Row[0].data(),Input.data() + Input.size());
+    EXPECT_TRUE(Reader.ReadRowView(Row));
+    EXPECT_EQ(Row,std::vector<std::string_view>({"1", "2"}));
+    EXPECT_EQ(Row[1].data(),Input.data() + Input.find("2\""));
+    EXPECT_TRUE(Reader.ReadRowView(Row));
+    EXPECT_EQ(Row,std::vector<std::string_view>({"say \"hi\"", "", "a,b"}));
+    EXPECT_TRUE(Reader.ReadRowView(Row));
+    EXPECT_EQ(Row,std::vector<std::string_view>({""}));
+    EXPECT_TRUE(Reader.ReadRowView(Row));
+    EXPECT_EQ(Row,std::vector<std::string_view>({"middlex", "y"}));
+    EXPECT_TRUE(Reader.ReadRowView(Row));
+    EXPECT_EQ(Row,std::vector<std::string_view>({"last"}));
+    EXPECT_TRUE(Reader.End());
+    EXPECT_FALSE(Reader.ReadRowView(Row));
+    EXPECT_TRUE(Row.empty());
+}
+
+TEST(DSVReaderTest, ReadRowViewBoundaryTest){
+    std::string Input = "ab,\"c\"\"d\"\n\"e\nf\",g\n";
+    for(std::size_t Limit : {1, 2, 3, 4, 7}){
+        CDSVReader Reader(std::make_shared<CTrickleDataSource>(Input, Limit), ',');
+        std::vector<std::string_view> Row;
+        std::vector<std::string> Copy;
+
+        EXPECT_TRUE(Reader.ReadRowView(Row));
+        Copy.assign(Row.begin(), Row.end());
+        EXPECT_EQ(Copy,std::vector<std::string>({"ab", "c\"d"}));
+        EXPECT_TRUE(Reader.ReadRowView(Row));
+        Copy.assign(Row.begin(), Row.end());
+        EXPECT_EQ(Copy,std::vector<std::string>({"e\nf", "g"}));
+        EXPECT_FALSE(Reader.ReadRowView(Row));
+    }
+}
+
+TEST(DSVReaderTest, SplitRowsTest){
+    std::string Input;
+    for(int Index = 0; Index < 200; Index++){
+        Input += std::to_string(Index) + (Index % 3 ? ",plain\n" : ",\"quoted\n\"\"value\"\"\"\n");
+    }
+    std::vector<std::vector<std::string>> Expected;
+    CDSVReader WholeReader(std::make_shared<CStringDataSource>(Input), ',');
+    std::vector<std::string> Row;
+    while(WholeReader.ReadRow(Row)){
+        Expected.push_back(Row);
+    }
+    for(std::size_t Count : {1, 2, 5, 64, 10000}){
+        auto Pieces = CDSVReader::SplitRows(Input, Count);
+        EXPECT_LE(Pieces.size(),Count);
+        std::vector<std::vector<std::string>> Rows;
+        std::size_t Length = 0;
+        for(auto &Piece : Pieces){
+            EXPECT_EQ(Piece.data(),Input.data() + Length);
+            Length += Piece.size();
+            CDSVReader Reader(std::make_shared<CStringViewDataSource>(Piece), ',');
+            while(Reader.ReadRow(Row)){
+                Rows.push_back(Row);
+            }
+        }
+        EXPECT_EQ(Length,Input.size());
+        EXPECT_EQ(Rows,Expected);
+    }
+    EXPECT_EQ(CDSVReader::SplitRows("", 4),std::vector<std::string_view>({""}));
+}
+
+TEST(DSVReaderTest, PositionTest){
+    std::string Input = "id,name\n1,\"multi\nline\"\n2,b\n3,\"c,\"\"d\"\"\"\n4,e";
+    CDSVReader Reader(std::make_shared<CStringDataSource>(Input), ',');
+    std::vector<std::string> Row;
+
+    EXPECT_EQ(Reader.Position().DOffset,0);
+    EXPECT_EQ(Reader.Position().DRow,0);
+    EXPECT_TRUE(Reader.ReadRow(Row));
+    EXPECT_TRUE(Reader.ReadRow(Row));
+    auto Checkpoint = Reader.Position();
+    EXPECT_EQ(Checkpoint.DOffset,Input.find("2,b"));
+    EXPECT_EQ(Checkpoint.DRow,2);
+
+    std::vector<std::vector<std::string>> Rest;
+    while(Reader.ReadRow(Row)){
+        Rest.push_back(Row);
+    }
+    EXPECT_EQ(Rest.size(),3);
+    EXPECT_EQ(Reader.Position().DOffset,Input.size());
+    EXPECT_EQ(Reader.Position().DRow,5);
+
+    // back within what the reader has already taken from the source
+    EXPECT_TRUE(Reader.Seek(Checkpoint));
+    EXPECT_EQ(Reader.Position().DRow,2);
+    std::vector<std::string_view> View;
+    EXPECT_TRUE(Reader.ReadRowView(View));
+    EXPECT_EQ(View,std::vector<std::string_view>({"2","b"}));
+
+    // resuming with new readers, seeking the source or reading forward
+    for(bool Seekable : {true, false}){
+        std::shared_ptr<CDataSource> Source;
+        if(Seekable){
+            Source = std::make_shared<CTrickleDataSource>(Input, 3);
+        }
+        else{
+            Source = std::make_shared<CStreamDataSource>(Input, 3);
+        }
+        CDSVReader Resumed(Source, ',');
+        EXPECT_TRUE(Resumed.Seek(Checkpoint));
+        std::vector<std::vector<std::string>> Rows;
+        while(Resumed.ReadRow(Row)){
+            Rows.push_back(Row);
+        }
+        EXPECT_EQ(Rows,Rest);
+        EXPECT_EQ(Resumed.Position().DRow,5);
+        EXPECT_EQ(Resumed.Seek(Checkpoint),Seekable);
+    }
+
+    CDSVReader PastEnd(std::make_shared<CStreamDataSource>(Input, 3), ',');
+    EXPECT_FALSE(PastEnd.Seek({Input.size() + 1, 0}));
+}
+
+TEST(DSVReaderTest, PartlyConsumedSourceTest){
+    std::string Preamble = "# exported rows\n";
+    std::string Input = Preamble + "1,a\n2,b\n3,c\n";
+    for(bool Seekable : {true, false}){
+        auto MakeSource = [&](){
+            std::shared_ptr<CDataSource> Source;
+            if(Seekable){
+                Source = std::make_shared<CTrickleDataSource>(Input, 3);
+            }
+            else{
+                Source = std::make_shared<CStreamDataSource>(Input, 3);
+            }
+            std::string Line;
+            EXPECT_TRUE(Source->ReadLine(Line));
+            return Source;
+        };
+        CDSVReader Reader(MakeSource(), ',');
+        std::vector<std::string> Row;
+        EXPECT_TRUE(Reader.ReadRow(Row));
+        auto Checkpoint = Reader.Position();
+        EXPECT_EQ(Checkpoint.DOffset,4);
+        EXPECT_TRUE(Reader.ReadRow(Row));
+        EXPECT_TRUE(Reader.ReadRow(Row));
+        EXPECT_EQ(Row,std::vector<std::string>({"3","c"}));
+
+        // positions count from the end of the preamble, not the source start
+        EXPECT_EQ(Reader.Seek(Checkpoint),Seekable);
+        if(Seekable){
+            EXPECT_TRUE(Reader.ReadRow(Row));
+            EXPECT_EQ(Row,std::vector<std::string>({"2","b"}));
+        }
+        CDSVReader Resumed(MakeSource(), ',');
+        EXPECT_TRUE(Resumed.Seek(Checkpoint));
+        EXPECT_TRUE(Resumed.ReadRow(Row));
+        EXPECT_EQ(Row,std::vector<std::string>({"2","b"}));
+        EXPECT_EQ(Resumed.Position().DRow,2);
+    }
+}
+
+TEST(DSVReaderTest, FieldOverflowTest){
+    std::string Long(100000, 'x');
+    std::string Input = "ab,cd\nlong," + Long + "\n\"q\"\"q\"\"q\",e\nlast,row";
+
+    CDSVReader Truncating(std::make_shared<CStringDataSource>(Input), ',', 3);
+    std::vector<std::vector<std::string>> Rows;
+    std::vector<std::string> Row;
+    while(Truncating.ReadRow(Row)){
+        Rows.push_back(Row);
+    }
+    EXPECT_EQ(Rows,std::vector<std::vector<std::string>>({{"ab","cd"},{"lon","xxx"},{"q\"q","e"},{"las","row"}}));
+
+    for(bool Views : {false, true}){
+        CDSVReader Skipping(std::make_shared<CStringDataSource>(Input), ',', 4, CDSVReader::EFieldOverflow::SkipRow);
+        std::vector<std::vector<std::string>> Kept;
+        std::vector<std::string_view> ViewRow;
+        while(Views ? Skipping.ReadRowView(ViewRow) : Skipping.ReadRow(Row)){
+            Kept.push_back(Views ? std::vector<std::string>(ViewRow.begin(), ViewRow.end()) : Row);
+        }
+        EXPECT_EQ(Kept,std::vector<std::vector<std::string>>({{"ab","cd"},{"last","row"}}));
+        EXPECT_EQ(Skipping.Position().DRow,4);
+        EXPECT_FALSE(Skipping.Failed());
+
+        CDSVReader Failing(std::make_shared<CStringDataSource>(Input), ',', 4, CDSVReader::EFieldOverflow::Fail);
+        EXPECT_TRUE(Views ? Failing.ReadRowView(ViewRow) : Failing.ReadRow(Row));
+        EXPECT_FALSE(Views ? Failing.ReadRowView(ViewRow) : Failing.ReadRow(Row));
+        EXPECT_TRUE(Failing.Failed());
+        EXPECT_TRUE(Failing.End());
+        EXPECT_FALSE(Failing.ReadRow(Row));
+        EXPECT_EQ(Failing.Position().DRow,2);
+        // the position after the bad row lets reading carry on past it
+        EXPECT_TRUE(Failing.Seek(Failing.Position()));
+        EXPECT_FALSE(Failing.Failed());
+        EXPECT_FALSE(Views ? Failing.ReadRowView(ViewRow) : Failing.ReadRow(Row));
+        EXPECT_TRUE(Failing.Seek(Failing.Position()));
+        EXPECT_TRUE(Views ? Failing.ReadRowView(ViewRow) : Failing.ReadRow(Row));
+        EXPECT_EQ(Failing.Position().DRow,4);
+    }
+}
+
@@ -1,8 +1,11 @@
 #include <gtest/gtest.h>
 #include "FileDataFactory.h"
+#include "CachingDataFactory.h"
 #include "FileDataSink.h"
 #include "FileDataSource.h"
 #include <cstdio>
+#include <unistd.h>
+#include <zlib.h>
 
 // Assume being run from Makefile so testtmp is subdirectory
 
@@ -55,3 +58,305 @@ TEST(FileDataSourceSink, WriteTest){
     EXPECT_EQ(InBuffer,OutBuffer);
     EXPECT_TRUE(Source->End());
 }
+
+TEST(FileDataSourceSink, MissingFileTest){
+    CFileDataFactory DataFactory(BaseDirectory);
+    std::string Filename = "missing.txt";
+    std::remove((BaseDirectory + Filename).c_str());
+    auto Source = DataFactory.CreateSource(Filename);
+    std::vector<char> InBuffer;
+    std::span<const char> Span;
+    char TempCh = 'x';
+
+    EXPECT_TRUE(Source->End());
+    EXPECT_FALSE(Source->Get(TempCh));
+    EXPECT_FALSE(Source->Peek(TempCh));
+    EXPECT_EQ(TempCh,'x');
+    EXPECT_FALSE(Source->Read(InBuffer,4));
+    EXPECT_FALSE(Source->Borrow(Span,4));
+}
+
+TEST(FileDataSourceSink, BorrowTest){
+    CFileDataFactory DataFactory(BaseDirectory);
+    std::string Filename = "borrow.txt";
+    std::remove((BaseDirectory + Filename).c_str());
+    std::string Contents = "Hello World";
+    {
+        auto Sink = DataFactory.CreateSink(Filename);
+        EXPECT_TRUE(Sink->Write(std::vector<char>(Contents.begin(),Contents.end())));
+    }
+    auto Source = DataFactory.CreateSource(Filename);
+    std::span<const char> Span;
+    char TempCh;
+
+    EXPECT_TRUE(Source->Borrow(Span,5));
+    EXPECT_EQ(std::string(Span.data(),Span.size()),"Hello");
+    EXPECT_TRUE(Source->Peek(TempCh));
+    EXPECT_EQ(TempCh,' ');
+    EXPECT_TRUE(Source->Get(TempCh));
+    EXPECT_TRUE(Source->Borrow(Span,100));
+    EXPECT_EQ(std::string(Span.data(),Span.size()),"World");
+    EXPECT_TRUE(Source->End());
+    EXPECT_FALSE(Source->Borrow(Span,1));
+}
+
+TEST(FileDataSourceSink, RewriteMappedFileTest){
+    CFileDataFactory DataFactory(BaseDirectory);
+    std::string Filename = "rewrite.txt";
+    std::string Contents(100000,'a');
+    {
+        CFileDataSink Sink(BaseDirectory + Filename);
+        EXPECT_TRUE(Sink.WriteString(Contents));
+    }
+    auto Source = DataFactory.CreateSource(Filename);
+    std::span<const char> Span;
+    EXPECT_TRUE(Source->Borrow(Span,10));
+    {
+        CFileDataSink Sink(BaseDirectory + Filename, CFileDataSink::DefaultBufferSize, CFileDataSink::EOpenMode::Replace);
+        EXPECT_FALSE(Sink.Failed());
+        EXPECT_TRUE(Sink.WriteString("b"));
+        EXPECT_TRUE(Sink.Flush());
+    }
+    std::vector<char> InBuffer;
+    EXPECT_TRUE(Source->Read(InBuffer,Contents.size()));
+    EXPECT_EQ(std::string(InBuffer.begin(),InBuffer.end()),Contents.substr(10));
+    auto Rewritten = DataFactory.CreateSource(Filename);
+    EXPECT_TRUE(Rewritten->Read(InBuffer,10));
+    EXPECT_EQ(std::string(InBuffer.begin(),InBuffer.end()),"b");
+
+    // Truncate keeps the inode, so other links see the new contents
+    std::string Link = BaseDirectory + "rewrite_link.txt";
+    std::remove(Link.c_str());
+    ASSERT_EQ(link((BaseDirectory + Filename).c_str(),Link.c_str()),0);
+    {
+        CFileDataSink Sink(BaseDirectory + Filename);
+        EXPECT_TRUE(Sink.WriteString("c"));
+    }
+    auto Linked = DataFactory.CreateSource("rewrite_link.txt");
+    EXPECT_TRUE(Linked->Read(InBuffer,10));
+    EXPECT_EQ(std::string(InBuffer.begin(),InBuffer.end()),"c");
+
+    // a failed replace leaves the old file alone
+    CFileDataSink Missing(BaseDirectory + "nodir/rewrite.txt", CFileDataSink::DefaultBufferSize, CFileDataSink::EOpenMode::Replace);
+    EXPECT_TRUE(Missing.Failed());
+}
+
+TEST(FileDataSourceSink, BufferedSinkTest){
+    std::string Filename = BaseDirectory + "buffered.txt";
+    std::remove(Filename.c_str());
+    std::string Contents;
+    for(int Index = 0; Index < 100; Index++){
+        Contents += std::to_string(Index) + ",";
+    }
+    CFileDataFactory DataFactory(BaseDirectory);
+    for(std::size_t BufferSize : {0, 1, 7, 64, 4096}){
+        {
+            CFileDataSink Sink(Filename,BufferSize);
+            for(std::size_t Index = 0; Index < Contents.size(); Index += 10){
+                EXPECT_TRUE(Sink.Put(Contents[Index]));
+                EXPECT_TRUE(Sink.WriteString(std::string_view(Contents).substr(Index + 1,9)));
+            }
+            EXPECT_TRUE(Sink.Flush());
+            auto Source = DataFactory.CreateSource("buffered.txt");
+            std::vector<char> InBuffer;
+            EXPECT_TRUE(Source->Read(InBuffer,Contents.size() + 1));
+            EXPECT_EQ(std::string(InBuffer.begin(),InBuffer.end()),Contents);
+            EXPECT_TRUE(Sink.Put('!'));
+        }
+        auto Source = DataFactory.CreateSource("buffered.txt");
+        std::vector<char> InBuffer;
+        EXPECT_TRUE(Source->Read(InBuffer,Contents.size() + 1));
+        EXPECT_EQ(std::string(InBuffer.begin(),InBuffer.end()),Contents + "!");
+    }
+}
+
+TEST(FileDataSourceSink, FailedSinkTest){
+    CFileDataSink Good(BaseDirectory + "failed.txt",4);
+    EXPECT_TRUE(Good.WriteString("Hello World"));
+    EXPECT_TRUE(Good.Flush());
+    EXPECT_FALSE(Good.Failed());
+
+    CFileDataSink Missing(BaseDirectory + "nodir/failed.txt");
+    EXPECT_TRUE(Missing.Failed());
+    EXPECT_FALSE(Missing.Put('x'));
+
+    // Every write to /dev/full fails, the buffered bytes only fail on flush
+    CFileDataSink Full("/dev/full",16);
+    EXPECT_FALSE(Full.Failed());
+    EXPECT_TRUE(Full.WriteString("Hello"));
+    EXPECT_FALSE(Full.Failed());
+    EXPECT_FALSE(Full.Flush());
+    EXPECT_TRUE(Full.Failed());
+    EXPECT_TRUE(Full.Flush());
+    EXPECT_TRUE(Full.Failed());
+}
+
+TEST(FileDataSourceSink, CompressedSourceTest){
+    CFileDataFactory DataFactory(BaseDirectory);
+    std::string Contents;
+    for(int Index = 0; Index < 10000; Index++){
+        Contents += "stop_id,node_id\n" + std::to_string(Index) + "\n";
+    }
+    for(std::string Filename : {"compressed.csv.gz", "compressed.csv"}){
+        std::remove((BaseDirectory + Filename).c_str());
+        gzFile File = gzopen((BaseDirectory + Filename).c_str(), "wb");
+        ASSERT_TRUE(File);
+        gzwrite(File, Contents.data(), Contents.size());
+        gzclose(File);
+
+        auto Source = DataFactory.CreateSource(Filename);
+        std::vector<char> InBuffer;
+        std::string Actual;
+        while(Source->Read(InBuffer,4096)){
+            Actual.append(InBuffer.begin(),InBuffer.end());
+        }
+        EXPECT_EQ(Actual,Contents);
+        EXPECT_TRUE(Source->End());
+        EXPECT_FALSE(Source->Failed());
+    }
+}
+
+TEST(FileDataSourceSink, TruncatedCompressedSourceTest){
+    CFileDataFactory DataFactory(BaseDirectory);
+    std::string Filename = "truncated.csv.gz";
+    std::string Contents;
+    for(int Index = 0; Index < 10000; Index++){
+        Contents += std::to_string(Index * 7919) + "," + std::to_string(Index) + "\n";
+    }
+    std::remove((BaseDirectory + Filename).c_str());
+    gzFile File = gzopen((BaseDirectory + Filename).c_str(), "wb");
+    ASSERT_TRUE(File);
+    gzwrite(File, Contents.data(), Contents.size());
+    gzclose(File);
+
+    // Cut the compressed stream in half
+    std::vector<char> Compressed;
+    {
+        CFileDataSource Whole(BaseDirectory + Filename);
+        std::vector<char> Buffer;
+        while(Whole.Read(Buffer,4096)){
+            Compressed.insert(Compressed.end(),Buffer.begin(),Buffer.end());
+        }
+    }
+    ASSERT_GT(Compressed.size(),100);
+    std::remove((BaseDirectory + Filename).c_str());
+    {
+        CFileDataSink Sink(BaseDirectory + Filename);
+        EXPECT_TRUE(Sink.WriteSpan(std::span<const char>(Compressed.data(),Compressed.size() / 2)));
+    }
+
+    auto Source = DataFactory.CreateSource(Filename);
+    std::vector<char> InBuffer;
+    std::string Actual;
+    while(Source->Read(InBuffer,4096)){
+        Actual.append(InBuffer.begin(),InBuffer.end());
+    }
+    EXPECT_TRUE(Source->End());
+    EXPECT_LT(Actual.size(),Contents.size());
+    EXPECT_TRUE(Source->Failed());
+
+    auto Concatenated = DataFactory.CreateConcatenatedSource({Filename});
+    while(Concatenated->Read(InBuffer,4096)){
+    }
+    EXPECT_TRUE(Concatenated->Failed());
+}
+
+TEST(FileDataSourceSink, CachingFactoryTest){
+    CCachingDataFactory DataFactory(BaseDirectory);
+    std::string Filename = "cached.txt";
+    std::remove((BaseDirectory + Filename).c_str());
+    EXPECT_TRUE(DataFactory.CreateSource(Filename)->End());
+    EXPECT_EQ(DataFactory.CachedCount(),0);
+    {
+        auto Sink = DataFactory.CreateSink(Filename);
+        EXPECT_TRUE(Sink->WriteString("Hello World"));
+    }
+    auto Source1 = DataFactory.CreateSource(Filename);
+    auto Source2 = DataFactory.CreateSource(Filename);
+    EXPECT_EQ(DataFactory.CachedCount(),1);
+    std::span<const char> Span1, Span2;
+    char TempCh;
+
+    // Both cursors lend out the very same bytes but move independently
+    EXPECT_TRUE(Source1->Borrow(Span1,5));
+    EXPECT_TRUE(Source2->Get(TempCh));
+    EXPECT_EQ(TempCh,'H');
+    EXPECT_TRUE(Source2->Borrow(Span2,4));
+    EXPECT_EQ(Span1.data() + 1,Span2.data());
+    EXPECT_EQ(std::string(Span1.data(),Span1.size()),"Hello");
+
+    // Rewriting the file leaves outstanding cursors on the old contents
+    {
+        auto Sink = DataFactory.CreateSink(Filename);
+        EXPECT_TRUE(Sink->WriteString("Goodbye"));
+    }
+    EXPECT_EQ(DataFactory.CachedCount(),0);
+    std::vector<char> InBuffer;
+    EXPECT_TRUE(Source1->Read(InBuffer,100));
+    EXPECT_EQ(std::string(InBuffer.begin(),InBuffer.end())," World");
+    auto Source3 = DataFactory.CreateSource(Filename);
+    EXPECT_TRUE(Source3->Read(InBuffer,100));
+    EXPECT_EQ(std::string(InBuffer.begin(),InBuffer.end()),"Goodbye");
+    DataFactory.Clear();
+    EXPECT_EQ(DataFactory.CachedCount(),0);
+}
+
+TEST(FileDataSourceSink, ShardedSourceTest){
+    CCachingDataFactory DataFactory(BaseDirectory);
+    std::string Filename = "sharded.csv";
+    std::string Contents;
+    for(int Index = 0; Index < 100; Index++){
+        Contents += std::to_string(Index) + ",stop " + std::to_string(Index * 7) + "\n";
+    }
+    std::remove((BaseDirectory + Filename).c_str());
+    {
+        auto Sink = DataFactory.CreateSink(Filename);
+        EXPECT_TRUE(Sink->WriteString(Contents));
+    }
+    for(std::size_t Count : {1, 3, 8, 1000}){
+        auto Shards = DataFactory.CreateShardedSources(Filename, Count);
+        EXPECT_LE(Shards.size(),std::min<std::size_t>(Count, 100));
+        std::string Joined;
+        for(auto &Shard : Shards){
+            std::vector<char> InBuffer;
+            EXPECT_TRUE(Shard->Read(InBuffer, Contents.size()));
+            std::string Text(InBuffer.begin(), InBuffer.end());
+            // Every shard holds whole records
+            EXPECT_EQ(Text.back(),'\n');
+            EXPECT_TRUE(Shard->End());
+            Joined += Text;
+        }
+        EXPECT_EQ(Joined,Contents);
+    }
+    EXPECT_EQ(DataFactory.CachedCount(),1);
+    auto File = std::make_shared<CMappedFile>(BaseDirectory + Filename);
+    CFileDataSource Range(File, 2, 7);
+    CFileDataSource PastEnd(File, Contents.size() + 10, 7);
+    std::vector<char> InBuffer;
+    EXPECT_TRUE(Range.Read(InBuffer, 100));
+    EXPECT_EQ(std::string(InBuffer.begin(), InBuffer.end()),"stop 0\n");
+    EXPECT_TRUE(PastEnd.End());
+    // seeking is relative to the start of the range
+    EXPECT_TRUE(Range.Seek(1));
+    EXPECT_TRUE(Range.Read(InBuffer, 100));
+    EXPECT_EQ(std::string(InBuffer.begin(), InBuffer.end()),"top 0\n");
+    EXPECT_FALSE(Range.Seek(8));
+    EXPECT_TRUE(Range.End());
+}
+
+TEST(FileDataSourceSink, ConcatenatedSourceTest){
+    CFileDataFactory DataFactory(BaseDirectory);
+    {
+        auto Sink = DataFactory.CreateSink("agency1.csv");
+        EXPECT_TRUE(Sink->WriteString("stop_id,node_id\n1,10\n2,20"));
+    }
+    {
+        auto Sink = DataFactory.CreateSink("agency2.csv");
+        EXPECT_TRUE(Sink->WriteString("stop_id,node_id\n3,30\n"));
+    }
+    auto Source = DataFactory.CreateConcatenatedSource({"agency1.csv", "agency2.csv"}, true);
+    std::vector<char> InBuffer;
+    EXPECT_TRUE(Source->Read(InBuffer, 100));
+    EXPECT_EQ(std::string(InBuffer.begin(), InBuffer.end()),"stop_id,node_id\n1,10\n2,20\n3,30\n");
+    EXPECT_TRUE(Source->End());
+}
@@ -0,0 +1,60 @@
+#include <gtest/gtest.h>
+#include "FlatIDIndex.h"
+#include <random>
+#include <vector>
+
+TEST(FlatIDIndex, EmptyTest){
+    CFlatIDIndex Default;
+    EXPECT_EQ(Default.Size(),0);
+    EXPECT_EQ(Default.Find(0),CFlatIDIndex::InvalidPosition);
+
+    CFlatIDIndex Empty(std::vector<uint64_t>{});
+    EXPECT_EQ(Empty.Size(),0);
+    EXPECT_EQ(Empty.Find(1),CFlatIDIndex::InvalidPosition);
+    EXPECT_TRUE(CFlatIDIndex::Valid(Empty.IDs(),Empty.Positions(),0));
+    EXPECT_FALSE(CFlatIDIndex::Valid(Empty.IDs(),Empty.Positions(),1));
+
+    // a single slot is never built but may be read from a file
+    std::vector<uint64_t> OneID = {CFlatIDIndex::EmptyID};
+    std::vector<uint32_t> OnePosition = {CFlatIDIndex::InvalidPosition};
+    EXPECT_FALSE(CFlatIDIndex::Valid(OneID,OnePosition,0));
+    EXPECT_EQ(CFlatIDIndex::Find(OneID,OnePosition,1),CFlatIDIndex::InvalidPosition);
+}
+
+TEST(FlatIDIndex, EverySizeTest){
+    // Runs of close IDs, as OSM has, in descending order
+    for(std::size_t Count = 1; Count < 70; Count++){
+        std::vector<uint64_t> IDs;
+        for(std::size_t Index = 0; Index < Count; Index++){
+            IDs.push_back((Count - Index) * 2 + 5);
+        }
+        CFlatIDIndex Index(IDs);
+        ASSERT_EQ(Index.Size(),Count);
+        EXPECT_TRUE(CFlatIDIndex::Valid(Index.IDs(),Index.Positions(),Count));
+        EXPECT_FALSE(CFlatIDIndex::Valid(Index.IDs(),Index.Positions(),Count - 1));
+        for(std::size_t Position = 0; Position < Count; Position++){
+            EXPECT_EQ(Index.Find(IDs[Position]),Position);
+            EXPECT_EQ(Index.Find(IDs[Position] + 1),CFlatIDIndex::InvalidPosition);
+        }
+        EXPECT_EQ(Index.Find(0),CFlatIDIndex::InvalidPosition);
+        EXPECT_EQ(Index.Find(std::numeric_limits<uint64_t>::max()),CFlatIDIndex::InvalidPosition);
+    }
+}
+
+TEST(FlatIDIndex, SparseIDsTest){
+    std::mt19937_64 Generator(42);
+    std::vector<uint64_t> IDs = {0, std::numeric_limits<uint64_t>::max()};
+    for(std::size_t Index = 0; Index < 5000; Index++){
+        IDs.push_back(Generator() >> 1);
+    }
+    CFlatIDIndex Index(IDs);
+    for(std::size_t Position = 0; Position < IDs.size(); Position++){
+        ASSERT_EQ(Index.Find(IDs[Position]),Position);
+    }
+    for(std::size_t Count = 0; Count < 5000; Count++){
+        ASSERT_EQ(Index.Find((Generator() >> 1) | 1),CFlatIDIndex::InvalidPosition);
+    }
+    // the arrays alone are enough to search
+    EXPECT_EQ(CFlatIDIndex::Find(Index.IDs(),Index.Positions(),IDs[100]),100);
+    EXPECT_EQ(CFlatIDIndex::Find(Index.IDs(),Index.Positions(),IDs[100] + 1),CFlatIDIndex::InvalidPosition);
+}
@@ -0,0 +1,116 @@
+#include <gtest/gtest.h>
+#include "GzipDataSource.h"
+#include "StringDataSource.h"
+#include <zlib.h>
+
+namespace{
+    std::string Compress(const std::string &data){
+        z_stream Stream = {};
+        std::string Result(compressBound(data.size()) + 32, '\0');
+        // 15 window bits + 16 writes a gzip header rather than a zlib one
+        deflateInit2(&Stream, Z_BEST_SPEED, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY);
+        Stream.next_in = reinterpret_cast<Bytef *>(const_cast<char *>(data.data()));
+        Stream.avail_in = data.size();
+        Stream.next_out = reinterpret_cast<Bytef *>(Result.data());
+        Stream.avail_out = Result.size();
+        deflate(&Stream, Z_FINISH);
+        Result.resize(Stream.total_out);
+        deflateEnd(&Stream);
+        return Result;
+    }
+
+    std::string TestString(std::size_t length){
+        std::string Result;
+        for(std::size_t Index = 0; Index < length; Index++){
+            Result += std::to_string(Index % 97) + (Index % 13 ? "," : "\n");
+        }
+        return Result;
+    }
+}
+
+TEST(GzipDataSource, EmptyTest){
+    CGzipDataSource Source(std::make_shared<CStringDataSource>(Compress("")));
+    char TempCh = 'x';
+
+    EXPECT_TRUE(Source.End());
+    EXPECT_FALSE(Source.Get(TempCh));
+    EXPECT_EQ(TempCh,'x');
+    EXPECT_FALSE(Source.Failed());
+}
+
+TEST(GzipDataSource, GetPeekTest){
+    CGzipDataSource Source(std::make_shared<CStringDataSource>(Compress("Hello")));
+    char TempCh;
+
+    EXPECT_FALSE(Source.End());
+    EXPECT_TRUE(Source.Peek(TempCh));
+    EXPECT_EQ(TempCh,'H');
+    EXPECT_TRUE(Source.Get(TempCh));
+    EXPECT_EQ(TempCh,'H');
+    EXPECT_TRUE(Source.Get(TempCh));
+    EXPECT_EQ(TempCh,'e');
+    std::vector<char> TempVector;
+    EXPECT_TRUE(Source.Read(TempVector,10));
+    EXPECT_EQ(std::string(TempVector.begin(),TempVector.end()),"llo");
+    EXPECT_TRUE(Source.End());
+}
+
+TEST(GzipDataSource, SmallBlockTest){
+    std::string Expected = TestString(20000);
+    CGzipDataSource Source(std::make_shared<CStringDataSource>(Compress(Expected)),13);
+    std::string Actual;
+    char Buffer[100];
+    std::size_t Length;
+
+    while((Length = Source.ReadSpan(Buffer))){
+        Actual.append(Buffer,Length);
+    }
+    EXPECT_EQ(Actual,Expected);
+    EXPECT_FALSE(Source.Failed());
+}
+
+TEST(GzipDataSource, BorrowSurvivesEndTest){
+    std::string Expected = TestString(5000);
+    CGzipDataSource Source(std::make_shared<CStringDataSource>(Compress(Expected)),64);
+    std::span<const char> Span;
+    std::string Actual;
+
+    // each view takes a whole block, so End() has to inflate the next one
+    while(Source.Borrow(Span,64)){
+        std::string Lent(Span.data(),Span.size());
+        bool AtEnd = Source.End();
+        EXPECT_EQ(std::string(Span.data(),Span.size()),Lent);
+        Actual += Lent;
+        EXPECT_EQ(AtEnd,Actual.size() == Expected.size());
+    }
+    EXPECT_EQ(Actual,Expected);
+    EXPECT_FALSE(Source.Failed());
+}
+
+TEST(GzipDataSource, ConcatenatedMemberTest){
+    CGzipDataSource Source(std::make_shared<CStringDataSource>(Compress("Hello ") + Compress("World")));
+    std::span<const char> Span;
+    std::string Actual;
+
+    while(Source.Borrow(Span,4)){
+        EXPECT_LE(Span.size(),4);
+        Actual.append(Span.data(),Span.size());
+    }
+    EXPECT_EQ(Actual,"Hello World");
+    EXPECT_FALSE(Source.Failed());
+}
+
+TEST(GzipDataSource, CorruptTest){
+    std::string Compressed = Compress(TestString(1000));
+    CGzipDataSource Truncated(std::make_shared<CStringDataSource>(Compressed.substr(0,Compressed.size() / 2)));
+    std::vector<char> TempVector;
+
+    while(Truncated.Read(TempVector,100)){
+    }
+    EXPECT_TRUE(Truncated.End());
+    EXPECT_TRUE(Truncated.Failed());
+
+    CGzipDataSource Garbage(std::make_shared<CStringDataSource>("not compressed at all"));
+    EXPECT_TRUE(Garbage.End());
+    EXPECT_TRUE(Garbage.Failed());
+}
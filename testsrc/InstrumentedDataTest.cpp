@@ -0,0 +1,59 @@
+#include <gtest/gtest.h>
+#include "InstrumentedDataSource.h"
+#include "InstrumentedDataSink.h"
+#include "StringDataSource.h"
+#include "StringDataSink.h"
+
+TEST(InstrumentedDataSource, CountTest){
+    CInstrumentedDataSource Source(std::make_shared<CStringDataSource>("Hello World"));
+    std::vector<char> TempVector;
+    char Buffer[3];
+    char TempCh;
+
+    EXPECT_EQ(Source.Statistics().Calls(),0);
+    EXPECT_TRUE(Source.Peek(TempCh));
+    EXPECT_EQ(TempCh,'H');
+    EXPECT_TRUE(Source.Get(TempCh));
+    EXPECT_TRUE(Source.Read(TempVector,4));
+    EXPECT_EQ(std::string(TempVector.begin(),TempVector.end()),"ello");
+    EXPECT_EQ(Source.ReadSpan(Buffer),3);
+    EXPECT_EQ(std::string(Buffer,3)," Wo");
+    EXPECT_FALSE(Source.End());
+
+    auto &Statistics = Source.Statistics();
+    EXPECT_EQ(Statistics.DGetCalls,1);
+    EXPECT_EQ(Statistics.DPeekCalls,1);
+    EXPECT_EQ(Statistics.DReadCalls,2);
+    EXPECT_EQ(Statistics.DBytes,8);
+    EXPECT_EQ(Statistics.Calls(),4);
+    EXPECT_GT(Statistics.DDuration.count(),0);
+    EXPECT_NE(Statistics.ToString().find("bytes=8"),std::string::npos);
+
+    Source.ResetStatistics();
+    EXPECT_EQ(Source.Statistics().Calls(),0);
+    EXPECT_EQ(Source.Statistics().DBytes,0);
+    // Failed calls count but move no bytes
+    EXPECT_EQ(Source.ReadSpan(Buffer),3);
+    EXPECT_FALSE(Source.Get(TempCh));
+    EXPECT_EQ(Source.Statistics().DGetCalls,1);
+    EXPECT_EQ(Source.Statistics().DBytes,3);
+}
+
+TEST(InstrumentedDataSink, CountTest){
+    auto StringSink = std::make_shared<CStringDataSink>();
+    CInstrumentedDataSink Sink(StringSink);
+
+    EXPECT_TRUE(Sink.Put('H'));
+    EXPECT_TRUE(Sink.WriteString("ello"));
+    EXPECT_TRUE(Sink.Write(std::vector<char>{' ','W'}));
+    EXPECT_TRUE(Sink.Flush());
+    EXPECT_EQ(StringSink->String(),"Hello W");
+
+    auto &Statistics = Sink.Statistics();
+    EXPECT_EQ(Statistics.DPutCalls,1);
+    EXPECT_EQ(Statistics.DWriteCalls,2);
+    EXPECT_EQ(Statistics.DFlushCalls,1);
+    EXPECT_EQ(Statistics.DBytes,7);
+    Sink.ResetStatistics();
+    EXPECT_EQ(Sink.Statistics().Calls(),0);
+}
@@ -132,4 +132,36 @@ TEST(KMLWriterTest, PathTest){
                                     "    </Placemark>\n"
                                     "  </Document>\n"
                                     "</kml>");
-}
\ No newline at end of file
+}
+
+TEST(KMLWriterTest, MinifiedTest){
+    auto OutStream = std::make_shared<CStringDataSink>();
+    {
+        CKMLWriter KMLWriter(OutStream,"Path","Path KML test",CXMLWriter::EFormat::Minified);
+        EXPECT_TRUE(KMLWriter.CreateLineStyle("LineStyleID",0xff123456,4));
+        EXPECT_TRUE(KMLWriter.CreatePath("PathName","LineStyleID",{{38.5,-121.7},{38.6,-121.8}}));
+    }
+    
+    EXPECT_EQ(OutStream->String(),  "<?xml version='1.0' encoding='UTF-8'?>"
+                                    "<kml xmlns=\"http://www.opengis.net/kml/2.2\">"
+                                    "<Document>"
+                                    "<name>Path</name>"
+                                    "<description>Path KML test</description>"
+                                    "<Style id=\"LineStyleID\">"
+                                    "<LineStyle>"
+                                    "<color>ff123456</color>"
+                                    "<width>4</width>"
+                                    "</LineStyle>"
+                                    "</Style>"
+                                    "<Placemark>"
+                                    "<name>PathName</name>"
+                                    "<styleUrl>#LineStyleID</styleUrl>"
+                                    "<LineString>"
+                                    "<tessellate>1</tessellate>"
+                                    "<altitudeMode>relativeToGround</altitudeMode>"
+                                    "<coordinates>-121.700000,38.500000 -121.800000,38.600000</coordinates>"
+                                    "</LineString>"
+                                    "</Placemark>"
+                                    "</Document>"
+                                    "</kml>");
+}
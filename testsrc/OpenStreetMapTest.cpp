@@ -1,5 +1,7 @@
 #include <gtest/gtest.h>
 
+#include <fstream>
+
 #include "StringDataSource.h"
 #include "XMLReader.h"
 #include "OpenStreetMap.h"
@@ -36,8 +38,8 @@ TEST(OpenStreetMapTest, SingleNodeByIndexAndID)
     EXPECT_EQ(Node0->ID(), 1ULL);
 
     auto Loc = Node0->Location();
-    EXPECT_DOUBLE_EQ(Loc.first, 38.5);    // lat
-    EXPECT_DOUBLE_EQ(Loc.second, -121.7); // lon
+    EXPECT_DOUBLE_EQ(Loc.DLatitude, 38.5);    // lat
+    EXPECT_DOUBLE_EQ(Loc.DLongitude, -121.7); // lon
 }
 
 TEST(OpenStreetMapTest, EmptyMapCounts)
@@ -197,8 +199,8 @@ TEST(OpenStreetMapTest, InvalidNodeInputsAreSkipped)
     ASSERT_NE(Node, nullptr);
 
     auto Loc = Node->Location();
-    EXPECT_DOUBLE_EQ(Loc.first, 38.5);
-    EXPECT_DOUBLE_EQ(Loc.second, -121.7);
+    EXPECT_DOUBLE_EQ(Loc.DLatitude, 38.5);
+    EXPECT_DOUBLE_EQ(Loc.DLongitude, -121.7);
 }
 
 TEST(OpenStreetMapTest, InvalidWayInputsAreSkipped)
@@ -255,3 +257,119 @@ TEST(OpenStreetMapTest, MalformedNdRefIsIgnored)
     EXPECT_EQ(Way->GetNodeID(0), 123ULL);
     EXPECT_EQ(Way->GetAttribute("highway"), "residential");
 }
+
+TEST(OpenStreetMapTest, InterleavedTagsAndRefs)
+{
+    std::string XML =
+        "<osm version=\"0.6\">"
+        "  <node id=\"1\" lat=\"38.5\" lon=\"-121.7\">"
+        "    <tag k=\"name\" v=\"First\"/>"
+        "  </node>"
+        "  <node id=\"2\" lat=\"38.6\" lon=\"-121.8\"/>"
+        "  <node id=\"3\" lat=\"38.7\" lon=\"-121.9\">"
+        "    <tag k=\"name\" v=\"Third\"/>"
+        "    <tag k=\"highway\" v=\"stop\"/>"
+        "  </node>"
+        "  <tag k=\"name\" v=\"Outside\"/>"
+        "  <way id=\"10\">"
+        "    <nd ref=\"1\"/>"
+        "    <tag k=\"name\" v=\"Way\"/>"
+        "    <nd ref=\"2\"/>"
+        "  </way>"
+        "  <way id=\"11\"/>"
+        "  <way id=\"12\">"
+        "    <nd ref=\"3\"/>"
+        "  </way>"
+        "</osm>";
+
+    auto Map = BuildMapFromXML(XML);
+
+    ASSERT_EQ(Map->NodeCount(), 3U);
+    ASSERT_EQ(Map->WayCount(), 3U);
+
+    EXPECT_EQ(Map->NodeByID(1ULL)->GetAttribute("name"), "First");
+    EXPECT_EQ(Map->NodeByID(2ULL)->AttributeCount(), 0U);
+    EXPECT_FALSE(Map->NodeByID(2ULL)->HasAttribute("name"));
+    EXPECT_EQ(Map->NodeByID(3ULL)->AttributeCount(), 2U);
+    EXPECT_EQ(Map->NodeByID(3ULL)->GetAttribute("name"), "Third");
+    EXPECT_EQ(Map->NodeByID(3ULL)->GetAttributeKey(1), "highway");
+
+    auto Way = Map->WayByID(10ULL);
+    ASSERT_EQ(Way->NodeCount(), 2U);
+    EXPECT_EQ(Way->GetNodeID(0), 1ULL);
+    EXPECT_EQ(Way->GetNodeID(1), 2ULL);
+    EXPECT_EQ(Way->GetAttribute("name"), "Way");
+    EXPECT_EQ(Map->WayByID(11ULL)->NodeCount(), 0U);
+    EXPECT_EQ(Map->WayByID(11ULL)->AttributeCount(), 0U);
+    ASSERT_EQ(Map->WayByID(12ULL)->NodeCount(), 1U);
+    EXPECT_EQ(Map->WayByID(12ULL)->GetNodeID(0), 3ULL);
+}
+
+TEST(OpenStreetMapTest, ElementsOutliveMap)
+{
+    std::string XML =
+        "<osm version=\"0.6\">"
+        "  <node id=\"1\" lat=\"38.5\" lon=\"-121.7\">"
+        "    <tag k=\"name\" v=\"Test Stop\"/>"
+        "  </node>"
+        "  <way id=\"10\">"
+        "    <nd ref=\"1\"/>"
+        "  </way>"
+        "</osm>";
+
+    auto Map = BuildMapFromXML(XML);
+
+    // handles are made on request, so the same element looked up twice
+    // gives two handles onto the same data
+    EXPECT_NE(Map->NodeByIndex(0), Map->NodeByID(1ULL));
+    EXPECT_EQ(Map->NodeByIndex(0)->ID(), Map->NodeByID(1ULL)->ID());
+    EXPECT_EQ(Map->WayByIndex(0)->ID(), Map->WayByID(10ULL)->ID());
+
+    auto Node = Map->NodeByID(1ULL);
+    auto Way = Map->WayByID(10ULL);
+    Map.reset();
+    EXPECT_EQ(Node->ID(), 1ULL);
+    EXPECT_EQ(Node->GetAttribute("name"), "Test Stop");
+    EXPECT_EQ(Way->GetNodeID(0), 1ULL);
+}
+
+TEST(OpenStreetMapTest, ParsersBuildSameMap)
+{
+    std::ifstream File("./data/davis.osm");
+    std::string Contents((std::istreambuf_iterator<char>(File)), std::istreambuf_iterator<char>());
+    ASSERT_FALSE(Contents.empty());
+
+    COpenStreetMap ExpatMap(std::make_shared<CXMLReader>(std::make_shared<CStringDataSource>(Contents)));
+    COpenStreetMap NativeMap(std::make_shared<CXMLReader>(std::make_shared<CStringDataSource>(Contents), CXMLReader::EParser::Native));
+
+    ASSERT_GT(ExpatMap.NodeCount(), 1000U);
+    ASSERT_GT(ExpatMap.WayCount(), 100U);
+    ASSERT_EQ(ExpatMap.NodeCount(), NativeMap.NodeCount());
+    ASSERT_EQ(ExpatMap.WayCount(), NativeMap.WayCount());
+    for (std::size_t Index = 0; Index < ExpatMap.NodeCount(); Index++)
+    {
+        auto Expected = ExpatMap.NodeByIndex(Index);
+        auto Actual = NativeMap.NodeByIndex(Index);
+        ASSERT_EQ(Expected->ID(), Actual->ID());
+        EXPECT_EQ(Expected->Location(), Actual->Location());
+        ASSERT_EQ(Expected->AttributeCount(), Actual->AttributeCount());
+        for (std::size_t Attribute = 0; Attribute < Expected->AttributeCount(); Attribute++)
+        {
+            auto Key = Expected->GetAttributeKey(Attribute);
+            EXPECT_EQ(Key, Actual->GetAttributeKey(Attribute));
+            EXPECT_EQ(Expected->GetAttribute(Key), Actual->GetAttribute(Key));
+        }
+    }
+    for (std::size_t Index = 0; Index < ExpatMap.WayCount(); Index++)
+    {
+        auto Expected = ExpatMap.WayByIndex(Index);
+        auto Actual = NativeMap.WayByIndex(Index);
+        ASSERT_EQ(Expected->ID(), Actual->ID());
+        ASSERT_EQ(Expected->NodeCount(), Actual->NodeCount());
+        for (std::size_t Node = 0; Node < Expected->NodeCount(); Node++)
+        {
+            EXPECT_EQ(Expected->GetNodeID(Node), Actual->GetNodeID(Node));
+        }
+        EXPECT_EQ(Expected->AttributeCount(), Actual->AttributeCount());
+    }
+}
@@ -0,0 +1,103 @@
+#include <gtest/gtest.h>
+#include "ReadAheadDataSource.h"
+#include "StringDataSource.h"
+
+namespace{
+    std::string TestString(std::size_t length){
+        std::string Result;
+        for(std::size_t Index = 0; Index < length; Index++){
+            Result += char('a' + Index % 26);
+        }
+        return Result;
+    }
+}
+
+TEST(ReadAheadDataSource, EmptyTest){
+    CReadAheadDataSource Source(std::make_shared<CStringDataSource>(""));
+    std::vector<char> TempVector;
+    std::span<const char> Span;
+    char TempCh = 'x';
+
+    EXPECT_TRUE(Source.End());
+    EXPECT_FALSE(Source.Peek(TempCh));
+    EXPECT_FALSE(Source.Get(TempCh));
+    EXPECT_EQ(TempCh,'x');
+    EXPECT_FALSE(Source.Read(TempVector,4));
+    EXPECT_FALSE(Source.Borrow(Span,4));
+}
+
+TEST(ReadAheadDataSource, GetPeekTest){
+    std::string Expected = TestString(1000);
+    CReadAheadDataSource Source(std::make_shared<CStringDataSource>(Expected),7,3);
+    std::string Actual;
+    char TempCh, PeekCh;
+
+    while(!Source.End()){
+        EXPECT_TRUE(Source.Peek(PeekCh));
+        EXPECT_TRUE(Source.Get(TempCh));
+        EXPECT_EQ(PeekCh,TempCh);
+        Actual += TempCh;
+    }
+    EXPECT_EQ(Actual,Expected);
+    EXPECT_FALSE(Source.Get(TempCh));
+}
+
+TEST(ReadAheadDataSource, ReadTest){
+    std::string Expected = TestString(10000);
+    CReadAheadDataSource Source(std::make_shared<CStringDataSource>(Expected),64,2);
+    std::vector<char> TempVector;
+    std::string Actual;
+
+    while(Source.Read(TempVector,100)){
+        EXPECT_TRUE(TempVector.size() == 100 || Source.End());
+        Actual.append(TempVector.begin(),TempVector.end());
+    }
+    EXPECT_EQ(Actual,Expected);
+}
+
+TEST(ReadAheadDataSource, MixedAccessTest){
+    std::string Expected = TestString(5000);
+    CReadAheadDataSource Source(std::make_shared<CStringDataSource>(Expected),100);
+    std::span<const char> Span;
+    char Buffer[37];
+    std::string Actual;
+    char TempCh;
+
+    while(!Source.End()){
+        ASSERT_TRUE(Source.Borrow(Span,150));
+        EXPECT_LE(Span.size(),100);
+        Actual.append(Span.data(),Span.size());
+        Actual.append(Buffer,Source.ReadSpan(Buffer));
+        if(Source.Get(TempCh)){
+            Actual += TempCh;
+        }
+    }
+    EXPECT_EQ(Actual,Expected);
+}
+
+TEST(ReadAheadDataSource, EarlyDestructionTest){
+    std::string Expected = TestString(100000);
+    char TempCh;
+    {
+        CReadAheadDataSource Source(std::make_shared<CStringDataSource>(Expected),16,2);
+        EXPECT_TRUE(Source.Get(TempCh));
+        EXPECT_EQ(TempCh,'a');
+    }
+}
+
+TEST(ReadAheadDataSource, BorrowSurvivesEndTest){
+    std::string Expected = TestString(1000);
+    CReadAheadDataSource Source(std::make_shared<CStringDataSource>(Expected),8,1);
+    std::span<const char> Span;
+    std::string Actual;
+
+    // each view takes the rest of a chunk, so End() has to look past it
+    while(Source.Borrow(Span,8)){
+        std::string Lent(Span.data(),Span.size());
+        bool AtEnd = Source.End();
+        EXPECT_EQ(std::string(Span.data(),Span.size()),Lent);
+        Actual += Lent;
+        EXPECT_EQ(AtEnd,Actual.size() == Expected.size());
+    }
+    EXPECT_EQ(Actual,Expected);
+}
@@ -0,0 +1,317 @@
+#include <gtest/gtest.h>
+
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <fcntl.h>
+#include <sys/stat.h>
+
+#include "StringDataSource.h"
+#include "FileDataSource.h"
+#include "FileDataSink.h"
+#include "XMLReader.h"
+#include "OpenStreetMap.h"
+#include "StreetMapSnapshot.h"
+#include "FlatIDIndex.h"
+
+// Assume being run from Makefile so testtmp is subdirectory
+static const std::string BaseDirectory = "./testtmp/";
+
+static std::shared_ptr<COpenStreetMap> BuildMapFromXML(const std::string &xml)
+{
+    auto Source = std::make_shared<CStringDataSource>(xml);
+    return std::make_shared<COpenStreetMap>(std::make_shared<CXMLReader>(Source));
+}
+
+static std::shared_ptr<CStreetMapSnapshot> WriteAndOpen(const CStreetMap &map, const std::string &filename)
+{
+    std::remove((BaseDirectory + filename).c_str());
+    EXPECT_TRUE(CStreetMapSnapshot::Write(map, std::make_shared<CFileDataSink>(BaseDirectory + filename)));
+    return std::make_shared<CStreetMapSnapshot>(std::make_shared<CMappedFile>(BaseDirectory + filename));
+}
+
+static void ExpectSameMap(const CStreetMap &expected, const CStreetMap &actual)
+{
+    ASSERT_EQ(expected.NodeCount(), actual.NodeCount());
+    ASSERT_EQ(expected.WayCount(), actual.WayCount());
+    for (std::size_t Index = 0; Index < expected.NodeCount(); Index++)
+    {
+        auto Expected = expected.NodeByIndex(Index);
+        auto Actual = actual.NodeByIndex(Index);
+        ASSERT_EQ(Expected->ID(), Actual->ID());
+        auto ByID = actual.NodeByID(Expected->ID());
+        ASSERT_NE(ByID, nullptr);
+        EXPECT_EQ(ByID->ID(), Actual->ID());
+        EXPECT_EQ(ByID->Location(), Actual->Location());
+        EXPECT_EQ(Expected->Location(), Actual->Location());
+        ASSERT_EQ(Expected->AttributeCount(), Actual->AttributeCount());
+        for (std::size_t Attribute = 0; Attribute < Expected->AttributeCount(); Attribute++)
+        {
+            auto Key = Expected->GetAttributeKey(Attribute);
+            EXPECT_EQ(Key, Actual->GetAttributeKey(Attribute));
+            EXPECT_TRUE(Actual->HasAttribute(Key));
+            EXPECT_EQ(Expected->GetAttribute(Key), Actual->GetAttribute(Key));
+            EXPECT_EQ(Expected->GetAttributeValue(Attribute), Actual->GetAttributeValue(Attribute));
+        }
+    }
+    for (std::size_t Index = 0; Index < expected.WayCount(); Index++)
+    {
+        auto Expected = expected.WayByIndex(Index);
+        auto Actual = actual.WayByIndex(Index);
+        ASSERT_EQ(Expected->ID(), Actual->ID());
+        auto ByID = actual.WayByID(Expected->ID());
+        ASSERT_NE(ByID, nullptr);
+        EXPECT_EQ(ByID->ID(), Actual->ID());
+        EXPECT_EQ(ByID->NodeCount(), Actual->NodeCount());
+        ASSERT_EQ(Expected->NodeCount(), Actual->NodeCount());
+        for (std::size_t Node = 0; Node < Expected->NodeCount(); Node++)
+        {
+            EXPECT_EQ(Expected->GetNodeID(Node), Actual->GetNodeID(Node));
+        }
+        ASSERT_EQ(Expected->AttributeCount(), Actual->AttributeCount());
+        for (std::size_t Attribute = 0; Attribute < Expected->AttributeCount(); Attribute++)
+        {
+            auto Key = Expected->GetAttributeKey(Attribute);
+            EXPECT_EQ(Key, Actual->GetAttributeKey(Attribute));
+            EXPECT_EQ(Expected->GetAttribute(Key), Actual->GetAttribute(Key));
+            EXPECT_EQ(Expected->GetAttributeValue(Attribute), Actual->GetAttributeValue(Attribute));
+        }
+    }
+}
+
+TEST(StreetMapSnapshotTest, RoundTrip)
+{
+    std::string XML =
+        "<osm version=\"0.6\">"
+        "  <node id=\"1\" lat=\"38.5\" lon=\"-121.7\">"
+        "    <tag k=\"name\" v=\"Test Stop\"/>"
+        "    <tag k=\"highway\" v=\"bus_stop\"/>"
+        "  </node>"
+        "  <node id=\"2\" lat=\"38.6\" lon=\"-121.8\"/>"
+        "  <way id=\"10\">"
+        "    <nd ref=\"1\"/>"
+        "    <nd ref=\"2\"/>"
+        "    <tag k=\"highway\" v=\"residential\"/>"
+        "  </way>"
+        "  <way id=\"11\"/>"
+        "</osm>";
+
+    auto Map = BuildMapFromXML(XML);
+    auto Snapshot = WriteAndOpen(*Map, "roundtrip.smap");
+
+    ASSERT_TRUE(Snapshot->Valid());
+    ExpectSameMap(*Map, *Snapshot);
+
+    auto Node = Snapshot->NodeByID(1ULL);
+    ASSERT_NE(Node, nullptr);
+    EXPECT_EQ(Node->GetAttribute("name"), "Test Stop");
+    EXPECT_FALSE(Node->HasAttribute("missing"));
+    EXPECT_EQ(Node->GetAttribute("missing"), "");
+    EXPECT_EQ(Node->GetAttributeKey(2), "");
+    EXPECT_EQ(Snapshot->WayByID(10ULL)->GetNodeID(2), CStreetMap::InvalidNodeID);
+
+    EXPECT_EQ(Snapshot->NodeByIndex(2), nullptr);
+    EXPECT_EQ(Snapshot->NodeByID(3ULL), nullptr);
+    EXPECT_EQ(Snapshot->WayByIndex(2), nullptr);
+    EXPECT_EQ(Snapshot->WayByID(12ULL), nullptr);
+
+    // elements stay usable once the snapshot is gone
+    auto Way = Snapshot->WayByID(10ULL);
+    Snapshot.reset();
+    EXPECT_EQ(Node->ID(), 1ULL);
+    EXPECT_EQ(Way->GetAttribute("highway"), "residential");
+}
+
+TEST(StreetMapSnapshotTest, DuplicateKeys)
+{
+    std::string XML =
+        "<osm version=\"0.6\">"
+        "  <node id=\"1\" lat=\"38.5\" lon=\"-121.7\">"
+        "    <tag k=\"note\" v=\"first\"/>"
+        "    <tag k=\"name\" v=\"Stop\"/>"
+        "    <tag k=\"note\" v=\"second\"/>"
+        "  </node>"
+        "  <way id=\"10\">"
+        "    <nd ref=\"1\"/>"
+        "    <tag k=\"ref\" v=\"A\"/>"
+        "    <tag k=\"ref\" v=\"B\"/>"
+        "  </way>"
+        "</osm>";
+
+    auto Map = BuildMapFromXML(XML);
+    auto Snapshot = WriteAndOpen(*Map, "duplicates.smap");
+
+    ASSERT_TRUE(Snapshot->Valid());
+    ExpectSameMap(*Map, *Snapshot);
+
+    auto Node = Snapshot->NodeByID(1ULL);
+    ASSERT_EQ(Node->AttributeCount(), 3);
+    EXPECT_EQ(Node->GetAttributeKey(2), "note");
+    EXPECT_EQ(Node->GetAttributeValue(0), "first");
+    EXPECT_EQ(Node->GetAttributeValue(2), "second");
+    EXPECT_EQ(Node->GetAttributeValue(3), "");
+    EXPECT_EQ(Node->GetAttribute("note"), "first");
+    auto Way = Snapshot->WayByID(10ULL);
+    ASSERT_EQ(Way->AttributeCount(), 2);
+    EXPECT_EQ(Way->GetAttributeValue(0), "A");
+    EXPECT_EQ(Way->GetAttributeValue(1), "B");
+}
+
+TEST(StreetMapSnapshotTest, EmptyMap)
+{
+    auto Map = BuildMapFromXML("<osm version=\"0.6\"></osm>");
+    auto Snapshot = WriteAndOpen(*Map, "empty.smap");
+
+    ASSERT_TRUE(Snapshot->Valid());
+    EXPECT_EQ(Snapshot->NodeCount(), 0U);
+    EXPECT_EQ(Snapshot->WayCount(), 0U);
+    EXPECT_EQ(Snapshot->NodeByID(1ULL), nullptr);
+    EXPECT_EQ(Snapshot->WayByID(1ULL), nullptr);
+}
+
+TEST(StreetMapSnapshotTest, InvalidFiles)
+{
+    auto Map = BuildMapFromXML("<osm version=\"0.6\"><node id=\"1\" lat=\"38.5\" lon=\"-121.7\"/></osm>");
+    auto Snapshot = WriteAndOpen(*Map, "whole.smap");
+    ASSERT_TRUE(Snapshot->Valid());
+
+    std::ifstream File(BaseDirectory + "whole.smap", std::ios::binary);
+    std::string Contents((std::istreambuf_iterator<char>(File)), std::istreambuf_iterator<char>());
+    auto OpenContents = [](const std::string &contents) {
+        std::remove((BaseDirectory + "broken.smap").c_str());
+        {
+            CFileDataSink Sink(BaseDirectory + "broken.smap");
+            Sink.WriteString(contents);
+        }
+        return CStreetMapSnapshot(std::make_shared<CMappedFile>(BaseDirectory + "broken.smap"));
+    };
+
+    std::vector<std::string> Broken = {
+        "",
+        "not a snapshot at all, just some text that is long enough for a header",
+        Contents.substr(0, Contents.size() - 1),
+        std::string(1, Contents[0] + 1) + Contents.substr(1)};
+    for (auto &Contents : Broken)
+    {
+        auto Snapshot = OpenContents(Contents);
+        EXPECT_FALSE(Snapshot.Valid());
+        EXPECT_EQ(Snapshot.NodeCount(), 0U);
+        EXPECT_EQ(Snapshot.WayCount(), 0U);
+        EXPECT_EQ(Snapshot.NodeByIndex(0), nullptr);
+        EXPECT_EQ(Snapshot.NodeByID(1ULL), nullptr);
+    }
+
+    CStreetMapSnapshot Missing(std::make_shared<CMappedFile>(BaseDirectory + "missing.smap"));
+    EXPECT_FALSE(Missing.Valid());
+    EXPECT_EQ(Missing.NodeCount(), 0U);
+}
+
+TEST(StreetMapSnapshotTest, TamperedIndex)
+{
+    auto Map = BuildMapFromXML("<osm version=\"0.6\"><node id=\"1\" lat=\"38.5\" lon=\"-121.7\"/></osm>");
+    auto Snapshot = WriteAndOpen(*Map, "index.smap");
+    ASSERT_TRUE(Snapshot->Valid());
+    EXPECT_EQ(Snapshot->NodeByID(2ULL), nullptr);
+
+    // with one node and no ways the file ends with the two slot node index,
+    // IDs then positions
+    std::ifstream File(BaseDirectory + "index.smap", std::ios::binary);
+    std::string Contents((std::istreambuf_iterator<char>(File)), std::istreambuf_iterator<char>());
+    std::size_t IDsOffset = Contents.size() - 2 * sizeof(uint64_t) - 2 * sizeof(uint32_t);
+    std::size_t PositionsOffset = Contents.size() - 2 * sizeof(uint32_t);
+    auto Tamper = [&](const uint64_t (&ids)[2], const uint32_t (&positions)[2]) {
+        std::string Tampered = Contents;
+        std::memcpy(Tampered.data() + IDsOffset, ids, sizeof(ids));
+        std::memcpy(Tampered.data() + PositionsOffset, positions, sizeof(positions));
+        std::remove((BaseDirectory + "tampered.smap").c_str());
+        {
+            CFileDataSink Sink(BaseDirectory + "tampered.smap");
+            Sink.WriteString(Tampered);
+        }
+        return CStreetMapSnapshot(std::make_shared<CMappedFile>(BaseDirectory + "tampered.smap"));
+    };
+
+    uint64_t IDs[2];
+    uint32_t Positions[2];
+    std::memcpy(IDs, Contents.data() + IDsOffset, sizeof(IDs));
+    std::memcpy(Positions, Contents.data() + PositionsOffset, sizeof(Positions));
+    std::size_t Used = IDs[0] == 1 ? 0 : 1;
+    ASSERT_EQ(IDs[Used], 1U);
+    ASSERT_EQ(Positions[Used], 0U);
+    ASSERT_EQ(IDs[1 - Used], CFlatIDIndex::EmptyID);
+    ASSERT_EQ(Positions[1 - Used], CFlatIDIndex::InvalidPosition);
+    EXPECT_TRUE(Tamper(IDs, Positions).Valid());
+
+    // no empty slot would leave a lookup of a missing ID probing forever
+    auto Full = Tamper({1, 3}, {0, 0});
+    EXPECT_FALSE(Full.Valid());
+    EXPECT_EQ(Full.NodeByID(2ULL), nullptr);
+    // a position past the nodes
+    EXPECT_FALSE(Tamper({1, CFlatIDIndex::EmptyID}, {1, CFlatIDIndex::InvalidPosition}).Valid());
+    // an ID in a slot marked empty is harmless, but a slot needs both
+    EXPECT_FALSE(Tamper({1, 3}, {0, CFlatIDIndex::InvalidPosition}).Valid());
+
+    // a one slot way index for no ways, whose home slot cannot be hashed
+    std::string OneSlot = Contents;
+    uint64_t WayIndexSlots = 1;
+    std::size_t WayIndexSlotsOffset = 8 + 2 * sizeof(uint32_t) + 9 * sizeof(uint64_t);
+    std::memcpy(OneSlot.data() + WayIndexSlotsOffset, &WayIndexSlots, sizeof(WayIndexSlots));
+    uint64_t EmptyID = CFlatIDIndex::EmptyID;
+    uint32_t InvalidPosition[2] = {CFlatIDIndex::InvalidPosition, 0};
+    OneSlot.append(reinterpret_cast<const char *>(&EmptyID), sizeof(EmptyID));
+    OneSlot.append(reinterpret_cast<const char *>(InvalidPosition), sizeof(InvalidPosition));
+    std::remove((BaseDirectory + "tampered.smap").c_str());
+    {
+        CFileDataSink Sink(BaseDirectory + "tampered.smap");
+        Sink.WriteString(OneSlot);
+    }
+    CStreetMapSnapshot OneSlotSnapshot(std::make_shared<CMappedFile>(BaseDirectory + "tampered.smap"));
+    EXPECT_FALSE(OneSlotSnapshot.Valid());
+    EXPECT_EQ(OneSlotSnapshot.WayByID(1ULL), nullptr);
+}
+
+TEST(StreetMapSnapshotTest, MatchesSource)
+{
+    std::string XML = "<osm version=\"0.6\"><node id=\"1\" lat=\"38.5\" lon=\"-121.7\"/></osm>";
+    std::string SourceFilename = BaseDirectory + "source.osm";
+    auto WriteSource = [&](const std::string &contents) {
+        CFileDataSink Sink(SourceFilename);
+        EXPECT_TRUE(Sink.WriteString(contents));
+        EXPECT_TRUE(Sink.Flush());
+    };
+    WriteSource(XML);
+    auto Map = BuildMapFromXML(XML);
+    std::remove((BaseDirectory + "source.smap").c_str());
+    ASSERT_TRUE(CStreetMapSnapshot::Write(*Map, std::make_shared<CFileDataSink>(BaseDirectory + "source.smap"), SourceFilename));
+    auto OpenSnapshot = [&]() {
+        return CStreetMapSnapshot(std::make_shared<CMappedFile>(BaseDirectory + "source.smap"));
+    };
+    EXPECT_TRUE(OpenSnapshot().MatchesSource(SourceFilename));
+    EXPECT_FALSE(OpenSnapshot().MatchesSource(BaseDirectory + "missing.osm"));
+
+    // touched but the same size
+    struct timespec Times[2] = {{0, UTIME_OMIT}, {1000000000, 0}};
+    ASSERT_EQ(utimensat(AT_FDCWD, SourceFilename.c_str(), Times, 0), 0);
+    EXPECT_FALSE(OpenSnapshot().MatchesSource(SourceFilename));
+
+    // edited
+    WriteSource(XML + "\n");
+    EXPECT_FALSE(OpenSnapshot().MatchesSource(SourceFilename));
+
+    // written without a source, still valid but matches nothing
+    auto Unstamped = WriteAndOpen(*Map, "unstamped.smap");
+    EXPECT_TRUE(Unstamped->Valid());
+    EXPECT_FALSE(Unstamped->MatchesSource(SourceFilename));
+}
+
+TEST(StreetMapSnapshotTest, MatchesParsedMap)
+{
+    auto File = std::make_shared<CMappedFile>("./data/davis.osm");
+    ASSERT_FALSE(File->Contents().empty());
+    COpenStreetMap Map(std::make_shared<CXMLReader>(std::make_shared<CFileDataSource>(File), CXMLReader::EParser::Native));
+    auto Snapshot = WriteAndOpen(Map, "davis.smap");
+
+    ASSERT_TRUE(Snapshot->Valid());
+    ASSERT_GT(Snapshot->NodeCount(), 1000U);
+    ExpectSameMap(Map, *Snapshot);
+}
@@ -1,5 +1,6 @@
 #include <gtest/gtest.h>
 #include "StringDataSink.h"
+#include "SpanDataSink.h"
 
 TEST(StringDataSink, EmptyTest){
     CStringDataSink EmptySink;
@@ -30,3 +31,51 @@ TEST(StringDataSink, WriteTest){
     EXPECT_TRUE(Sink.Write(TempVector2));
     EXPECT_EQ(Sink.String(),"Hello World");   
 }
+
+TEST(StringDataSink, WriteSpanTest){
+    const char Hello[] = {'H','e','l','l','o'};
+    CStringDataSink Sink;
+
+    EXPECT_TRUE(Sink.WriteSpan(Hello));
+    EXPECT_EQ(Sink.String(),"Hello");
+    EXPECT_TRUE(Sink.WriteString(" World"));
+    EXPECT_EQ(Sink.String(),"Hello World");
+    EXPECT_TRUE(Sink.WriteString(""));
+    EXPECT_EQ(Sink.String(),"Hello World");
+}
+
+TEST(StringDataSink, ReserveReleaseTest){
+    CStringDataSink Sink(1024);
+
+    EXPECT_GE(Sink.String().capacity(),1024);
+    EXPECT_TRUE(Sink.WriteString("Hello"));
+    const char *Storage = Sink.String().data();
+    std::string Released = Sink.Release();
+    EXPECT_EQ(Released,"Hello");
+    EXPECT_EQ(Released.data(),Storage);
+    EXPECT_TRUE(Sink.String().empty());
+    Sink.Reserve(64);
+    EXPECT_GE(Sink.String().capacity(),64);
+    EXPECT_TRUE(Sink.Put('!'));
+    EXPECT_EQ(Sink.String(),"!");
+}
+
+TEST(SpanDataSink, WriteTest){
+    char Buffer[8];
+    CSpanDataSink Sink(Buffer);
+
+    EXPECT_EQ(Sink.Length(),0);
+    EXPECT_TRUE(Sink.Put('H'));
+    EXPECT_TRUE(Sink.WriteString("ello"));
+    EXPECT_EQ(Sink.View(),"Hello");
+    EXPECT_EQ(Sink.View().data(),Buffer);
+    EXPECT_FALSE(Sink.WriteString(" World"));
+    EXPECT_EQ(Sink.View(),"Hello");
+    EXPECT_TRUE(Sink.Write(std::vector<char>{' ','W','o'}));
+    EXPECT_FALSE(Sink.Put('r'));
+    EXPECT_EQ(Sink.View(),"Hello Wo");
+    Sink.Clear();
+    EXPECT_EQ(Sink.Length(),0);
+    EXPECT_TRUE(Sink.Put('r'));
+    EXPECT_EQ(Sink.View(),"r");
+}
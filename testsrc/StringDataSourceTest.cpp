@@ -1,5 +1,8 @@
 #include <gtest/gtest.h>
 #include "StringDataSource.h"
+#include "StringViewDataSource.h"
+#include "StandardDataSource.h"
+#include <unistd.h>
 
 TEST(StringDataSource, EndTest){
     CStringDataSource EmptySource("");
@@ -81,3 +84,194 @@ TEST(StringDataSource, ReadTest){
     EXPECT_FALSE(Source2.Peek(TempCh));
     EXPECT_EQ(TempCh,'x');
 }
+
+TEST(StringDataSource, ReadSpanTest){
+    CStringDataSource EmptySource("");
+    CStringDataSource Source("Hello");
+    char Buffer[4] = {'x','x','x','x'};
+    char TempCh = 'x';
+
+    EXPECT_EQ(EmptySource.ReadSpan(Buffer),0);
+    EXPECT_EQ(Buffer[0],'x');
+    EXPECT_EQ(Source.ReadSpan(Buffer),4);
+    EXPECT_EQ(std::string(Buffer,4),"Hell");
+    EXPECT_TRUE(Source.Peek(TempCh));
+    EXPECT_EQ(TempCh,'o');
+    EXPECT_EQ(Source.ReadSpan(Buffer),1);
+    EXPECT_EQ(Buffer[0],'o');
+    EXPECT_TRUE(Source.End());
+    EXPECT_EQ(Source.ReadSpan(Buffer),0);
+}
+
+TEST(StringDataSource, BorrowTest){
+    std::string Input = "Hello World";
+    CStringDataSource Source(std::move(Input));
+    std::span<const char> Span;
+
+    EXPECT_TRUE(Source.Borrow(Span,5));
+    EXPECT_EQ(std::string(Span.data(),Span.size()),"Hello");
+    EXPECT_TRUE(Source.Borrow(Span,100));
+    EXPECT_EQ(std::string(Span.data(),Span.size())," World");
+    EXPECT_TRUE(Source.End());
+    EXPECT_FALSE(Source.Borrow(Span,1));
+}
+
+TEST(StringViewDataSource, NoCopyTest){
+    std::string Input = "Hello";
+    CStringViewDataSource Source(Input);
+    std::span<const char> Span;
+    char TempCh;
+
+    EXPECT_FALSE(Source.End());
+    EXPECT_TRUE(Source.Peek(TempCh));
+    EXPECT_EQ(TempCh,'H');
+    EXPECT_TRUE(Source.Borrow(Span,2));
+    // Borrowed bytes are the caller's own
+    EXPECT_EQ(Span.data(),Input.data());
+    EXPECT_TRUE(Source.Get(TempCh));
+    EXPECT_EQ(TempCh,'l');
+    Input[3] = 'p';
+    EXPECT_TRUE(Source.Get(TempCh));
+    EXPECT_EQ(TempCh,'p');
+}
+
+TEST(StringViewDataSource, ReadTest){
+    CStringViewDataSource EmptySource("");
+    CStringViewDataSource Source("Hello World");
+    std::vector< char > TempVector;
+    char Buffer[5];
+
+    EXPECT_TRUE(EmptySource.End());
+    EXPECT_FALSE(EmptySource.Read(TempVector,3));
+    EXPECT_EQ(EmptySource.ReadSpan(Buffer),0);
+    EXPECT_TRUE(Source.Read(TempVector,6));
+    EXPECT_EQ(std::string(TempVector.begin(),TempVector.end()),"Hello ");
+    EXPECT_EQ(Source.ReadSpan(Buffer),5);
+    EXPECT_EQ(std::string(Buffer,5),"World");
+    EXPECT_TRUE(Source.End());
+    EXPECT_FALSE(Source.Read(TempVector,1));
+}
+
+TEST(StringDataSource, ReadLineTest){
+    CStringDataSource Source("exit\n\ncount\nhelp");
+    std::string Line = "x";
+
+    EXPECT_TRUE(Source.ReadLine(Line));
+    EXPECT_EQ(Line,"exit");
+    EXPECT_TRUE(Source.ReadLine(Line));
+    EXPECT_EQ(Line,"");
+    EXPECT_TRUE(Source.ReadLine(Line));
+    EXPECT_EQ(Line,"count");
+    EXPECT_TRUE(Source.ReadLine(Line));
+    EXPECT_EQ(Line,"help");
+    EXPECT_TRUE(Source.End());
+    EXPECT_FALSE(Source.ReadLine(Line));
+}
+
+TEST(StringViewDataSource, ReadLineTest){
+    std::string Text = "node 1\nnode 2\n";
+    CStringViewDataSource Source(Text);
+    std::string Line;
+    char TempCh;
+
+    EXPECT_TRUE(Source.ReadLine(Line));
+    EXPECT_EQ(Line,"node 1");
+    EXPECT_TRUE(Source.Peek(TempCh));
+    EXPECT_EQ(TempCh,'n');
+    EXPECT_TRUE(Source.ReadLine(Line));
+    EXPECT_EQ(Line,"node 2");
+    EXPECT_FALSE(Source.ReadLine(Line));
+}
+
+TEST(StandardDataSource, PipeTest){
+    int Pipe[2];
+    ASSERT_EQ(pipe(Pipe),0);
+    std::string Text = "shortest 1 2\nfastest 3 4\nexit";
+    ASSERT_EQ(write(Pipe[1], Text.data(), Text.length()),ssize_t(Text.length()));
+    close(Pipe[1]);
+
+    // A tiny buffer forces lines to straddle refills
+    CStandardDataSource Source(Pipe[0], 5);
+    std::string Line;
+    char TempCh;
+    std::vector<char> Buffer;
+
+    EXPECT_FALSE(Source.End());
+    EXPECT_TRUE(Source.Peek(TempCh));
+    EXPECT_EQ(TempCh,'s');
+    EXPECT_TRUE(Source.ReadLine(Line));
+    EXPECT_EQ(Line,"shortest 1 2");
+    EXPECT_TRUE(Source.Get(TempCh));
+    EXPECT_EQ(TempCh,'f');
+    EXPECT_TRUE(Source.Read(Buffer, 7));
+    EXPECT_EQ(std::string(Buffer.begin(), Buffer.end()),"astest ");
+    EXPECT_TRUE(Source.ReadLine(Line));
+    EXPECT_EQ(Line,"3 4");
+    EXPECT_TRUE(Source.ReadLine(Line));
+    EXPECT_EQ(Line,"exit");
+    EXPECT_TRUE(Source.End());
+    EXPECT_FALSE(Source.ReadLine(Line));
+    EXPECT_FALSE(Source.Get(TempCh));
+    close(Pipe[0]);
+}
+
+TEST(StringDataSource, SeekTest){
+    CStringDataSource Source("abc\ndef");
+    CStringViewDataSource ViewSource("abc\ndef");
+    std::string Line;
+    char TempCh;
+    std::size_t Offset;
+
+    for(CDataSource *Current : std::initializer_list<CDataSource *>{&Source, &ViewSource}){
+        EXPECT_TRUE(Current->ReadLine(Line));
+        EXPECT_TRUE(Current->Tell(Offset));
+        EXPECT_EQ(Offset,4);
+        EXPECT_TRUE(Current->Seek(1));
+        EXPECT_TRUE(Current->ReadLine(Line));
+        EXPECT_EQ(Line,"bc");
+        EXPECT_TRUE(Current->Tell(Offset));
+        EXPECT_EQ(Offset,4);
+        EXPECT_TRUE(Current->Seek(7));
+        EXPECT_TRUE(Current->End());
+        EXPECT_FALSE(Current->Seek(8));
+        EXPECT_TRUE(Current->End());
+        EXPECT_TRUE(Current->Seek(4));
+        EXPECT_TRUE(Current->Get(TempCh));
+        EXPECT_EQ(TempCh,'d');
+    }
+}
+
+TEST(StandardDataSource, SeekTest){
+    int Pipe[2];
+    ASSERT_EQ(pipe(Pipe),0);
+    close(Pipe[1]);
+    CStandardDataSource PipeSource(Pipe[0]);
+    EXPECT_FALSE(PipeSource.Seek(0));
+    std::size_t Offset;
+    EXPECT_FALSE(PipeSource.Tell(Offset));
+    close(Pipe[0]);
+
+    FILE *File = tmpfile();
+    ASSERT_NE(File,nullptr);
+    std::string Text = "first\nsecond\n";
+    ASSERT_EQ(fwrite(Text.data(), 1, Text.length(), File),Text.length());
+    fflush(File);
+    CStandardDataSource Source(fileno(File), 4);
+    std::string Line;
+    EXPECT_TRUE(Source.Seek(6));
+    EXPECT_TRUE(Source.ReadLine(Line));
+    EXPECT_EQ(Line,"second");
+    EXPECT_FALSE(Source.ReadLine(Line));
+    EXPECT_TRUE(Source.End());
+    EXPECT_TRUE(Source.Seek(0));
+    EXPECT_FALSE(Source.End());
+    EXPECT_TRUE(Source.ReadLine(Line));
+    EXPECT_EQ(Line,"first");
+    EXPECT_TRUE(Source.Tell(Offset));
+    EXPECT_EQ(Offset,6);
+    EXPECT_FALSE(Source.Seek(Text.length() + 1));
+    EXPECT_TRUE(Source.ReadLine(Line));
+    EXPECT_EQ(Line,"second");
+    fclose(File);
+}
+
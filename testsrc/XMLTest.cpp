@@ -1,11 +1,13 @@
 #include <gtest/gtest.h>
 
+#include <fstream>
 #include <memory>
 #include <string>
 #include <vector>
 
 #include "DataSink.h"
 #include "XMLReader.h"
+#include "XMLTokenizer.h"
 #include "XMLWriter.h"
 #include "StringDataSink.h"
 #include "StringDataSource.h"
@@ -23,6 +25,95 @@ namespace
         return Entities;
     }
 
+    // Reads all entities joining runs of character data, which expat may
+    // split in different places than the native parser
+    std::vector<SXMLEntity> ReadMergedEntities(CXMLReader &reader)
+    {
+        std::vector<SXMLEntity> Entities;
+        SXMLEntity Temp;
+        while (reader.ReadEntity(Temp))
+        {
+            if (!Entities.empty() && (Temp.DType == SXMLEntity::EType::CharData) && (Entities.back().DType == SXMLEntity::EType::CharData))
+            {
+                Entities.back().DNameData += Temp.DNameData;
+                continue;
+            }
+            Entities.push_back(Temp);
+        }
+        return Entities;
+    }
+
+    void ExpectSameEntities(const std::vector<SXMLEntity> &expected, const std::vector<SXMLEntity> &actual)
+    {
+        ASSERT_EQ(expected.size(), actual.size());
+        for (std::size_t Index = 0; Index < expected.size(); Index++)
+        {
+            EXPECT_EQ(expected[Index].DType, actual[Index].DType) << "entity " << Index;
+            EXPECT_EQ(expected[Index].DNameData, actual[Index].DNameData) << "entity " << Index;
+            EXPECT_EQ(expected[Index].DAttributes, actual[Index].DAttributes) << "entity " << Index;
+        }
+    }
+
+    // Hands out a few bytes per read or loan so markup straddles every
+    // refill, optionally refusing to lend at all
+    class CTrickleDataSource : public CStringDataSource
+    {
+    public:
+        CTrickleDataSource(std::string str, std::size_t limit, bool lend = true) : CStringDataSource(std::move(str)), DLimit(limit), DLend(lend)
+        {
+        }
+
+        std::size_t ReadSpan(std::span<char> buf) noexcept override
+        {
+            return CStringDataSource::ReadSpan(buf.first(std::min(buf.size(), DLimit)));
+        }
+
+        bool Borrow(std::span<const char> &span, std::size_t count) noexcept override
+        {
+            return DLend && CStringDataSource::Borrow(span, std::min(count, DLimit));
+        }
+
+    private:
+        std::size_t DLimit;
+        bool DLend;
+    };
+
+    // Records pushed events as entities so they can be compared with ReadEntity
+    class CRecordingHandler : public CXMLHandler
+    {
+    public:
+        std::vector<SXMLEntity> DEntities;
+
+        std::vector<TXMLAtom> DAtoms;
+
+        void StartElement(TXMLAtom atom, std::string_view name, const CXMLAttributes &attributes) override
+        {
+            DAtoms.push_back(atom);
+            SXMLEntity Entity{SXMLEntity::EType::StartElement, std::string(name), {}};
+            for (auto &Attribute : attributes.Views())
+            {
+                Entity.DAttributes.emplace_back(std::string(Attribute.first), std::string(Attribute.second));
+            }
+            DEntities.push_back(Entity);
+        }
+
+        void EndElement(TXMLAtom atom, std::string_view name) override
+        {
+            DAtoms.push_back(atom);
+            DEntities.push_back(SXMLEntity{SXMLEntity::EType::EndElement, std::string(name), {}});
+        }
+
+        void CharData(std::string_view data) override
+        {
+            if (!DEntities.empty() && (DEntities.back().DType == SXMLEntity::EType::CharData))
+            {
+                DEntities.back().DNameData += data;
+                return;
+            }
+            DEntities.push_back(SXMLEntity{SXMLEntity::EType::CharData, std::string(data), {}});
+        }
+    };
+
     class CFailingDataSink : public CDataSink
     {
     public:
@@ -163,6 +254,255 @@ TEST(XMLReader, EmptyInput)
     EXPECT_TRUE(Reader.End());
 }
 
+TEST(XMLReader, NativeMatchesExpat)
+{
+    std::string XMLString = "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\r\n"
+                            "<!DOCTYPE osm>\n"
+                            "<!-- generated -->\n"
+                            "<osm version=\"0.6\" generator='test &amp; more'>\n"
+                            "  <node id=\"1\" lat=\"38.5\" lon=\"-121.7\"/>\n"
+                            "  <node id = \"2\"\tlat=\"1\" lon=\"2\">\r\n"
+                            "    <tag k=\"name\" v=\"A &lt;B&gt; &quot;C&quot; &apos;D&apos; &#233;&#x4E2D;\"/>\n"
+                            "    <tag k=\"note\" v=\"line\nbreak\ttab&#10;kept\"/>\n"
+                            "  </node >\n"
+                            "  <way id=\"3\">text &amp; more<![CDATA[<raw> & ]]>tail<?pi skipped?></way>\n"
+                            "</osm>\n";
+    for (bool Lend : {true, false})
+    {
+        for (std::size_t Limit : {1, 2, 3, 7, 4096})
+        {
+            CXMLReader ExpatReader(std::make_shared<CStringDataSource>(XMLString));
+            CXMLReader NativeReader(std::make_shared<CTrickleDataSource>(XMLString, Limit, Lend), CXMLReader::EParser::Native);
+            ExpectSameEntities(ReadMergedEntities(ExpatReader), ReadMergedEntities(NativeReader));
+            EXPECT_TRUE(NativeReader.End());
+        }
+    }
+}
+
+TEST(XMLReader, NativeSkipCharData)
+{
+    std::string XMLString = "<root><child a='1'>hi</child><empty/></root>";
+    CXMLReader Reader(std::make_shared<CStringDataSource>(XMLString), CXMLReader::EParser::Native);
+
+    auto Entities = ReadAllEntities(Reader, true);
+    ASSERT_EQ(Entities.size(), 6u);
+    EXPECT_EQ(Entities[1].DNameData, "child");
+    EXPECT_EQ(Entities[1].AttributeValue("a"), "1");
+    EXPECT_EQ(Entities[2].DType, SXMLEntity::EType::EndElement);
+    EXPECT_EQ(Entities[3].DType, SXMLEntity::EType::StartElement);
+    EXPECT_TRUE(Entities[3].DAttributes.empty());
+    EXPECT_EQ(Entities[4].DType, SXMLEntity::EType::EndElement);
+    EXPECT_EQ(Entities[4].DNameData, "empty");
+    EXPECT_TRUE(Reader.End());
+}
+
+TEST(XMLReader, NativeInvalidXML)
+{
+    std::vector<std::string> Documents = {"",
+                                          "   ",
+                                          "<root><child></root>",
+                                          "<root>",
+                                          "<root></root><second/>",
+                                          "<root></root>junk",
+                                          "text<root/>",
+                                          "<root a=\"1\" a=\"2\"/>",
+                                          "<root a=\"1\"b=\"2\"/>",
+                                          "<root a=1/>",
+                                          "<root a=\"&bogus;\"/>",
+                                          "<root>&#0;</root>",
+                                          "<root a=\"<\"/>",
+                                          "<!DOCTYPE root [<!ENTITY e \"x\">]><root/>",
+                                          "<root><!-- unterminated </root>",
+                                          "<root/"};
+    for (auto &Document : Documents)
+    {
+        CXMLTokenizer Tokenizer(std::make_shared<CStringDataSource>(Document));
+        SXMLToken Token;
+        while (Tokenizer.ReadToken(Token))
+        {
+        }
+        EXPECT_TRUE(Tokenizer.Failed()) << Document;
+        EXPECT_TRUE(Tokenizer.End()) << Document;
+        EXPECT_FALSE(Tokenizer.ReadToken(Token)) << Document;
+    }
+    CXMLTokenizer Tokenizer(std::make_shared<CStringDataSource>("<root/>  \n"));
+    SXMLToken Token;
+    while (Tokenizer.ReadToken(Token))
+    {
+    }
+    EXPECT_FALSE(Tokenizer.Failed());
+    EXPECT_TRUE(Tokenizer.End());
+}
+
+TEST(XMLReader, ParseMatchesReadEntity)
+{
+    std::string XMLString = "<osm version=\"0.6\">\n"
+                            "  <node id=\"1\" lat=\"38.5\" lon=\"-121.7\"><tag k=\"a&amp;b\" v=\"&#233;\"/></node>\n"
+                            "  <way id=\"3\">text<![CDATA[<raw>]]></way>\n"
+                            "</osm>";
+    for (auto Parser : {CXMLReader::EParser::Expat, CXMLReader::EParser::Native})
+    {
+        CXMLReader PullReader(std::make_shared<CStringDataSource>(XMLString), Parser);
+        CXMLReader PushReader(std::make_shared<CTrickleDataSource>(XMLString, 5), Parser);
+        CRecordingHandler Handler;
+        EXPECT_TRUE(PushReader.Parse(Handler));
+        EXPECT_TRUE(PushReader.End());
+        ExpectSameEntities(ReadMergedEntities(PullReader), Handler.DEntities);
+    }
+}
+
+TEST(XMLReader, ParseAfterReadEntity)
+{
+    std::string XMLString = "<root><a x=\"1\"/><b>text</b></root>";
+    for (auto Parser : {CXMLReader::EParser::Expat, CXMLReader::EParser::Native})
+    {
+        CXMLReader Reader(std::make_shared<CStringDataSource>(XMLString), Parser);
+        SXMLEntity Entity;
+        ASSERT_TRUE(Reader.ReadEntity(Entity));
+        ASSERT_TRUE(Reader.ReadEntity(Entity));
+        EXPECT_EQ(Entity.DNameData, "a");
+
+        // the rest of the document is pushed, none of it lost or repeated
+        CRecordingHandler Handler;
+        EXPECT_TRUE(Reader.Parse(Handler));
+        ASSERT_EQ(Handler.DEntities.size(), 5u);
+        EXPECT_EQ(Handler.DEntities[0].DType, SXMLEntity::EType::EndElement);
+        EXPECT_EQ(Handler.DEntities[0].DNameData, "a");
+        EXPECT_EQ(Handler.DEntities[1].DNameData, "b");
+        EXPECT_EQ(Handler.DEntities[2].DNameData, "text");
+        EXPECT_EQ(Handler.DEntities[4].DNameData, "root");
+        EXPECT_FALSE(Reader.ReadEntity(Entity));
+        // including elements that were opened before Parse
+        ASSERT_EQ(Handler.DAtoms.size(), 4u);
+        EXPECT_EQ(Reader.Atoms().Name(Handler.DAtoms[0]), "a");
+        EXPECT_EQ(Reader.Atoms().Name(Handler.DAtoms[1]), "b");
+        EXPECT_EQ(Reader.Atoms().Name(Handler.DAtoms[2]), "b");
+        EXPECT_EQ(Reader.Atoms().Name(Handler.DAtoms[3]), "root");
+    }
+}
+
+TEST(XMLReader, ParseInvalidXML)
+{
+    for (auto Parser : {CXMLReader::EParser::Expat, CXMLReader::EParser::Native})
+    {
+        CXMLReader Reader(std::make_shared<CStringDataSource>("<root><child></root>"), Parser);
+        CRecordingHandler Handler;
+        EXPECT_FALSE(Reader.Parse(Handler));
+        EXPECT_TRUE(Reader.End());
+        ASSERT_FALSE(Handler.DEntities.empty());
+        EXPECT_EQ(Handler.DEntities[0].DNameData, "root");
+    }
+}
+
+TEST(XMLReader, ParseAtoms)
+{
+    std::string XMLString = "<osm><node id=\"1\" lat=\"2\"/><way id=\"3\"><nd ref=\"1\"/></way></osm>";
+    for (auto Parser : {CXMLReader::EParser::Expat, CXMLReader::EParser::Native})
+    {
+        CXMLReader Reader(std::make_shared<CStringDataSource>(XMLString), Parser);
+        // names interned before parsing keep their atoms
+        auto NodeAtom = Reader.Atoms().Intern("node");
+        auto LatAtom = Reader.Atoms().Intern("lat");
+        auto UnusedAtom = Reader.Atoms().Intern("unused");
+
+        struct SAtomHandler : public CXMLHandler
+        {
+            CXMLReader &DReader;
+            TXMLAtom DNodeAtom, DLatAtom, DUnusedAtom;
+            std::size_t DNodes = 0;
+
+            SAtomHandler(CXMLReader &reader, TXMLAtom node, TXMLAtom lat, TXMLAtom unused)
+                : DReader(reader), DNodeAtom(node), DLatAtom(lat), DUnusedAtom(unused)
+            {
+            }
+
+            void StartElement(TXMLAtom atom, std::string_view name, const CXMLAttributes &attributes) override
+            {
+                EXPECT_EQ(DReader.Atoms().Name(atom), name);
+                for (std::size_t Index = 0; Index < attributes.Count(); Index++)
+                {
+                    EXPECT_EQ(DReader.Atoms().Name(attributes.Atom(Index)), attributes.Views()[Index].first);
+                    EXPECT_EQ(attributes.Value(attributes.Atom(Index)), attributes.Views()[Index].second);
+                }
+                EXPECT_FALSE(attributes.Exists(DUnusedAtom));
+                if (atom == DNodeAtom)
+                {
+                    DNodes++;
+                    EXPECT_EQ(attributes.Value(DLatAtom), "2");
+                }
+                else
+                {
+                    // the previous element's attributes are gone
+                    EXPECT_FALSE(attributes.Exists(DLatAtom));
+                    EXPECT_EQ(attributes.Value(DLatAtom), "");
+                }
+            }
+
+            void EndElement(TXMLAtom atom, std::string_view name) override
+            {
+                EXPECT_EQ(DReader.Atoms().Find(name), atom);
+            }
+        } Handler(Reader, NodeAtom, LatAtom, UnusedAtom);
+
+        EXPECT_TRUE(Reader.Parse(Handler));
+        EXPECT_EQ(Handler.DNodes, 1u);
+        EXPECT_EQ(Reader.Atoms().Find("node"), NodeAtom);
+        EXPECT_EQ(Reader.Atoms().Find("ref"), Reader.Atoms().Intern("ref"));
+        // osm, id, way, nd and ref were added while parsing
+        EXPECT_EQ(Reader.Atoms().Size(), 8u);
+    }
+}
+
+TEST(XMLAtoms, AtomTable)
+{
+    CXMLAtomTable Table;
+    EXPECT_EQ(Table.Size(), 0u);
+    EXPECT_EQ(Table.Find("a"), CXMLAtomTable::InvalidAtom);
+    auto A = Table.Intern("a");
+    auto B = Table.Intern(std::string("b"));
+    EXPECT_EQ(A, 0u);
+    EXPECT_EQ(B, 1u);
+    EXPECT_EQ(Table.Intern("a"), A);
+    EXPECT_EQ(Table.Find("b"), B);
+    EXPECT_EQ(Table.Name(B), "b");
+    EXPECT_EQ(Table.Name(7), "");
+    EXPECT_EQ(Table.Size(), 2u);
+}
+
+TEST(XMLAtoms, Attributes)
+{
+    CXMLAttributes Attributes;
+    EXPECT_EQ(Attributes.Count(), 0u);
+    EXPECT_FALSE(Attributes.Exists(3));
+    Attributes.Add(3, "k", "name");
+    Attributes.Add(0, "v", "Main");
+    EXPECT_EQ(Attributes.Count(), 2u);
+    EXPECT_TRUE(Attributes.Exists(3));
+    EXPECT_FALSE(Attributes.Exists(1));
+    EXPECT_FALSE(Attributes.Exists(100));
+    EXPECT_EQ(Attributes.Value(0), "Main");
+    EXPECT_EQ(Attributes.Atom(0), 3u);
+    EXPECT_EQ(Attributes.Atom(2), CXMLAtomTable::InvalidAtom);
+    EXPECT_EQ(Attributes.Views()[0], TAttributeView("k", "name"));
+
+    Attributes.Clear();
+    EXPECT_EQ(Attributes.Count(), 0u);
+    EXPECT_FALSE(Attributes.Exists(3));
+    EXPECT_EQ(Attributes.Value(0), "");
+}
+
+TEST(XMLReader, NativeMatchesExpatOnOSM)
+{
+    std::ifstream File("./data/city.osm");
+    std::string Contents((std::istreambuf_iterator<char>(File)), std::istreambuf_iterator<char>());
+    ASSERT_FALSE(Contents.empty());
+    CXMLReader ExpatReader(std::make_shared<CStringDataSource>(Contents));
+    CXMLReader NativeReader(std::make_shared<CStringDataSource>(Contents), CXMLReader::EParser::Native);
+    auto Expected = ReadMergedEntities(ExpatReader);
+    EXPECT_GT(Expected.size(), 10000u);
+    ExpectSameEntities(Expected, ReadMergedEntities(NativeReader));
+}
+
 // test writing out elements to check that it can open/close a tag
 TEST(XMLWriter, SimpleElements)
 {
@@ -222,56 +562,60 @@ TEST(XMLWriter, Escaping)
     EXPECT_EQ(DataSink->String(), "<tag a=\"1&amp;2&quot;3&apos;&lt;&gt;\">x&lt;y &amp; z&gt;!</tag>");
 }
 
+// each entity reaches the sink in a single write
 TEST(XMLWriter, StartTagFailurePaths)
 {
-    for (int FailAfter = 0; FailAfter <= 7; FailAfter++)
-    {
-        auto DataSink = std::make_shared<CFailingDataSink>(FailAfter);
-        CXMLWriter Writer(DataSink);
+    SXMLEntity Start;
+    Start.DType = SXMLEntity::EType::StartElement;
+    Start.DNameData = "tag";
+    Start.SetAttribute("a", "b");
 
-        SXMLEntity Start;
-        Start.DType = SXMLEntity::EType::StartElement;
-        Start.DNameData = "tag";
-        Start.SetAttribute("a", "b");
+    auto FailingSink = std::make_shared<CFailingDataSink>(0);
+    CXMLWriter FailingWriter(FailingSink);
+    EXPECT_FALSE(FailingWriter.WriteEntity(Start));
+    EXPECT_EQ(FailingSink->String(), "");
 
-        EXPECT_FALSE(Writer.WriteEntity(Start));
-    }
+    auto DataSink = std::make_shared<CFailingDataSink>(1);
+    CXMLWriter Writer(DataSink);
+    EXPECT_TRUE(Writer.WriteEntity(Start));
+    EXPECT_EQ(DataSink->String(), "<tag a=\"b\">");
 }
 
 TEST(XMLWriter, CompleteTagFailurePaths)
 {
-    for (int FailAfter = 0; FailAfter <= 7; FailAfter++)
-    {
-        auto DataSink = std::make_shared<CFailingDataSink>(FailAfter);
-        CXMLWriter Writer(DataSink);
+    SXMLEntity Complete;
+    Complete.DType = SXMLEntity::EType::CompleteElement;
+    Complete.DNameData = "tag";
+    Complete.SetAttribute("a", "b");
 
-        SXMLEntity Complete;
-        Complete.DType = SXMLEntity::EType::CompleteElement;
-        Complete.DNameData = "tag";
-        Complete.SetAttribute("a", "b");
+    auto FailingSink = std::make_shared<CFailingDataSink>(0);
+    CXMLWriter FailingWriter(FailingSink);
+    EXPECT_FALSE(FailingWriter.WriteEntity(Complete));
 
-        EXPECT_FALSE(Writer.WriteEntity(Complete));
-    }
+    auto DataSink = std::make_shared<CFailingDataSink>(1);
+    CXMLWriter Writer(DataSink);
+    EXPECT_TRUE(Writer.WriteEntity(Complete));
+    EXPECT_EQ(DataSink->String(), "<tag a=\"b\"/>");
 }
 
 TEST(XMLWriter, EndTagFailurePaths)
 {
-    for (int FailAfter = 3; FailAfter <= 5; FailAfter++)
-    {
-        auto DataSink = std::make_shared<CFailingDataSink>(FailAfter);
-        CXMLWriter Writer(DataSink);
+    // the start tag is the only write that succeeds
+    auto DataSink = std::make_shared<CFailingDataSink>(1);
+    CXMLWriter Writer(DataSink);
 
-        SXMLEntity Start;
-        Start.DType = SXMLEntity::EType::StartElement;
-        Start.DNameData = "tag";
+    SXMLEntity Start;
+    Start.DType = SXMLEntity::EType::StartElement;
+    Start.DNameData = "tag";
 
-        SXMLEntity End;
-        End.DType = SXMLEntity::EType::EndElement;
-        End.DNameData = "tag";
+    SXMLEntity End;
+    End.DType = SXMLEntity::EType::EndElement;
+    End.DNameData = "tag";
 
-        ASSERT_TRUE(Writer.WriteEntity(Start));
-        EXPECT_FALSE(Writer.WriteEntity(End));
-    }
+    ASSERT_TRUE(Writer.WriteEntity(Start));
+    EXPECT_FALSE(Writer.WriteEntity(End));
+    EXPECT_FALSE(Writer.Flush());
+    EXPECT_EQ(DataSink->String(), "<tag>");
 }
 
 TEST(XMLWriter, EndElementWithoutStart)
@@ -336,7 +680,7 @@ TEST(XMLWriter, UnknownType)
 
 TEST(XMLWriter, FailingSinkStartTag)
 {
-    auto DataSink = std::make_shared<CFailingDataSink>(1);
+    auto DataSink = std::make_shared<CFailingDataSink>(0);
     CXMLWriter Writer(DataSink);
 
     SXMLEntity Start;
@@ -348,7 +692,7 @@ TEST(XMLWriter, FailingSinkStartTag)
 
 TEST(XMLWriter, FailingSinkCompleteTag)
 {
-    auto DataSink = std::make_shared<CFailingDataSink>(1);
+    auto DataSink = std::make_shared<CFailingDataSink>(0);
     CXMLWriter Writer(DataSink);
 
     SXMLEntity Complete;
@@ -360,7 +704,7 @@ TEST(XMLWriter, FailingSinkCompleteTag)
 
 TEST(XMLWriter, FailingSinkEndTag)
 {
-    auto DataSink = std::make_shared<CFailingDataSink>(3);
+    auto DataSink = std::make_shared<CFailingDataSink>(1);
     CXMLWriter Writer(DataSink);
 
     SXMLEntity Start;
@@ -375,6 +719,173 @@ TEST(XMLWriter, FailingSinkEndTag)
     EXPECT_FALSE(Writer.WriteEntity(End));
 }
 
+TEST(XMLWriter, EscapingRuns)
+{
+    auto DataSink = std::make_shared<CStringDataSink>();
+    CXMLWriter Writer(DataSink);
+
+    std::string Clean(100, 'x');
+    SXMLEntity Text;
+    Text.DType = SXMLEntity::EType::CharData;
+    Text.DNameData = "&" + Clean + "<>" + Clean + "\"'>";
+    SXMLEntity Complete;
+    Complete.DType = SXMLEntity::EType::CompleteElement;
+    Complete.DNameData = "tag";
+    Complete.SetAttribute("a", "<<" + Clean + "'");
+    Complete.SetAttribute("b", "");
+
+    EXPECT_TRUE(Writer.WriteEntity(Text));
+    EXPECT_TRUE(Writer.WriteEntity(Complete));
+    EXPECT_EQ(DataSink->String(), "&amp;" + Clean + "&lt;&gt;" + Clean + "\"'&gt;" +
+                                      "<tag a=\"&lt;&lt;" + Clean + "&apos;\" b=\"\"/>");
+}
+
+TEST(XMLWriter, BatchedWrite)
+{
+    auto DataSink = std::make_shared<CFailingDataSink>(-1);
+    {
+        CXMLWriter Writer(DataSink, 16);
+        SXMLEntity Start{SXMLEntity::EType::StartElement, "root", {}};
+        SXMLEntity Text{SXMLEntity::EType::CharData, "0123456789", {}};
+
+        // held until 16 bytes are pending, then handed over in one write
+        EXPECT_TRUE(Writer.WriteEntity(Start));
+        EXPECT_EQ(DataSink->String(), "");
+        EXPECT_TRUE(Writer.WriteEntity(Text));
+        EXPECT_EQ(DataSink->String(), "<root>0123456789");
+        EXPECT_TRUE(Writer.WriteEntity(Text));
+        EXPECT_EQ(DataSink->String(), "<root>0123456789");
+        EXPECT_TRUE(Writer.Flush());
+        EXPECT_EQ(DataSink->String(), "<root>01234567890123456789</root>");
+
+        // anything pending is written when the writer goes away
+        EXPECT_TRUE(Writer.WriteEntity(Text));
+    }
+    EXPECT_EQ(DataSink->String(), "<root>01234567890123456789</root>0123456789");
+
+    // a failing sink is reported once the batch is handed over
+    auto FailingSink = std::make_shared<CFailingDataSink>(0);
+    CXMLWriter Writer(FailingSink, 1024);
+    EXPECT_TRUE(Writer.WriteEntity(SXMLEntity{SXMLEntity::EType::StartElement, "root", {}}));
+    EXPECT_FALSE(Writer.Flush());
+}
+
+TEST(XMLWriter, IndentedOutput)
+{
+    auto DataSink = std::make_shared<CStringDataSink>();
+    CXMLWriter Writer(DataSink, 0, CXMLWriter::EFormat::Indented);
+
+    EXPECT_EQ(Writer.Depth(), 0);
+    EXPECT_TRUE(Writer.WriteEntity(SXMLEntity{SXMLEntity::EType::StartElement, "root", {{"id", "1"}}}));
+    EXPECT_TRUE(Writer.WriteEntity(SXMLEntity{SXMLEntity::EType::StartElement, "leaf", {}}));
+    EXPECT_EQ(Writer.Depth(), 2);
+    EXPECT_TRUE(Writer.WriteEntity(SXMLEntity{SXMLEntity::EType::CharData, "text", {}}));
+    EXPECT_TRUE(Writer.WriteEntity(SXMLEntity{SXMLEntity::EType::EndElement, "leaf", {}}));
+    EXPECT_TRUE(Writer.WriteEntity(SXMLEntity{SXMLEntity::EType::StartElement, "empty", {}}));
+    EXPECT_TRUE(Writer.WriteEntity(SXMLEntity{SXMLEntity::EType::EndElement, "empty", {}}));
+    EXPECT_TRUE(Writer.WriteEntity(SXMLEntity{SXMLEntity::EType::CompleteElement, "complete", {}}));
+    EXPECT_TRUE(Writer.WriteEntity(SXMLEntity{SXMLEntity::EType::StartElement, "lines", {}}));
+    EXPECT_TRUE(Writer.WriteEntity(SXMLEntity{SXMLEntity::EType::CharData, "\n    a\n    b", {}}));
+    EXPECT_TRUE(Writer.WriteEntity(SXMLEntity{SXMLEntity::EType::EndElement, "lines", {}}));
+    EXPECT_TRUE(Writer.WriteEntity(SXMLEntity{SXMLEntity::EType::StartElement, "open", {}}));
+    EXPECT_TRUE(Writer.WriteEntity(SXMLEntity{SXMLEntity::EType::CompleteElement, "child", {}}));
+    EXPECT_TRUE(Writer.Flush());
+    EXPECT_EQ(Writer.Depth(), 0);
+
+    EXPECT_EQ(DataSink->String(),   "<root id=\"1\">\n"
+                                    "  <leaf>text</leaf>\n"
+                                    "  <empty></empty>\n"
+                                    "  <complete/>\n"
+                                    "  <lines>\n"
+                                    "    a\n"
+                                    "    b\n"
+                                    "  </lines>\n"
+                                    "  <open>\n"
+                                    "    <child/>\n"
+                                    "  </open>\n"
+                                    "</root>");
+}
+
+TEST(XMLWriter, IndentWidth)
+{
+    auto DataSink = std::make_shared<CStringDataSink>();
+    CXMLWriter Writer(DataSink, 0, CXMLWriter::EFormat::Indented, 4);
+
+    EXPECT_TRUE(Writer.WriteEntity(SXMLEntity{SXMLEntity::EType::StartElement, "a", {}}));
+    EXPECT_TRUE(Writer.WriteEntity(SXMLEntity{SXMLEntity::EType::StartElement, "b", {}}));
+    EXPECT_TRUE(Writer.WriteEntity(SXMLEntity{SXMLEntity::EType::StartElement, "c", {}}));
+    EXPECT_TRUE(Writer.WriteEntity(SXMLEntity{SXMLEntity::EType::CompleteElement, "d", {}}));
+    EXPECT_TRUE(Writer.Flush());
+    EXPECT_EQ(DataSink->String(), "<a>\n    <b>\n        <c>\n            <d/>\n        </c>\n    </b>\n</a>");
+}
+
+TEST(XMLWriter, MinifiedOutput)
+{
+    auto DataSink = std::make_shared<CStringDataSink>();
+    CXMLWriter Writer(DataSink, 0, CXMLWriter::EFormat::Minified);
+
+    EXPECT_TRUE(Writer.WriteEntity(SXMLEntity{SXMLEntity::EType::StartElement, "root", {{"id", "1"}}}));
+    EXPECT_TRUE(Writer.WriteEntity(SXMLEntity{SXMLEntity::EType::StartElement, "leaf", {}}));
+    EXPECT_TRUE(Writer.WriteEntity(SXMLEntity{SXMLEntity::EType::CharData, "a b", {}}));
+    EXPECT_TRUE(Writer.WriteEntity(SXMLEntity{SXMLEntity::EType::EndElement, "leaf", {}}));
+    EXPECT_TRUE(Writer.WriteEntity(SXMLEntity{SXMLEntity::EType::StartElement, "lines", {}}));
+    EXPECT_TRUE(Writer.WriteEntity(SXMLEntity{SXMLEntity::EType::CharData, "a\nb", {}}));
+    EXPECT_TRUE(Writer.WriteEntity(SXMLEntity{SXMLEntity::EType::EndElement, "lines", {}}));
+    EXPECT_TRUE(Writer.WriteEntity(SXMLEntity{SXMLEntity::EType::CompleteElement, "complete", {}}));
+    EXPECT_TRUE(Writer.Flush());
+    EXPECT_EQ(DataSink->String(), "<root id=\"1\"><leaf>a b</leaf><lines>a\nb</lines><complete/></root>");
+}
+
+TEST(XMLWriter, MinifiedDropsWhitespace)
+{
+    std::vector<SXMLEntity> Entities = {
+        SXMLEntity{SXMLEntity::EType::StartElement, "root", {}},
+        SXMLEntity{SXMLEntity::EType::CharData, "\n  ", {}},
+        SXMLEntity{SXMLEntity::EType::StartElement, "leaf", {}},
+        SXMLEntity{SXMLEntity::EType::CharData, " a ", {}},
+        SXMLEntity{SXMLEntity::EType::EndElement, "leaf", {}},
+        SXMLEntity{SXMLEntity::EType::CharData, "\n\t \r\n", {}},
+        SXMLEntity{SXMLEntity::EType::CompleteElement, "complete", {}},
+        SXMLEntity{SXMLEntity::EType::CharData, "\n", {}},
+        SXMLEntity{SXMLEntity::EType::EndElement, "root", {}}
+    };
+    auto RawSink = std::make_shared<CStringDataSink>();
+    auto MinifiedSink = std::make_shared<CStringDataSink>();
+    CXMLWriter RawWriter(RawSink, 0, CXMLWriter::EFormat::Raw);
+    CXMLWriter MinifiedWriter(MinifiedSink, 0, CXMLWriter::EFormat::Minified);
+    for (auto &Entity : Entities)
+    {
+        EXPECT_TRUE(RawWriter.WriteEntity(Entity));
+        EXPECT_TRUE(MinifiedWriter.WriteEntity(Entity));
+    }
+    EXPECT_TRUE(RawWriter.Flush());
+    EXPECT_TRUE(MinifiedWriter.Flush());
+    EXPECT_EQ(RawSink->String(), "<root>\n  <leaf> a </leaf>\n\t \r\n<complete/>\n</root>");
+    EXPECT_EQ(MinifiedSink->String(), "<root><leaf> a </leaf><complete/></root>");
+}
+
+TEST(XMLWriter, ParsedWhitespaceRoundTrip)
+{
+    std::string Input = "<a>\n  <b x=\"1\">t</b>\n  <c> </c>\n  <d>x\n  </d>\n  <e>\n</e>\n</a>";
+    auto Rewrite = [&](CXMLWriter::EFormat format) {
+        CXMLReader Reader(std::make_shared<CStringDataSource>(Input));
+        auto DataSink = std::make_shared<CStringDataSink>();
+        CXMLWriter Writer(DataSink, 0, format);
+        SXMLEntity Entity;
+        while (Reader.ReadEntity(Entity))
+        {
+            EXPECT_TRUE(Writer.WriteEntity(Entity));
+        }
+        EXPECT_TRUE(Writer.Flush());
+        return DataSink->String();
+    };
+    EXPECT_EQ(Rewrite(CXMLWriter::EFormat::Raw), Input);
+    // whitespace between elements gives way to the writer's layout, the text
+    // of <c>, <d> and <e> stays
+    EXPECT_EQ(Rewrite(CXMLWriter::EFormat::Minified), "<a><b x=\"1\">t</b><c> </c><d>x\n  </d><e>\n</e></a>");
+    EXPECT_EQ(Rewrite(CXMLWriter::EFormat::Indented), "<a>\n  <b x=\"1\">t</b>\n  <c> </c>\n  <d>x\n  \n  </d>\n  <e>\n\n  </e>\n</a>");
+}
+
 TEST(XMLEntity, AttributeHelpers)
 {
     SXMLEntity Entity;